@@ -0,0 +1,46 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "linear_program.hpp"
+
+struct Item;
+struct Recipe;
+
+/// @brief Rank alternate recipes by how much they change the optimal production of some items.
+/// Locked alternates are scored by what unlocking them would save, unlocked ones by what would be
+/// lost without them. All solves start from the previous optimal basis of the same program
+namespace AlternateRanking
+{
+    struct Entry
+    {
+        const Recipe* recipe = nullptr;
+        /// @brief True if the recipe is currently usable
+        bool unlocked = false;
+        /// @brief True if the targets can't be produced without this recipe (only for unlocked recipes)
+        bool required = false;
+        /// @brief Raw resources (items/min) saved by having this recipe, with a raw resources objective
+        double raw_saved = 0.0;
+        /// @brief Power (MW) saved by having this recipe, with a power objective
+        double power_saved = 0.0;
+    };
+
+    struct Result
+    {
+        /// @brief Status of the solve with the current usable recipes, entries are empty if it's not Optimal
+        LinearProgram::Status status = LinearProgram::Status::Infeasible;
+        /// @brief Minimal raw resources (items/min) and power (MW) with the current usable recipes
+        double raw = 0.0;
+        double power = 0.0;
+        /// @brief One entry per alternate, with the biggest raw savings first
+        std::vector<Entry> entries;
+    };
+
+    /// @brief Evaluate all alternates in parallel
+    /// @param usable Currently usable recipes, alternates included
+    /// @param alternates All alternates to rank, either usable or not
+    /// @param targets Rate of each item to produce, in items/min
+    /// @return Impact of each alternate
+    Result Rank(const std::vector<const Recipe*>& usable, const std::vector<const Recipe*>& alternates, const std::vector<std::pair<const Item*, double>>& targets);
+}
@@ -1,15 +1,32 @@
 #pragma once
 
 #include <chrono>
+#include <future>
 #include <map>
 #include <memory>
 #include <queue>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include <imgui_node_editor.h>
 
+#include "alternate_ranking.hpp"
+#include "clock_optimizer.hpp"
+#include "fractional_number.hpp"
+#include "ledger.hpp"
+#include "production_optimizer.hpp"
+#include "rate_propagation.hpp"
+#include "recipe_graph.hpp"
+#include "somersloop_optimizer.hpp"
+#include "texture_manager.hpp"
+#include "utils.hpp"
+
+class DataWatcher;
+struct Building;
+struct CraftNode;
+struct Item;
 struct Link;
 struct Node;
 struct Pin;
@@ -28,6 +45,9 @@ public:
 
     bool HasRecentInteraction() const;
 
+    /// @brief Used in saved files to track when format change. Used to update files saved with previous versions
+    static constexpr int SAVE_VERSION = 3;
+
 private:
     /// @brief Load saved session if present
     void LoadSession();
@@ -35,13 +55,24 @@ private:
     void LoadSettings();
     void SaveSettings() const;
 
+    /// @brief Check if a recipe can be used given the current settings (unlocked alts, spoilers)
+    bool IsRecipeUsable(const Recipe* recipe) const;
+
+    /// @brief Recompute raw_costs and flag the optimizer program for rebuild,
+    /// must be called whenever the set of usable recipes changes (unlocked alts, spoilers)
+    void UpdateRawCosts();
+
+    /// @brief Get all craft nodes with a recipe, including the ones inside groups
+    std::vector<const CraftNode*> GetAllCraftNodes() const;
+
     /// @brief Serialize the app state to a string
     /// @return Serialized state of this app
     std::string Serialize() const;
 
     /// @brief Restore app state from a string
     /// @param s Serialized app state to load
-    void Deserialize(const std::string& s);
+    /// @param switch_game If true, switch to the game data the state was saved with when it's available
+    void Deserialize(const std::string& s, const bool switch_game = true);
 
     /// @brief Get the next available id for node-editor
     /// @return The next id to use
@@ -74,12 +105,42 @@ private:
     /// @brief Copy the position from the graph into the nodes struct
     void PullNodesPosition();
 
+    /// @brief Replace the game data with a modified version of the data file. Nodes using a changed recipe
+    /// or item are rebuilt and their rates updated, everything else keeps pointing to the same data
+    /// @param data Parsed content of the modified data file
+    void ReloadGameData(const Json::Value& data);
+
+    /// @brief Switch to the data of another game. Nodes are not modified and still use the previous data
+    /// @param game Name of the game data to use, as listed by Data::AvailableGames
+    /// @return False if the data can't be loaded, the current data is kept
+    bool SetGameData(const std::string& game);
+
+    /// @brief Get the unlocked state of all alternate recipes by name, to restore it after the data changed
+    std::map<std::string, bool> UnlockedAltsByName() const;
+
+    /// @brief Point everything but the nodes to the current data, and reset all results computed with the previous one
+    /// @param unlocked_alts Unlocked state of the alternate recipes, by name
+    void RebindGameData(const std::map<std::string, bool>& unlocked_alts);
+
     /// @brief Bundle all selected nodes by a group node
     void GroupSelectedNodes();
 
     /// @brief Unpack all nodes contained in the currently selected node
     void UngroupSelectedNode();
 
+    /// @brief Compute the number of machines needed for each recipe to produce an item at a given rate,
+    /// expanding all inputs with the cheapest usable recipes
+    /// @param recipe Recipe used to produce the target item
+    /// @param item Target item, must be an output of recipe
+    /// @param rate Target rate, in items/min
+    /// @return Number of machines for each recipe of the chain, target recipe first
+    std::vector<std::pair<const Recipe*, FractionalNumber>> PlanProductionChain(const Recipe* recipe, const Item* item, const FractionalNumber& rate) const;
+
+    /// @brief Create all nodes and links of a production chain at once, with consistent rates and no propagation
+    /// @param chain Number of machines for each recipe
+    /// @param position Position of the most downstream nodes, inputs are placed on the left
+    void BuildProductionChain(const std::vector<std::pair<const Recipe*, FractionalNumber>>& chain, const ImVec2& position);
+
 
     /// @brief Render the panel on the left with global info (inputs/outputs/etc...)
     void RenderLeftPanel();
@@ -95,15 +156,24 @@ private:
     void AddNewNode();
     /// @brief Tooltips in the graph view are rendered in a second pass after everything else. Otherwise they are not at the right place
     void RenderTooltips();
+    /// @brief Render the production optimizer targets, caps and solution in the left panel
+    void RenderOptimizer();
+    /// @brief Render the machines/clocks/power shards optimizer of the current graph in the left panel
+    void RenderClockOptimizer();
+    /// @brief Render the somersloops allocation optimizer of the current graph in the left panel
+    void RenderSomersloopOptimizer();
+    /// @brief Render the alternate recipes ranking in the left panel, and start a new ranking in the background if it's outdated
+    void RenderAlternateRanking();
     /// @brief Display a popup centered in the screen with all controls
     void RenderControlsPopup();
+    /// @brief Display a tooltip with the raw cost of one unit of an item, using the cheapest usable recipes
+    void RenderRawCostTooltip(const Item* item) const;
+    /// @brief Display a tooltip with the raw cost of one unit of each output of a recipe
+    void RenderRawCostTooltip(const Recipe* recipe) const;
     /// @brief React to app-specific key pressed
     void CustomKeyControl();
 
 private:
-    /// @brief Used in saved files to track when format change. Used to update files saved with previous versions
-    static constexpr int SAVE_VERSION = 3;
-
     /// @brief Window id used for the Add Node popup
     static constexpr std::string_view add_node_popup_id = "Add Node";
     /// @brief Folder to save/load the serialized graph
@@ -124,8 +194,90 @@ private:
         /// @brief If true, will display power info with equal clocks on all machines in a node
         /// If false, it will compute the power for N machines at 100% + an underclocked machine
         bool power_equal_clocks = true;
+        /// @brief GPU memory the icons should stay under, in MB
+        int texture_budget_mb = 64;
     } settings;
 
+    /// @brief Cached cheapest raw cost for each item, given the current settings
+    std::unordered_map<const Item*, RawCost> raw_costs;
+
+    /// @brief Production optimizer and its inputs as edited in the left panel
+    struct Optimizer {
+        ProductionOptimizer solver;
+        ProductionOptimizer::Objective objective = ProductionOptimizer::Objective::RawResources;
+        /// @brief Items to produce and their rate as typed by the user
+        std::vector<std::pair<const Item*, std::string>> targets;
+        /// @brief Raw items with a max extraction rate
+        std::vector<std::pair<const Item*, std::string>> caps;
+        /// @brief All items that can be a target, sorted by name
+        std::vector<const Item*> craftable_items;
+        /// @brief If true, the program needs to be rebuilt before solving
+        bool recipes_changed = true;
+        /// @brief If true, targets/caps/objective changed since last solve
+        bool dirty = false;
+        /// @brief If true, the solution will be added to the graph view during next frame
+        bool build_requested = false;
+        bool invalid_rate = false;
+        ProductionOptimizer::Result result;
+    } optimizer;
+
+    /// @brief Machines, clocks and power shards optimizer of the craft nodes currently in the graph
+    struct ClockOptimizerState {
+        ClockOptimizer::Objective objective = ClockOptimizer::Objective::Power;
+        /// @brief Machines allowed on top of the current number of machines
+        int extra_machines = 0;
+        bool limit_shards = false;
+        int shard_budget = 0;
+        /// @brief Recipe of each optimized node, in the same order as result setups
+        std::vector<const Recipe*> recipes;
+        /// @brief Power of the optimized nodes when the optimization was run, with equal clocks
+        double current_power = 0.0;
+        int current_machines = 0;
+        bool has_result = false;
+        ClockOptimizer::Result result;
+    } clock_optimizer;
+
+    /// @brief Somersloops allocation optimizer of the craft nodes currently in the graph
+    struct SomersloopOptimizerState {
+        SomersloopOptimizer::Objective objective = SomersloopOptimizer::Objective::RawResources;
+        /// @brief Item to maximize for SomersloopOptimizer::Objective::Item
+        const Item* target = nullptr;
+        int budget = 0;
+        /// @brief Recipe of each optimized node, in the same order as result
+        std::vector<const Recipe*> recipes;
+        /// @brief Somersloops of each optimized node when the optimization was run
+        std::vector<int> current;
+        bool has_result = false;
+        SomersloopOptimizer::Result result;
+    } somersloop_optimizer;
+
+    /// @brief Background ranking of all alternates by their impact on the current factory outputs or on all saved files
+    struct AlternateRankingState {
+        enum class Scope { Factory, SavedFiles };
+        /// @brief Everything a ranking depends on, the cached result is valid as long as these don't change
+        struct Inputs {
+            Scope scope = Scope::Factory;
+            /// @brief Incremented each time the usable recipes change
+            size_t recipes_version = 0;
+            /// @brief Incremented each time a file is saved or removed
+            size_t saves_version = 0;
+            /// @brief Outputs of the current factory, only for Scope::Factory
+            std::vector<std::pair<const Item*, FractionalNumber>> targets;
+            bool operator==(const Inputs& other) const;
+        };
+        bool enabled = false;
+        bool sort_by_power = false;
+        /// @brief Current inputs, updated every frame
+        Inputs current;
+        /// @brief Inputs of the running ranking
+        Inputs running;
+        /// @brief Inputs of the displayed result
+        Inputs ranked;
+        std::future<AlternateRanking::Result> job;
+        bool has_result = false;
+        AlternateRanking::Result result;
+    } alternate_ranking;
+
     /// @brief All nodes currently in the graph view
     std::vector<std::unique_ptr<Node>> nodes;
     /// @brief All links currently in the graph view
@@ -146,13 +298,28 @@ private:
     ImVec2 new_node_position;
     Pin* new_node_pin;
     std::string recipe_filter;
+    /// @brief If true, selecting a recipe in the add node popup builds its whole production chain
+    bool build_full_chain;
+    /// @brief Target rate of the production chain built from the add node popup
+    std::string chain_rate;
+    /// @brief Recipe index and "match score" to sort them in the add node popup, kept between frames to avoid reallocation
+    std::vector<std::pair<int, size_t>> recipe_indices;
     std::vector<std::string> frame_tooltips;
+    /// @brief Reused to sort pins of each node in the graph view
+    std::vector<size_t> sorted_pin_indices;
+
+    /// @brief Stats displayed in the left panel, kept between frames to avoid reallocation
+    Ledger ledger;
 
-    enum class Constraint { None, Weak, Strong };
     /// @brief All pins which had their value changed and need to propagate updates
     std::queue<std::pair<const Pin*, Constraint>> updating_pins;
+    /// @brief False if the last propagation was stopped before all the rates settled (loops that can't be balanced)
+    bool rates_settled;
+
+    TextureHandle somersloop_icon;
 
-    unsigned int somersloop_texture_id;
+    /// @brief Reload the game data when its file is modified on disk
+    std::unique_ptr<DataWatcher> data_watcher;
 
     std::chrono::steady_clock::time_point last_time_interacted;
 
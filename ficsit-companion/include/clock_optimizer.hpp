@@ -0,0 +1,75 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+
+struct Recipe;
+
+/// @brief Choose the number of machines, their clock speed and power shards for a list of
+/// craft nodes, given global machines and power shards budgets
+namespace ClockOptimizer
+{
+    enum class Objective
+    {
+        Power,
+        Buildings
+    };
+
+    /// @brief One node to optimize
+    struct Task
+    {
+        const Recipe* recipe = nullptr;
+        /// @brief Node rate, as a number of machines at 100%
+        double rate = 0.0;
+        /// @brief Power multiplier due to somersloops in each machine
+        double somersloop_power_factor = 1.0;
+    };
+
+    /// @brief Machines of a node running at the same clock with the same number of shards
+    struct MachineGroup
+    {
+        int count = 0;
+        /// @brief Power shards in each machine
+        int shards = 0;
+        /// @brief Clock of each machine, 1.0 is 100%
+        double clock = 0.0;
+    };
+
+    struct Setup
+    {
+        /// @brief At most two groups, shards are spread as evenly as possible between machines
+        std::vector<MachineGroup> groups;
+        int machines = 0;
+        int shards = 0;
+        /// @brief Power (MW) of all machines
+        double power = 0.0;
+    };
+
+    struct Result
+    {
+        /// @brief False if the budgets are too low for the nodes rate
+        bool feasible = false;
+        /// @brief Setup of each task, in the same order
+        std::vector<Setup> setups;
+        int machines = 0;
+        int shards = 0;
+        double power = 0.0;
+    };
+
+    /// @brief Max clock of a machine with all its shard slots filled
+    constexpr double max_clock = 2.5;
+    /// @brief Max number of shards in one machine
+    constexpr int max_shards = 3;
+
+    /// @brief Find the setup of all tasks minimizing the objective.
+    /// Power is convex in the number of machines of a node, so machines are allocated one at a time
+    /// to the node with the best marginal gain, which is optimal without shards budget.
+    /// When the shards budget is limiting, small problems are solved exactly, others are near-optimal:
+    /// the budget is enforced with a Lagrangian multiplier on the shards and the remaining shards are spent greedily
+    /// @param tasks Nodes to optimize
+    /// @param objective Total power or total number of machines
+    /// @param machine_budget Max number of machines. Required to minimize power (would be unbounded otherwise)
+    /// @param shard_budget Max number of power shards, no limit if not set
+    /// @return Setup of each task
+    Result Optimize(const std::vector<Task>& tasks, const Objective objective, const int machine_budget, const std::optional<int>& shard_budget);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "json.hpp"
+
+/// @brief Watch a game data file and parse it in the background each time it's modified.
+/// Uses inotify on Linux and polls the modification date on other desktop platforms, does nothing for web builds
+class DataWatcher
+{
+public:
+    /// @brief Start watching a file
+    /// @param path Path of the json data file
+    DataWatcher(const std::string& path);
+    ~DataWatcher();
+
+    DataWatcher(const DataWatcher&) = delete;
+    DataWatcher& operator=(const DataWatcher&) = delete;
+
+    /// @brief Get the last modified version of the file, if any since last call
+    /// @return Parsed content of the file, std::nullopt if it didn't change or wasn't valid json
+    std::optional<Json::Value> TakeChange();
+
+private:
+    /// @brief Background loop, wait for the file to be modified and parse it
+    void Watch();
+    /// @brief Read and parse the file if its content changed since last time
+    void ReadFile();
+
+    const std::string path;
+    /// @brief Last read content, editors can trigger several events for the same save
+    std::string content;
+
+    std::mutex mutex;
+    std::optional<Json::Value> change;
+
+    std::atomic<bool> stop;
+    std::thread thread;
+};
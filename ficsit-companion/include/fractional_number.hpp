@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <optional>
 
 class FractionalNumber
@@ -9,6 +10,11 @@ public:
     FractionalNumber(const long long int n = 0, const long long int d = 1);
     FractionalNumber(const std::string& s);
 
+    /// @brief Exact conversion of a decimal literal ("-12.5", "0.25", "1.5e3"...) without going through a double
+    /// @param literal Decimal number, as written in a json file
+    /// @return The fraction, will throw a std::domain_error if the literal is unvalid or doesn't fit in 64 bits
+    static FractionalNumber FromDecimal(std::string_view literal);
+
     long long int GetNumerator() const;
     long long int GetDenominator() const;
     double GetValue() const;
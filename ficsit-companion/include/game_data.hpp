@@ -8,22 +8,72 @@
 struct Building;
 struct Item;
 struct Recipe;
+class RecipeGraph;
+class SearchIndex;
+
+namespace Json
+{
+    class Value;
+}
 
 namespace Data
 {
-    /// @brief Load data (recipes, items...) for a given game
+    /// @brief Items, buildings and recipes removed from the current data by ReloadData
+    struct ReplacedData
+    {
+        std::unordered_map<std::string, std::shared_ptr<Item>> items;
+        std::unordered_map<std::string, std::shared_ptr<Building>> buildings;
+        std::vector<std::shared_ptr<Recipe>> recipes;
+
+        /// @brief Names of the items, buildings and recipes that didn't exist in the previous data
+        std::vector<std::string> added_items;
+        std::vector<std::string> added_buildings;
+        std::vector<std::string> added_recipes;
+
+        /// @brief Check if the new data is identical to the previous one
+        bool Empty() const;
+    };
+
+    /// @brief Load data (recipes, items...) for a given game and make it the current data. Each game is only loaded once,
+    /// loading it again just switches back to it. Entries identical in several games are shared between them
     /// @param game The game name to load (it should match an existing game.json data file)
-    void LoadData(const std::string& game);
+    /// @param load_icons If false, items icons are not loaded (no graphics context required)
+    void LoadData(const std::string& game, const bool load_icons = true);
 
-    /// @brief Get the version of the loaded data
+    /// @brief Replace the current data with a new version. Items, buildings and recipes identical to
+    /// the loaded ones are kept as is, so pointers to them stay valid
+    /// @param data Parsed json data file
+    /// @param load_icons If false, items icons are not loaded (no graphics context required)
+    /// @return Objects that were changed or removed, still alive so pointers to them can be rebound by name,
+    /// and names of the added ones.
+    /// If data is unvalid, the loaded data is left untouched and the exception is rethrown
+    ReplacedData ReloadData(const Json::Value& data, const bool load_icons = true);
+
+    /// @brief Release all loaded data, the current data is empty until the next LoadData.
+    /// Items release their icon, so this must be called while the graphics context still exists
+    void Unload();
+
+    /// @brief List the games that can be loaded: the base game and all data files in the datasets folder (modded or older versions)
+    std::vector<std::string> AvailableGames();
+
+    /// @brief Get the name of the current game
+    const std::string& Game();
+
+    /// @brief Get the version of the current data
     const std::string& Version();
 
     /// @brief Get all known items
-    const std::unordered_map<std::string, std::unique_ptr<Item>>& Items();
+    const std::unordered_map<std::string, std::shared_ptr<Item>>& Items();
 
     /// @brief Get all known buildings
-    const std::unordered_map<std::string, std::unique_ptr<Building>>& Buildings();
+    const std::unordered_map<std::string, std::shared_ptr<Building>>& Buildings();
 
     /// @brief Get all known recipes
-    const std::vector<std::unique_ptr<Recipe>>& Recipes();
+    const std::vector<std::shared_ptr<Recipe>>& Recipes();
+
+    /// @brief Get the search index built over all known recipes
+    const SearchIndex& RecipeSearchIndex();
+
+    /// @brief Get the item <--> recipe graph built over all known recipes
+    const RecipeGraph& Graph();
 }
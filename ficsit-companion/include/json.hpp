@@ -1,8 +1,11 @@
 #pragma once
 
 #include <array>
+#include <functional>
+#include <iosfwd>
 #include <map>
 #include <memory>
+#include <new>
 #include <stdexcept>
 #include <string>
 #include <string_view>
@@ -12,8 +15,117 @@
 
 namespace Json
 {
+    /// @brief Monotonic memory pool for Json objects and arrays. Memory is only given back when the arena is
+    /// destroyed, all at once, so building or parsing a document doesn't do one allocation per container
+    class Arena
+    {
+    public:
+        /// @param block_size size of the first memory block, the next ones are bigger
+        Arena(const size_t block_size = 64 * 1024);
+        ~Arena();
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        void* Allocate(const size_t size, const size_t alignment);
+
+        /// @brief Get the total size of the memory blocks reserved by this arena
+        size_t GetReservedBytes() const;
+
+        /// @brief Get the arena used by the Json allocations of this thread, nullptr if none
+        static Arena* Current();
+
+        /// @brief While a Scope is alive, all objects and arrays created by this thread (parsed, built or copied)
+        /// are allocated in the arena, and must not outlive it. Scopes can be nested
+        class Scope
+        {
+        public:
+            Scope(Arena& arena);
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            Arena* previous;
+        };
+
+    private:
+        std::vector<std::unique_ptr<char[]>> blocks;
+        size_t next_block_size;
+        size_t reserved;
+        char* cursor;
+        size_t remaining;
+    };
+
     namespace Internal
     {
+        /// @brief Allocator using the current Arena when the container is created, or the heap if there is none.
+        /// Copies go to the arena current at the time of the copy, moves keep their memory where it is
+        /// @tparam T Allocated type
+        template<typename T>
+        class ArenaAllocator
+        {
+        public:
+            using value_type = T;
+            using propagate_on_container_copy_assignment = std::false_type;
+            using propagate_on_container_move_assignment = std::true_type;
+            using propagate_on_container_swap = std::true_type;
+            using is_always_equal = std::false_type;
+
+            ArenaAllocator() noexcept : arena(Arena::Current())
+            {
+
+            }
+
+            template<typename U>
+            ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena)
+            {
+
+            }
+
+            T* allocate(const size_t n)
+            {
+                if (arena == nullptr)
+                {
+                    return std::allocator<T>().allocate(n);
+                }
+                return static_cast<T*>(arena->Allocate(n * sizeof(T), alignof(T)));
+            }
+
+            void deallocate(T* p, const size_t n) noexcept
+            {
+                // Arena memory is released with the arena
+                if (arena == nullptr)
+                {
+                    std::allocator<T>().deallocate(p, n);
+                }
+            }
+
+            ArenaAllocator select_on_container_copy_construction() const noexcept
+            {
+                return ArenaAllocator();
+            }
+
+            template<typename U>
+            bool operator==(const ArenaAllocator<U>& other) const noexcept
+            {
+                return arena == other.arena;
+            }
+
+            template<typename U>
+            bool operator!=(const ArenaAllocator<U>& other) const noexcept
+            {
+                return arena != other.arena;
+            }
+
+        private:
+            template<typename U>
+            friend class ArenaAllocator;
+
+            Arena* arena;
+        };
+
         /// @brief Template magic to have a full type instead of an incomplete one as required by std::variant
         /// @tparam T Any incomplete class we want to wrap
         template<typename T>
@@ -21,52 +133,94 @@ namespace Json
         {
         public:
             RecursiveWrapper() = delete;
-            ~RecursiveWrapper() = default;
 
-            RecursiveWrapper(const RecursiveWrapper& r) noexcept
+            ~RecursiveWrapper()
             {
-                p = std::make_unique<T>(*r.p);
+                Release();
             }
 
-            RecursiveWrapper(RecursiveWrapper&& r) noexcept
+            RecursiveWrapper(const RecursiveWrapper& r) : p(Create(r.get()))
             {
-                p = std::move(r.p);
+
             }
 
-            RecursiveWrapper(const T& r) noexcept
+            RecursiveWrapper(RecursiveWrapper&& r) noexcept : allocator(r.allocator), p(r.p)
             {
-                p = std::make_unique<T>(r);
+                r.p = nullptr;
             }
 
-            RecursiveWrapper(T&& r) noexcept
+            RecursiveWrapper(const T& r) : p(Create(r))
             {
-                p = std::make_unique<T>(std::move(r));
+
+            }
+
+            RecursiveWrapper(T&& r) : p(Create(std::move(r)))
+            {
+
             }
 
             const T& get() const noexcept
             {
-                return *p.get();
+                return *p;
             }
 
             T& get() noexcept
             {
-                return *p.get();
+                return *p;
             }
 
-            RecursiveWrapper& operator=(const RecursiveWrapper& other) noexcept
+            RecursiveWrapper& operator=(const RecursiveWrapper& other)
             {
-                p = std::make_unique<T>(*other.p);
+                if (this != &other)
+                {
+                    T* copy = Create(*other.p);
+                    Release();
+                    p = copy;
+                }
                 return *this;
             }
 
             RecursiveWrapper& operator=(RecursiveWrapper&& other) noexcept
             {
-                p = std::move(other.p);
+                if (this != &other)
+                {
+                    Release();
+                    allocator = other.allocator;
+                    p = other.p;
+                    other.p = nullptr;
+                }
                 return *this;
             }
 
         private:
-            std::unique_ptr<T> p;
+            template<typename U>
+            T* Create(U&& u)
+            {
+                T* ptr = allocator.allocate(1);
+                try
+                {
+                    new (ptr) T(std::forward<U>(u));
+                }
+                catch (...)
+                {
+                    allocator.deallocate(ptr, 1);
+                    throw;
+                }
+                return ptr;
+            }
+
+            void Release() noexcept
+            {
+                if (p != nullptr)
+                {
+                    p->~T();
+                    allocator.deallocate(p, 1);
+                    p = nullptr;
+                }
+            }
+
+            ArenaAllocator<T> allocator;
+            T* p;
         };
     }
 
@@ -76,16 +230,32 @@ namespace Json
 
     namespace Internal
     {
+        class Writer;
+        class ValueBuilder;
+    }
+
+    namespace Internal
+    {
+        /// @brief Non integer number, with its text as written in the parsed string
+        struct Decimal
+        {
+            double value;
+            std::string literal;
+        };
+
         /// @brief std::variant holding the actual data
         using JsonVariant = std::variant<
             std::monostate,
             Internal::RecursiveWrapper<Object>,
             Internal::RecursiveWrapper<Array>,
             std::string,
+            // String of an in situ parsed Document, pointing to its source buffer
+            std::string_view,
             bool,
             long long int,
             unsigned long long int,
-            double
+            double,
+            Decimal
         >;
     }
 
@@ -103,8 +273,19 @@ namespace Json
         Value(Object&& o);
         Value(const Array& a);
         Value(Array&& a);
+        Value(Internal::Decimal&& d);
         Value(const std::initializer_list<Value>& init);
 
+        /// @brief Copies own their strings, even when copying a string view
+        Value(const Value& other);
+        Value(Value&& other) noexcept = default;
+        Value& operator=(const Value& other);
+        Value& operator=(Value&& other) noexcept = default;
+
+        /// @brief Create a string Value referencing s instead of copying it. s must outlive
+        /// this Value and everything moved from it, copies own their string
+        static Value StringView(const std::string_view s);
+
         // Add support for any std::vector<T>, std::deque<T>, std::list<T> etc... when T is compatible with Value
         template<
             template<typename, typename> class C,
@@ -175,11 +356,18 @@ namespace Json
 
         Object& get_object();
         Array& get_array();
+        /// @brief Only works for owned strings, use get_string_view to read strings of in situ parsed Documents
         std::string& get_string();
 
+        /// @brief Get the text of a number. Exact for integers and for numbers parsed with keep_literals,
+        /// else it's the value with the default std::ostream formatting
+        std::string get_number_literal() const;
+
         const Object& get_object() const;
         const Array& get_array() const;
         const std::string& get_string() const;
+        /// @brief Read any string, owned or in situ
+        std::string_view get_string_view() const;
 
         template<typename T>
         bool is() const;
@@ -192,15 +380,15 @@ namespace Json
         bool is_integer() const;
         bool is_number() const;
 
-        Value& operator[](const std::string& s);
-        const Value& operator[](const std::string& s) const;
+        Value& operator[](const std::string_view s);
+        const Value& operator[](const std::string_view s) const;
 
         Value& operator[](const size_t i);
         const Value& operator[](const size_t i) const;
 
         friend std::istream& operator>>(std::istream& is, Value& v);
 
-        bool contains(const std::string& s) const;
+        bool contains(const std::string_view s) const;
 
         size_t size() const;
         void push_back(const Value& value);
@@ -213,27 +401,113 @@ namespace Json
         /// @return the string representation of this Value
         std::string Dump(const int indent = -1, const char indent_char = ' ') const;
 
+        /// @brief Write the string representation of this Value to a stream,
+        /// without building the whole string in memory first
+        /// @param os output stream
+        /// @param indent number of char (space) for indentation. If -1, no new
+        /// line will be added between values
+        /// @param indent_char char used for indentation
+        void Dump(std::ostream& os, const int indent = -1, const char indent_char = ' ') const;
+
     private:
         /// @brief private dump interface
+        /// @param writer output buffer, with the indentation settings
         /// @param depth_level depth of this Value in the tree
-        /// @param indent number of char (space) for indentation
-        /// @param indent_char char used for indentation
-        /// @return the string representation of this Value
-        std::string Dump(const size_t depth_level, const int indent, const char indent_char) const;
+        void Dump(Internal::Writer& writer, const size_t depth_level) const;
 
         Internal::JsonVariant val;
     };
 
     /// @brief Real class declaration, just a derived class of std::vector<Value>
-    class Array : public std::vector<Value>
+    class Array : public std::vector<Value, Internal::ArenaAllocator<Value>>
     {
-        using std::vector<Value>::vector;
+        using std::vector<Value, Internal::ArenaAllocator<Value>>::vector;
     };
 
-    /// @brief Real class declaration, just a derived class of std::map<std::string, Value>
-    class Object : public std::map<std::string, Value>
+    /// @brief Real class declaration, a std::map like interface over a vector of (key, value) sorted by key.
+    /// Most objects only have a few keys, searching them in contiguous memory is faster than walking tree nodes
+    class Object
     {
-        using std::map<std::string, Value>::map;
+    public:
+        using value_type = std::pair<std::string, Value>;
+        using container_type = std::vector<value_type, Internal::ArenaAllocator<value_type>>;
+        /// @brief Keys must not be modified through iterators, it would break the ordering
+        using iterator = container_type::iterator;
+        using const_iterator = container_type::const_iterator;
+
+        Object();
+        /// @brief Same as std::map, only the first value is kept for duplicated keys
+        Object(std::initializer_list<value_type> init);
+
+        /// @brief Get the value of key, inserting a null one if it doesn't exist
+        Value& operator[](const std::string_view key);
+
+        /// @brief Get the value of key, throw std::out_of_range if it doesn't exist
+        Value& at(const std::string_view key);
+        const Value& at(const std::string_view key) const;
+
+        iterator find(const std::string_view key);
+        const_iterator find(const std::string_view key) const;
+        size_t count(const std::string_view key) const;
+        bool contains(const std::string_view key) const;
+
+        /// @brief Insert a (key, value) pair if key isn't already present
+        /// @return Iterator to the element with this key and true if it was inserted
+        std::pair<iterator, bool> insert(const value_type& element);
+        std::pair<iterator, bool> insert(value_type&& element);
+
+        /// @return Number of removed elements (0 or 1)
+        size_t erase(const std::string_view key);
+        iterator erase(const_iterator it);
+
+        void reserve(const size_t n);
+        void clear();
+        size_t size() const;
+        bool empty() const;
+
+        iterator begin();
+        iterator end();
+        const_iterator begin() const;
+        const_iterator end() const;
+        const_iterator cbegin() const;
+        const_iterator cend() const;
+
+    private:
+        /// @brief First element with a key not less than key
+        iterator LowerBound(const std::string_view key);
+        const_iterator LowerBound(const std::string_view key) const;
+
+        container_type elements;
+    };
+
+    /// @brief A root Value with the Arena all its objects and arrays are allocated in.
+    /// Move only, everything is released at once when it's destroyed
+    class Document
+    {
+    public:
+        Document();
+        ~Document();
+
+        Document(const Document&) = delete;
+        Document& operator=(const Document&) = delete;
+
+        Document(Document&& other) noexcept;
+        Document& operator=(Document&& other) noexcept;
+
+        Value& Root();
+        const Value& Root() const;
+
+        /// @brief Arena to use with an Arena::Scope to build values that will be added to this document
+        Arena& GetArena();
+
+    private:
+        friend Document ParseInSitu(std::string&& s, bool no_except, bool keep_literals);
+
+        // Declared before root so they are destroyed after it
+        std::unique_ptr<Arena> arena;
+        /// @brief Parsed text for in situ Documents, its strings point into it
+        std::unique_ptr<const std::string> source;
+        Value root;
     };
 
     /// @brief Parse a string_view from iter for at most length characters
@@ -241,15 +515,112 @@ namespace Json
     /// @param length available number of characters
     /// @param no_except if true, the function will return empty Value
     /// instead of throwing an exception in case of unvalid string
+    /// @param keep_literals if true, non integer numbers also keep their text
+    /// so they can be converted exactly with get_number_literal
     /// @return The parsed Value, will throw a std::runtime_error if unvalid
-    Value Parse(std::string_view::const_iterator iter, size_t length, bool no_except = false);
+    Value Parse(std::string_view::const_iterator iter, size_t length, bool no_except = false, bool keep_literals = false);
 
     /// @brief Parse a std::string
     /// @param s string to parse
     /// @param no_except if true, the function will return empty Value
     /// instead of throwing an exception in case of unvalid string
+    /// @param keep_literals if true, non integer numbers also keep their text
+    /// so they can be converted exactly with get_number_literal
     /// @return The parsed Value, will throw a std::runtime_error if unvalid
-    Value Parse(const std::string& s, bool no_except = false);
+    Value Parse(const std::string& s, bool no_except = false, bool keep_literals = false);
+
+    /// @brief Parse a std::string into a Document, with all objects and arrays in its Arena
+    /// @param s string to parse
+    /// @param no_except if true, the function will return a null Document
+    /// instead of throwing an exception in case of unvalid string
+    /// @param keep_literals if true, non integer numbers also keep their text
+    /// so they can be converted exactly with get_number_literal
+    /// @return The parsed Document, will throw a std::runtime_error if unvalid
+    Document ParseDocument(const std::string& s, bool no_except = false, bool keep_literals = false);
+
+    /// @brief Parse a std::string into a read-only Document, strings without escape sequence are
+    /// views of s instead of copies. The Document keeps s alive
+    /// @param s string to parse, moved into the Document
+    /// @param no_except if true, the function will return a null Document
+    /// instead of throwing an exception in case of unvalid string
+    /// @param keep_literals if true, non integer numbers also keep their text
+    /// so they can be converted exactly with get_number_literal
+    /// @return The parsed Document, will throw a std::runtime_error if unvalid
+    Document ParseInSitu(std::string&& s, bool no_except = false, bool keep_literals = false);
+
+    /// @brief Receive the content of a json string as a stream of events instead of a Value.
+    /// Default implementations ignore the event. Strings are only valid during the call,
+    /// throw an exception to stop the parsing
+    class Handler
+    {
+    public:
+        virtual ~Handler();
+
+        virtual void Null();
+        virtual void Bool(const bool b);
+        virtual void Integer(const long long int i);
+        virtual void Unsigned(const unsigned long long int u);
+        /// @param d parsed value, also used for integers too big for 64 bits
+        /// @param literal text of the number as written in the parsed string
+        virtual void Double(const double d, const std::string_view literal);
+        virtual void String(const std::string_view s);
+        virtual void StartObject();
+        virtual void Key(const std::string_view key);
+        virtual void EndObject();
+        virtual void StartArray();
+        virtual void EndArray();
+    };
+
+    /// @brief Handler building the records of a json object one at a time, each record is sent to
+    /// the callback of its key then released. Records are the elements of the arrays of the root object,
+    /// or the value itself if it's not an array. Memory use is bounded by the biggest record instead of the whole document
+    class RecordHandler : public Handler
+    {
+    public:
+        /// @param keep_literals if true, non integer numbers also keep their text
+        /// so they can be converted exactly with get_number_literal
+        RecordHandler(const bool keep_literals = false);
+        ~RecordHandler();
+
+        /// @brief Set the function called with each record of a key of the root object, other keys are skipped
+        void On(const std::string& key, const std::function<void(const Value&)>& callback);
+
+        void Null() override;
+        void Bool(const bool b) override;
+        void Integer(const long long int i) override;
+        void Unsigned(const unsigned long long int u) override;
+        void Double(const double d, const std::string_view literal) override;
+        void String(const std::string_view s) override;
+        void StartObject() override;
+        void Key(const std::string_view key) override;
+        void EndObject() override;
+        void StartArray() override;
+        void EndArray() override;
+
+    private:
+        /// @brief Check if the next value is a record
+        bool AtRecord() const;
+        /// @brief Start a record if needed
+        /// @return True if the current value is part of a record
+        bool BeginValue();
+        /// @brief Send the current record to its callback if it's complete
+        void EndValue();
+
+        std::map<std::string, std::function<void(const Value&)>, std::less<>> callbacks;
+        /// @brief Callback of the current key of the root object, nullptr if it's skipped
+        const std::function<void(const Value&)>* current;
+        std::unique_ptr<Internal::ValueBuilder> builder;
+        /// @brief Number of objects and arrays currently opened
+        size_t depth;
+        bool in_root_array;
+        bool building;
+    };
+
+    /// @brief Parse a string_view and send its content to a Handler
+    /// @param s string to parse
+    /// @param handler receiver of the parsing events
+    /// Will throw a std::runtime_error if unvalid, after the events of the valid part were sent
+    void Parse(const std::string_view s, Handler& handler);
 
     // Templates implementations, they need to be below
     // Object and Array class so they are not incomplete
@@ -361,6 +732,10 @@ namespace Json
         {
             return static_cast<T>(std::get<double>(val));
         }
+        else if (std::holds_alternative<Internal::Decimal>(val))
+        {
+            return static_cast<T>(std::get<Internal::Decimal>(val).value);
+        }
         else if (std::holds_alternative<long long int>(val))
         {
             return static_cast<T>(std::get<long long int>(val));
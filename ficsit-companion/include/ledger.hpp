@@ -0,0 +1,55 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "fractional_number.hpp"
+#include "utils.hpp"
+
+struct Building;
+struct Item;
+struct Node;
+struct Recipe;
+
+/// @brief A value summed every frame and the one actually displayed. The displayed one is only
+/// assigned when the sum changes so its cached strings are not rebuilt every frame
+struct LedgerEntry
+{
+    FractionalNumber sum;
+    FractionalNumber value;
+};
+
+struct ItemLedger
+{
+    FractionalNumber consumed;
+    FractionalNumber produced;
+    FractionalNumber input;
+    FractionalNumber output;
+    FractionalNumber intermediate;
+};
+
+struct MachineLedger
+{
+    LedgerEntry total;
+    std::map<const Recipe*, LedgerEntry, RecipePtrCompare> recipes;
+};
+
+/// @brief Aggregated stats displayed in the left panel. Kept between frames, entries are never removed
+/// (zero values are just not displayed) so the maps don't need to reallocate their nodes every frame
+struct Ledger
+{
+    /// @brief Sum the stats of all craft and group nodes and update the displayed values
+    /// @param nodes All the nodes of the graph
+    /// @param power_equal_clocks If true, use the power of the nodes with all machines at the same clock
+    /// @return True if some of the machines have a variable power usage
+    bool Update(const std::vector<std::unique_ptr<Node>>& nodes, const bool power_equal_clocks);
+
+    std::map<const Item*, ItemLedger, ItemPtrCompare> items;
+    std::map<const Building*, MachineLedger, BuildingPtrCompare> machines;
+    std::map<const Recipe*, LedgerEntry> detailed_power;
+    LedgerEntry power;
+    /// @brief Non zero detailed power values, highest first
+    std::vector<std::pair<const Recipe*, FractionalNumber*>> sorted_detailed_power;
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/// @brief Minimization linear program min c.x with x >= 0 solved with a tableau simplex.
+/// The last optimal basis is kept so solving again after changing some costs or constraint
+/// right hand sides restarts from it (dual simplex if it became infeasible) instead of from scratch
+class LinearProgram
+{
+public:
+    enum class Relation
+    {
+        LessEqual,
+        GreaterEqual,
+        Equal
+    };
+
+    enum class Status
+    {
+        Optimal,
+        Infeasible,
+        Unbounded,
+        IterationLimit
+    };
+
+    /// @brief Add a new variable (always >= 0). Invalidates the warm start basis
+    /// @param cost Cost of this variable in the objective
+    /// @return Index of the variable
+    size_t AddVariable(const double cost);
+
+    /// @brief Add a new constraint sum(coefficient * variable) relation rhs. Invalidates the warm start basis
+    /// @param coefficients Non zero coefficients, as (variable index, coefficient)
+    /// @param relation Relation between the sum and rhs
+    /// @param rhs Right hand side of the constraint
+    /// @return Index of the constraint
+    size_t AddConstraint(const std::vector<std::pair<size_t, double>>& coefficients, const Relation relation, const double rhs);
+
+    /// @brief Change the cost of a variable, keeps the warm start basis
+    void SetCost(const size_t variable, const double cost);
+
+    /// @brief Change the right hand side of a constraint, keeps the warm start basis
+    void SetRhs(const size_t constraint, const double rhs);
+
+    /// @brief Solve the program, starting from the last optimal basis if possible
+    /// @return Status of the solve. Solution and objective are only valid if Optimal
+    Status Solve();
+
+    /// @brief Value of each variable in the last optimal solution
+    const std::vector<double>& GetSolution() const;
+
+    /// @brief Objective value of the last optimal solution
+    double GetObjective() const;
+
+    /// @brief Number of pivots done during the last Solve call
+    size_t GetNumPivots() const;
+
+private:
+    struct Constraint
+    {
+        std::vector<std::pair<size_t, double>> coefficients;
+        Relation relation;
+        double rhs;
+    };
+
+    /// @brief Dense (rows + 1) x (cols + 2) tableau. Last row is reduced costs, last two columns are
+    /// the rhs used for pivoting (perturbed during cold solves) and the original rhs
+    struct Tableau
+    {
+        size_t rows = 0;
+        size_t cols = 0;
+        std::vector<double> data;
+        std::vector<size_t> basis;
+
+        double& At(const size_t r, const size_t c) { return data[r * (cols + 2) + c]; }
+        double At(const size_t r, const size_t c) const { return data[r * (cols + 2) + c]; }
+        void Pivot(const size_t r, const size_t c);
+    };
+
+    /// @brief Fill the tableau with the constraints, one slack column per inequality, artificial columns are left empty
+    void FillTableau(const size_t num_artificials);
+    /// @brief Set the reduced costs row from the variable costs and the current basis
+    void ComputeReducedCosts();
+    /// @brief Primal simplex iterations on the current tableau, which must be primal feasible
+    /// @param num_allowed_cols Only the first num_allowed_cols columns can enter the basis
+    Status RunPrimal(const size_t num_allowed_cols);
+    /// @brief Dual simplex iterations on the current tableau, which must be dual feasible
+    Status RunDual();
+    /// @brief Two phases primal simplex from the slack/artificial basis, on a perturbed rhs to avoid stalling on degenerate vertices
+    Status SolveCold();
+    /// @brief Replace the pivoting rhs by the original one, and fix the basis if it's not feasible anymore
+    Status RemovePerturbation();
+    /// @brief Restore the last optimal basis and solve from it
+    /// @return false if the basis can't be used anymore and a cold solve is needed
+    bool SolveWarm(Status& status);
+    /// @brief Set the rhs columns (perturbed and original) of the current tableau from the constraints,
+    /// without refactorizing it. Only valid if there is no equality constraint
+    void UpdateTableauRhs();
+    void ExtractSolution();
+
+    std::vector<double> costs;
+    std::vector<Constraint> constraints;
+    /// @brief Number of structural + slack columns
+    size_t num_columns = 0;
+    /// @brief Slack column of each constraint (none for equality)
+    std::vector<size_t> slack_columns;
+
+    Tableau tableau;
+    /// @brief Last optimal basis, empty if none or invalidated
+    std::vector<size_t> warm_basis;
+    std::vector<double> solution;
+    double objective = 0.0;
+    size_t num_pivots = 0;
+    /// @brief Pivots applied on the tableau since it was last built from the constraints
+    size_t pivots_since_factorization = 0;
+};
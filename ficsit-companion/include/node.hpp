@@ -12,6 +12,7 @@
 #include "json.hpp"
 #include "utils.hpp"
 
+struct Building;
 struct Item;
 struct Link;
 struct Pin;
@@ -119,8 +120,8 @@ public:
     std::string name;
     /// @brief Cached value to avoid looping through all the nodes everytime
     bool variable_power;
-    std::map<std::string, FractionalNumber> total_machines;
-    std::map<std::string, std::map<const Recipe*, FractionalNumber>> detailed_machines;
+    std::map<const Building*, FractionalNumber, BuildingPtrCompare> total_machines;
+    std::map<const Building*, std::map<const Recipe*, FractionalNumber>, BuildingPtrCompare> detailed_machines;
     std::map<const Recipe*, FractionalNumber> detailed_power_same_clock;
     std::map<const Recipe*, FractionalNumber> detailed_power_last_underclock;
     std::map<const Item*, FractionalNumber, ItemPtrCompare> inputs;
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "fractional_number.hpp"
+#include "linear_program.hpp"
+
+struct Item;
+struct Recipe;
+
+/// @brief Find the best combination of recipes to produce a set of items, using a linear program
+/// with one variable per recipe (number of machines) and one per raw resource (extracted amount).
+/// The program structure only depends on the usable recipes, targets and caps are right hand sides,
+/// so changing them restarts from the previous optimal basis
+class ProductionOptimizer
+{
+public:
+    enum class Objective
+    {
+        RawResources,
+        Power,
+        Buildings
+    };
+
+    struct Result
+    {
+        LinearProgram::Status status = LinearProgram::Status::Infeasible;
+        /// @brief Number of machines for each recipe used in the solution
+        std::vector<std::pair<const Recipe*, FractionalNumber>> recipes;
+        /// @brief Amount of each raw item extracted, in items/min
+        std::vector<std::pair<const Item*, double>> raw;
+        /// @brief Total raw resources (items/min), power (MW) and machines of the solution
+        double total_raw = 0.0;
+        double power = 0.0;
+        double machines = 0.0;
+        /// @brief Number of simplex pivots needed to get this solution
+        size_t num_pivots = 0;
+    };
+
+    /// @brief Rebuild the program for a new set of usable recipes
+    /// @param recipes All recipes the optimizer can use
+    /// @param switchable Recipes (also in recipes) that can be disabled later without rebuilding the program
+    void SetRecipes(const std::vector<const Recipe*>& recipes, const std::vector<const Recipe*>& switchable = {});
+
+    /// @brief Enable or disable a switchable recipe, keeps the warm start basis
+    /// @param recipe A recipe passed as switchable to SetRecipes
+    /// @param enabled If false, the recipe can't be used in the next solutions
+    void SetRecipeEnabled(const Recipe* recipe, const bool enabled);
+
+    /// @brief Solve the program for some target items
+    /// @param targets Minimal production rate of each target item, in items/min
+    /// @param caps Maximal extraction rate of some raw items, in items/min
+    /// @param objective Value to minimize
+    /// @return The optimal solution, or the reason why there isn't any
+    Result Solve(const std::vector<std::pair<const Item*, double>>& targets, const std::vector<std::pair<const Item*, double>>& caps, const Objective objective);
+
+    /// @brief Get all raw items of the current program, that can be capped
+    const std::vector<const Item*>& RawItems() const;
+
+private:
+    LinearProgram program;
+    std::vector<const Recipe*> recipes;
+    /// @brief Balance constraint index of each item
+    std::unordered_map<const Item*, size_t> item_constraints;
+    std::vector<const Item*> raw_items;
+    /// @brief Extraction variable and cap constraint of each raw item
+    std::vector<size_t> raw_variables;
+    std::vector<size_t> cap_constraints;
+    /// @brief Constraint capping the number of machines of each switchable recipe
+    std::unordered_map<const Recipe*, size_t> switch_constraints;
+};
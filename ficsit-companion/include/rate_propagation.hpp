@@ -0,0 +1,19 @@
+#pragma once
+
+#include <memory>
+#include <queue>
+#include <utility>
+#include <vector>
+
+struct Node;
+struct Pin;
+
+/// @brief How strongly a pin rate has been set during a propagation. Pins set by the user are Strong
+/// and won't be changed by the propagation
+enum class Constraint { None, Weak, Strong };
+
+/// @brief Propagate rates updates from updating_pins through the graph
+/// @param updating_pins All pins which had their value changed and need to propagate updates, empty when returning
+/// @param nodes All the nodes of the graph
+/// @return False if the propagation was stopped before all the rates settled
+bool PropagateRates(std::queue<std::pair<const Pin*, Constraint>>& updating_pins, const std::vector<std::unique_ptr<Node>>& nodes);
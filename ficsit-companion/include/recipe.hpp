@@ -1,6 +1,7 @@
 #pragma once
 
 #include "fractional_number.hpp"
+#include "texture_manager.hpp"
 
 #include <string>
 #include <vector>
@@ -9,10 +10,18 @@ struct Building;
 
 struct Item
 {
-    Item(const std::string& name, const std::string& icon_path);
+    /// @brief Create an item, its icon texture is not loaded if icon_path is empty
+    Item(const std::string& name, const std::string& icon_path, const bool is_resource = false);
+    /// @brief Release the reference to the icon texture
+    ~Item();
+    Item(const Item&) = delete;
+    Item& operator=(const Item&) = delete;
     const std::string name;
     const std::string new_line_name;
-    const unsigned int icon_gl_index;
+    /// @brief Icon in the texture manager, invalid_texture if not loaded
+    const TextureHandle icon;
+    /// @brief True if this item is a raw resource (extracted, not crafted)
+    const bool is_resource;
 };
 
 struct CountedItem
@@ -34,16 +43,6 @@ struct Recipe
         const bool is_spoiler = false
     );
 
-    /// @brief Search for a string in this recipe name, case insensitive
-    /// @param s String to search
-    /// @return The position the string was found in this recipe name, or std::string::npos if not found
-    size_t FindInName(const std::string& s) const;
-
-    /// @brief Search for a string in this recipe ingredients, case insensitive
-    /// @param s String to search
-    /// @return The position the string was found in this recipe ingredients name, or std::string::npos if not found
-    size_t FindInIngredients(const std::string& s) const;
-
     void Render(const bool render_name = true, const bool render_items_icons = true) const;
 
     const std::string name;
@@ -54,8 +53,4 @@ struct Recipe
     const bool alternate;
     const bool is_spoiler;
     const double power;
-
-private:
-    std::string lower_name;
-    std::vector<std::string> lower_ingredients;
 };
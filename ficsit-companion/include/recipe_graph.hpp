@@ -0,0 +1,62 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct Item;
+struct Recipe;
+
+struct RawCost
+{
+    /// @brief Amount of each raw item needed to produce one unit of the item, sorted by raw item name
+    std::vector<std::pair<const Item*, double>> raw;
+    /// @brief Sum of all raw amounts
+    double total = 0.0;
+    /// @brief Power (MW) needed for each item/min produced
+    double power = 0.0;
+    /// @brief Recipe used to get this cost, nullptr for raw items
+    const Recipe* recipe = nullptr;
+};
+
+/// @brief Bipartite item <--> recipe graph, built once when game data are loaded
+class RecipeGraph
+{
+public:
+    /// @brief Build the graph for a list of recipes
+    /// @param recipes All known recipes
+    void Build(const std::vector<std::shared_ptr<Recipe>>& recipes);
+
+    /// @brief Check if an item is a raw resource, either flagged as such or not produced by any recipe
+    bool IsRaw(const Item* item) const;
+
+    /// @brief Get all recipes with this item in their outputs
+    const std::vector<const Recipe*>& Producers(const Item* item) const;
+
+    /// @brief Get all recipes with this item in their inputs
+    const std::vector<const Recipe*>& Consumers(const Item* item) const;
+
+    /// @brief Compute the cheapest raw cost (minimal total raw amount, then minimal power) for all items.
+    /// Byproducts are considered free. Cycles are solved by iterative relaxation inside each strongly connected component.
+    /// @param is_allowed Predicate to filter usable recipes (locked alternates for example)
+    /// @return Cost for each item that can be produced (or is raw)
+    std::unordered_map<const Item*, RawCost> ComputeRawCosts(const std::function<bool(const Recipe*)>& is_allowed) const;
+
+    /// @brief Compute the raw cost of one unit of an item when produced with a given recipe
+    /// @param recipe Recipe used to produce the item
+    /// @param output Item to get the cost of, must be in recipe outputs
+    /// @param costs Costs of all items, as returned by ComputeRawCosts
+    /// @return The cost, or std::nullopt if one of the recipe inputs can't be produced
+    static std::optional<RawCost> RecipeCost(const Recipe* recipe, const Item* output, const std::unordered_map<const Item*, RawCost>& costs);
+
+private:
+    /// @brief All items appearing in at least one recipe, sorted by name
+    std::vector<const Item*> items;
+    std::unordered_map<const Item*, size_t> item_indices;
+    std::vector<std::vector<const Recipe*>> producers;
+    std::vector<std::vector<const Recipe*>> consumers;
+    std::vector<bool> is_raw;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "fractional_number.hpp"
+#include "json.hpp"
+#include "utils.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+struct Building;
+struct Item;
+struct Recipe;
+
+/// @brief Evaluate many "what-if" variations of a saved production graph without the UI.
+/// Each scenario is applied to its own copy of the graph and rates are propagated through
+/// the links exactly as if the user had edited the nodes
+namespace ScenarioSweep
+{
+    /// @brief One edit of a node of the saved graph
+    struct Change
+    {
+        enum class Kind
+        {
+            /// @brief Set the rate of a craft or group node
+            Rate,
+            /// @brief Replace the recipe of a craft node, links are kept on pins with the same item
+            Recipe,
+            /// @brief Set the number of somersloops in each machine of a craft node
+            Somersloop
+        };
+
+        Kind kind = Kind::Rate;
+        /// @brief Index of the node in the save "nodes" list
+        size_t node = 0;
+        FractionalNumber rate;
+        const Recipe* recipe = nullptr;
+        int num_somersloop = 0;
+    };
+
+    struct Scenario
+    {
+        std::string name;
+        /// @brief Edits applied in this order, an empty list evaluates the save as is
+        std::vector<Change> changes;
+    };
+
+    /// @brief Factory totals, items both produced and consumed only count for the difference
+    struct Totals
+    {
+        std::map<const Item*, FractionalNumber, ItemPtrCompare> inputs;
+        std::map<const Item*, FractionalNumber, ItemPtrCompare> outputs;
+        /// @brief Number of machines of each building, as a number of machines at 100%
+        std::map<const Building*, FractionalNumber, BuildingPtrCompare> machines;
+        /// @brief Power (MW) with all machines of a node at the same clock
+        FractionalNumber power;
+    };
+
+    struct Result
+    {
+        std::string name;
+        /// @brief Empty if the scenario was successfully evaluated
+        std::string error;
+        Totals totals;
+    };
+
+    /// @brief Parse scenarios from a json array. Each scenario is an object with a "name" and a list of "changes",
+    /// each change has a "node" index and one of "rate" (number or fraction string), "recipe" (name) or "somersloop" (integer)
+    /// @param json Json array of scenarios
+    /// @return Parsed scenarios, throws std::runtime_error if the file is malformed
+    std::vector<Scenario> ParseScenarios(const Json::Value& json);
+
+    /// @brief Evaluate all scenarios in parallel
+    /// @param save Content of a save file, already updated to the current save version
+    /// @param scenarios Scenarios to evaluate
+    /// @return Totals of each scenario, in the same order. Invalid scenarios have their error set
+    std::vector<Result> Run(const Json::Value& save, const std::vector<Scenario>& scenarios);
+
+    /// @brief Export results as a table, one row per scenario and one column per building, input and output
+    std::string ToCSV(const std::vector<Result>& results);
+
+    /// @brief Export results as a json array, one object per scenario
+    Json::Value ToJson(const std::vector<Result>& results);
+}
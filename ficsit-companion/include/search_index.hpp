@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct Recipe;
+
+/// @brief Prebuilt trigram index over recipe names, ingredient names and building names.
+/// Built once when game data are loaded, queries don't allocate once the scratch buffers are warm.
+class SearchIndex
+{
+public:
+    /// @brief Matches are grouped by tier, each tier is this wide in the score range
+    static constexpr size_t tier_stride = 1 << 24;
+
+    /// @brief Build the index for a list of recipes
+    /// @param recipes Recipes to index, results will be returned as indices in this vector
+    void Build(const std::vector<std::shared_ptr<Recipe>>& recipes);
+
+    /// @brief Search for all recipes matching a query, case insensitive. Results are scored, lower is better:
+    /// exact match in name < exact match in ingredients/building < fuzzy match in name < fuzzy match in ingredients/building.
+    /// Not thread safe as scratch buffers are shared between calls.
+    /// @param query String to search
+    /// @param results Output vector of (recipe index, score), cleared before use. Recipes are not in any particular order
+    void Search(const std::string& query, std::vector<std::pair<int, size_t>>& results) const;
+
+private:
+    /// @brief Add the match score of a term to all recipes containing it
+    void ScoreTerm(const uint32_t term, const size_t score) const;
+
+private:
+    /// @brief All distinct lower case strings indexed
+    std::vector<std::string> terms;
+    /// @brief For each term, whether it's a recipe name or an ingredient/building name
+    std::vector<bool> term_is_name;
+    /// @brief For each term, number of distinct trigrams in it
+    std::vector<uint32_t> term_num_trigrams;
+
+    /// @brief term --> recipes postings, recipes of term i are in term_recipes[term_offsets[i]:term_offsets[i+1]]
+    std::vector<uint32_t> term_offsets;
+    std::vector<int> term_recipes;
+
+    /// @brief trigram --> terms postings, sorted by trigram key
+    std::vector<uint32_t> trigram_keys;
+    std::vector<uint32_t> trigram_offsets;
+    std::vector<uint32_t> trigram_terms;
+
+    /* Scratch buffers reused between queries */
+    mutable std::string lower_query;
+    mutable std::vector<uint32_t> query_trigrams;
+    mutable std::vector<uint32_t> term_hits;
+    mutable std::vector<uint32_t> touched_terms;
+    mutable std::vector<size_t> recipe_scores;
+    mutable std::vector<int> touched_recipes;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+struct Item;
+struct Recipe;
+
+/// @brief Distribute a limited number of somersloops between craft nodes.
+/// Factory outputs are kept constant, so a boosted node needs fewer machines and less inputs,
+/// which reduces the demand on all the nodes upstream of it. Items are pooled: each consumer of
+/// an item is supplied by all its producers (and imports) in proportion to their current share
+namespace SomersloopOptimizer
+{
+    enum class Objective
+    {
+        /// @brief Minimize the weighted amount of items imported in the factory
+        RawResources,
+        /// @brief Minimize the weighted imports used to produce one target item, i.e. maximize
+        /// the target output for the same inputs
+        Item
+    };
+
+    /// @brief One node to optimize
+    struct Task
+    {
+        const Recipe* recipe = nullptr;
+        /// @brief Node rate, as a number of machines at 100%
+        double rate = 0.0;
+        /// @brief Current number of somersloops in each machine
+        int num_somersloop = 0;
+    };
+
+    struct Result
+    {
+        /// @brief Number of somersloops in each machine of each task, in the same order
+        std::vector<int> num_somersloop;
+        /// @brief Number of machines of each task once boosted, as a number of machines at 100%
+        std::vector<double> rates;
+        /// @brief Total number of somersloops used
+        int used = 0;
+        /// @brief Weighted imports (per target item for Objective::Item) with the current somersloops
+        double score_before = 0.0;
+        /// @brief Weighted imports (per target item for Objective::Item) with the new somersloops
+        double score_after = 0.0;
+        /// @brief Power with the current somersloops (MW), all machines of a node at the same clock
+        double power_before = 0.0;
+        /// @brief Power with the new somersloops (MW), all machines of a node at the same clock
+        double power_after = 0.0;
+    };
+
+    /// @brief Greedily add somersloops one machine slot level at a time to the node with the best
+    /// score improvement per somersloop. All candidates of a step are evaluated in parallel
+    /// @param tasks Nodes to optimize
+    /// @param budget Max number of somersloops
+    /// @param objective Score to minimize
+    /// @param target Target item, only used for Objective::Item
+    /// @param import_weight Weight of one imported item/min in the score
+    /// @return New somersloops of each task
+    Result Optimize(const std::vector<Task>& tasks, const int budget, const Objective objective, const Item* target, const std::function<double(const Item*)>& import_weight);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+#include "json.hpp"
+
+/// @brief Record where the time goes from launch to the first fully loaded frame.
+/// Timers and counters can be used from any thread, they are ignored once the startup is finished
+namespace StartupTimeline
+{
+    enum class Counter
+    {
+        FilesRead,
+        BytesRead,
+        /// @brief Size of all json documents parsed
+        BytesParsed,
+        /// @brief Icons decoded from a png file instead of the icon pack
+        IconsDecoded,
+        TexturesUploaded,
+        /// @brief GPU memory used by the icons at the end of the startup
+        TextureBytes,
+        Count
+    };
+
+    /// @brief Record the duration of the enclosing scope as one event of the timeline
+    class ScopedTimer
+    {
+    public:
+        /// @param name Name of the event, must outlive the timeline (string literal)
+        ScopedTimer(const char* name);
+        ~ScopedTimer();
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+        /// @brief End the event before the end of the scope
+        void Stop();
+
+    private:
+        const char* name;
+        const std::chrono::steady_clock::time_point start;
+        bool stopped;
+    };
+
+    /// @brief Add to a counter
+    void Add(const Counter counter, const size_t value);
+
+    /// @brief Set the value of a counter
+    void Set(const Counter counter, const size_t value);
+
+    /// @brief Stop recording, startup is complete
+    void Finish();
+
+    /// @brief Check if the startup is complete
+    bool IsFinished();
+
+    /// @brief Get the time between the launch and the call to Finish (or now if it wasn't called yet)
+    double TotalMilliseconds();
+
+    /// @brief Get a human readable timeline, one line per event with its start and duration, followed by the counters
+    std::string Report();
+
+    /// @brief Get the timeline in the Chrome trace event format, to open in chrome://tracing or Perfetto
+    Json::Value ChromeTrace();
+}
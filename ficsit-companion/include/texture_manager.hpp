@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <string>
+
+/// @brief Square region of an icon texture atlas
+struct TextureRegion
+{
+    unsigned int texture_id = 0;
+    float u0 = 0.0f;
+    float v0 = 0.0f;
+    float u1 = 1.0f;
+    float v1 = 1.0f;
+};
+
+/// @brief Identifier of an image in the texture manager. The image can be evicted from the GPU and
+/// loaded again in a different place, so it's resolved to its current region each time it's drawn
+using TextureHandle = size_t;
+constexpr TextureHandle invalid_texture = std::numeric_limits<TextureHandle>::max();
+
+/// @brief Get an image file, adding a reference to it. The image is decoded in the background,
+/// it displays a placeholder until it's uploaded by UploadLoadedTextures
+/// @param path Path of the image
+/// @return Handle of the image, to release with ReleaseTexture
+TextureHandle LoadTextureFromFile(const std::string& path);
+
+/// @brief Remove a reference to an image. Images without reference free their atlas space
+/// @param texture Handle returned by LoadTextureFromFile, invalid_texture is ignored
+void ReleaseTexture(const TextureHandle texture);
+
+/// @brief Get the current atlas region of an image, loading it again if it was evicted. Must be called from the GL thread
+/// @param texture Handle returned by LoadTextureFromFile
+/// @return Region where the image (or its placeholder) is for this frame, empty region for invalid_texture
+TextureRegion GetTextureRegion(const TextureHandle texture);
+
+/// @brief Start a new frame for the texture manager: upload images decoded in the background to their atlas
+/// and free atlases over budget. Must be called from the GL thread before any GetTextureRegion of the frame
+/// @param max_uploads Maximum number of images uploaded during this call
+/// @return True if some images are still waiting to be decoded or uploaded
+bool UploadLoadedTextures(const size_t max_uploads);
+
+/// @brief Set the amount of GPU memory the icon atlases should stay under. Least recently drawn images
+/// are evicted when it's reached, except the ones drawn during the current frame
+/// @param bytes Budget in bytes, at least one atlas is always kept
+void SetTextureBudget(const size_t bytes);
+
+/// @brief Get the GPU memory budget of the icon atlases, in bytes
+size_t GetTextureBudget();
+
+/// @brief Get the GPU memory currently used by the icon atlases, in bytes
+size_t GetTextureResidentBytes();
+
+/// @brief Display an icon with ImGui::Image, sized to a text line
+void RenderIcon(const TextureHandle icon);
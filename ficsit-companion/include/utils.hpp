@@ -1,19 +1,27 @@
 #pragma once
 #include "json.hpp"
 
+#include <cstddef>
+#include <functional>
 #include <string>
 
+struct Building;
 struct Item;
 struct Recipe;
 
-unsigned int LoadTextureFromFile(const std::string& path);
-
 /// @brief Update the given save to a given version
 /// @param save Save Json to update
 /// @param to Destination save version
 /// @return True if the save was correctly updated, false otherwise
 bool UpdateSave(Json::Value& save, const int to);
 
+/// @brief Split [0, count[ in contiguous chunks processed on all hardware threads, using workers kept alive
+/// between calls. Everything runs on the calling thread for web builds
+/// @param count Number of elements
+/// @param f Function called with each chunk [begin, end[. If it throws, the first exception is rethrown on
+/// the calling thread once all chunks are finished
+void ParallelFor(const size_t count, const std::function<void(const size_t begin, const size_t end)>& f);
+
 struct ItemPtrCompare {
     bool operator()(const Item* a, const Item* b) const;
 };
@@ -21,3 +29,7 @@ struct ItemPtrCompare {
 struct RecipePtrCompare {
     bool operator()(const Recipe* a, const Recipe* b) const;
 };
+
+struct BuildingPtrCompare {
+    bool operator()(const Building* a, const Building* b) const;
+};
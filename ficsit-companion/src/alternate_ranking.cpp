@@ -0,0 +1,100 @@
+#include "alternate_ranking.hpp"
+#include "production_optimizer.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+
+namespace AlternateRanking
+{
+    Result Rank(const std::vector<const Recipe*>& usable, const std::vector<const Recipe*>& alternates, const std::vector<std::pair<const Item*, double>>& targets)
+    {
+        Result result;
+        if (targets.empty())
+        {
+            return result;
+        }
+
+        // One program with all recipes, locked alternates are just disabled
+        std::vector<const Recipe*> recipes = usable;
+        std::vector<bool> unlocked(alternates.size());
+        for (size_t i = 0; i < alternates.size(); ++i)
+        {
+            unlocked[i] = std::find(usable.begin(), usable.end(), alternates[i]) != usable.end();
+            if (!unlocked[i])
+            {
+                recipes.push_back(alternates[i]);
+            }
+        }
+
+        ProductionOptimizer base;
+        base.SetRecipes(recipes, alternates);
+        for (size_t i = 0; i < alternates.size(); ++i)
+        {
+            base.SetRecipeEnabled(alternates[i], unlocked[i]);
+        }
+
+        const ProductionOptimizer::Result base_raw = base.Solve(targets, {}, ProductionOptimizer::Objective::RawResources);
+        result.status = base_raw.status;
+        if (result.status != LinearProgram::Status::Optimal)
+        {
+            return result;
+        }
+        const ProductionOptimizer::Result base_power = base.Solve(targets, {}, ProductionOptimizer::Objective::Power);
+        result.status = base_power.status;
+        if (result.status != LinearProgram::Status::Optimal)
+        {
+            return result;
+        }
+        result.raw = base_raw.total_raw;
+        result.power = base_power.power;
+
+        result.entries.resize(alternates.size());
+        for (size_t i = 0; i < alternates.size(); ++i)
+        {
+            result.entries[i].recipe = alternates[i];
+            result.entries[i].unlocked = unlocked[i];
+        }
+
+        // Each chunk gets its own copy of the solved program, and warm starts every solve from the previous one.
+        // Changing the objective moves the optimal basis much more than toggling one recipe, so all the solves
+        // of one objective are done before switching to the other one
+        ParallelFor(alternates.size(), [&](const size_t begin, const size_t end) {
+            ProductionOptimizer optimizer = base;
+            for (const ProductionOptimizer::Objective objective : { ProductionOptimizer::Objective::Power, ProductionOptimizer::Objective::RawResources })
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    Entry& entry = result.entries[i];
+                    optimizer.SetRecipeEnabled(alternates[i], !unlocked[i]);
+                    const ProductionOptimizer::Result solution = optimizer.Solve(targets, {}, objective);
+                    optimizer.SetRecipeEnabled(alternates[i], unlocked[i]);
+
+                    if (solution.status != LinearProgram::Status::Optimal)
+                    {
+                        // Adding a recipe can't make the program infeasible, so this is an unlocked one
+                        entry.required = unlocked[i];
+                        continue;
+                    }
+                    if (objective == ProductionOptimizer::Objective::Power)
+                    {
+                        entry.power_saved = unlocked[i] ? solution.power - result.power : result.power - solution.power;
+                    }
+                    else
+                    {
+                        entry.raw_saved = unlocked[i] ? solution.total_raw - result.raw : result.raw - solution.total_raw;
+                    }
+                }
+            }
+        });
+
+        std::stable_sort(result.entries.begin(), result.entries.end(), [](const Entry& a, const Entry& b) {
+            if (a.required != b.required)
+            {
+                return a.required;
+            }
+            return a.raw_saved > b.raw_saved;
+        });
+
+        return result;
+    }
+}
@@ -1,12 +1,18 @@
 #include "app.hpp"
 #include "building.hpp"
+#include "data_watcher.hpp"
 #include "fractional_number.hpp"
 #include "game_data.hpp"
 #include "json.hpp"
 #include "link.hpp"
 #include "node.hpp"
 #include "pin.hpp"
+#include "rate_propagation.hpp"
 #include "recipe.hpp"
+#include "recipe_graph.hpp"
+#include "scenario_sweep.hpp"
+#include "search_index.hpp"
+#include "startup_timeline.hpp"
 #include "utils.hpp"
 
 // For InputText with std::string
@@ -21,8 +27,11 @@
 #include <cmath>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <limits>
 #include <optional>
 #include <stdexcept>
+#include <unordered_set>
 
 // #define WITH_SPOILERS
 
@@ -50,7 +59,10 @@ static std::optional<std::string> LoadFile(const std::string& path)
     if (std::filesystem::exists(path))
     {
         std::ifstream f(path, std::ios::in);
-        return std::string(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+        std::string content(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>{});
+        StartupTimeline::Add(StartupTimeline::Counter::FilesRead, 1);
+        StartupTimeline::Add(StartupTimeline::Counter::BytesRead, content.size());
+        return content;
     }
     return std::nullopt;
 #else
@@ -84,6 +96,60 @@ static void RemoveFile(const std::string& path)
 #endif
 }
 
+/// @brief List saved files (either on disk for desktop version or in localStorage for web version)
+/// @param folder Folder of the saved files
+/// @return Name of all files in the folder, without the folder and the extension
+static std::vector<std::string> ListSavedFiles(const std::string_view folder)
+{
+    std::vector<std::string> filenames;
+#if !defined(__EMSCRIPTEN__)
+    if (!std::filesystem::is_directory(folder))
+    {
+        std::filesystem::create_directory(folder);
+    }
+    for (const auto& f : std::filesystem::recursive_directory_iterator(folder))
+    {
+        if (f.is_regular_file())
+        {
+            std::string path = f.path().string();
+            path = path.substr(0, path.size() - 4);
+            path = path.substr(folder.size() + 1);
+            filenames.push_back(path);
+        }
+    }
+#else
+    int names_size = 0;
+    // Get all existing keys in localStorage starting with folder
+    // return a pointer to string array and save array length in names_size
+    // TODO/CHECK: are pointers always guaranteed to be 32 bits?
+    char** names = static_cast<char**>(EM_ASM_PTR({
+        const keys = Object.keys(localStorage).filter(k => k.startsWith(UTF8ToString($0)));
+        var length = keys.length;
+        var buffer = _malloc(length * 4);
+        for (var i = 0; i < length; ++i)
+        {
+            var key = keys[i];
+            var key_length = lengthBytesUTF8(key) + 1;
+            var key_ptr = _malloc(key_length + 1);
+            stringToUTF8(key, key_ptr, key_length);
+            setValue(buffer + i * 4, key_ptr, "i32");
+        }
+        setValue($1, length, "i32");
+        return buffer;
+    }, folder.data(), &names_size));
+
+    for (int i = 0; i < names_size; ++i)
+    {
+        std::string filename = std::string(names[i]).substr(folder.size() + 1);
+        filename = filename.substr(0, filename.size() - 4);
+        filenames.push_back(filename);
+        free(static_cast<void*>(names[i]));
+    }
+    free(static_cast<void*>(names));
+#endif
+    return filenames;
+}
+
 App::App()
 {
     next_id = 1;
@@ -96,10 +162,16 @@ App::App()
 
     popup_opened = false;
     new_node_pin = nullptr;
+    rates_settled = true;
 
     recipe_filter = "";
+    build_full_chain = false;
+    chain_rate = "";
+    sorted_pin_indices.resize(4);
 
-    somersloop_texture_id = LoadTextureFromFile("icons/Wat_1_64.png");
+    somersloop_icon = LoadTextureFromFile("icons/Wat_1_64.png");
+
+    data_watcher = std::make_unique<DataWatcher>(Data::Game() + ".json");
 
     last_time_interacted = std::chrono::steady_clock::now();
 
@@ -109,6 +181,7 @@ App::App()
 App::~App()
 {
     ax::NodeEditor::DestroyEditor(context);
+    ReleaseTexture(somersloop_icon);
 
     // Save current state
     // Destructor is not called in emscripten, we're using emscripten_set_beforeunload_callback in main.cpp instead
@@ -133,6 +206,7 @@ bool App::HasRecentInteraction() const
 
 void App::LoadSession()
 {
+    StartupTimeline::ScopedTimer timer("App::LoadSession");
     // Load session file if it exists
     const std::optional<std::string> content = LoadFile(session_file.data());
     if (!content.has_value())
@@ -144,9 +218,11 @@ void App::LoadSession()
 
 void App::LoadSettings()
 {
+    StartupTimeline::ScopedTimer timer("App::LoadSettings");
     const std::optional<std::string> content = LoadFile(settings_file.data());
 
     Json::Value json = content.has_value() ? Json::Parse(content.value()) : Json::Object();
+    StartupTimeline::Add(StartupTimeline::Counter::BytesParsed, content.has_value() ? content.value().size() : 0);
 
     // Load all settings values from json
     // Spoilers are disabled since we are not just after a major release anymore
@@ -156,6 +232,8 @@ void App::LoadSettings()
     settings.hide_spoilers = false;
 #endif
     settings.hide_somersloop = json.contains("hide_somersloop") && json["hide_somersloop"].get<bool>(); // default true
+    settings.texture_budget_mb = json.contains("texture_budget_mb") ? json["texture_budget_mb"].get<int>() : 64;
+    SetTextureBudget(static_cast<size_t>(settings.texture_budget_mb) * 1024 * 1024);
     settings.unlocked_alts = {};
 
     for (const auto& r : Data::Recipes())
@@ -166,6 +244,8 @@ void App::LoadSettings()
         }
     }
 
+    UpdateRawCosts();
+
     if (!content.has_value())
     {
         SaveSettings();
@@ -179,6 +259,7 @@ void App::SaveSettings() const
     // Save all settings values in the json
     serialized["hide_spoilers"] = settings.hide_spoilers;
     serialized["hide_somersloop"] = settings.hide_somersloop;
+    serialized["texture_budget_mb"] = settings.texture_budget_mb;
 
     Json::Object unlocked;
     for (const auto& [r, b] : settings.unlocked_alts)
@@ -191,10 +272,53 @@ void App::SaveSettings() const
     SaveFile(settings_file.data(), serialized.Dump());
 }
 
+bool App::IsRecipeUsable(const Recipe* recipe) const
+{
+    return (!settings.hide_spoilers || !recipe->is_spoiler) && (!recipe->alternate || settings.unlocked_alts.at(recipe));
+}
+
+void App::UpdateRawCosts()
+{
+    StartupTimeline::ScopedTimer timer("App::UpdateRawCosts");
+    raw_costs = Data::Graph().ComputeRawCosts([&](const Recipe* r) {
+        return IsRecipeUsable(r);
+    });
+    optimizer.recipes_changed = true;
+    alternate_ranking.current.recipes_version += 1;
+}
+
+std::vector<const CraftNode*> App::GetAllCraftNodes() const
+{
+    std::vector<const CraftNode*> craft_nodes;
+    std::vector<const std::vector<std::unique_ptr<Node>>*> to_visit = { &nodes };
+    while (!to_visit.empty())
+    {
+        const std::vector<std::unique_ptr<Node>>* current = to_visit.back();
+        to_visit.pop_back();
+        for (const auto& n : *current)
+        {
+            if (n->IsGroup())
+            {
+                to_visit.push_back(&static_cast<const GroupNode*>(n.get())->nodes);
+            }
+            else if (n->IsCraft() && static_cast<const CraftNode*>(n.get())->recipe != nullptr)
+            {
+                craft_nodes.push_back(static_cast<const CraftNode*>(n.get()));
+            }
+        }
+    }
+    return craft_nodes;
+}
+
 std::string App::Serialize() const
 {
+    // The whole document is only needed until it's dumped
+    Json::Arena arena;
+    Json::Arena::Scope arena_scope(arena);
+
     Json::Value output;
     output["save_version"] = SAVE_VERSION;
+    output["game"] = Data::Game();
     output["game_version"] = Data::Version();
 
     Json::Array saved_nodes;
@@ -203,7 +327,7 @@ std::string App::Serialize() const
     {
         saved_nodes.push_back(n->Serialize());
     }
-    output["nodes"] = saved_nodes;
+    output["nodes"] = std::move(saved_nodes);
 
 
     auto get_node_index = [&](const Node* n) -> int {
@@ -244,14 +368,16 @@ std::string App::Serialize() const
             }}
         });
     }
-    output["links"] = saved_links;
+    output["links"] = std::move(saved_links);
 
     return output.Dump();
 }
 
-void App::Deserialize(const std::string& s)
+void App::Deserialize(const std::string& s, const bool switch_game)
 {
-    Json::Value content = Json::Parse(s);
+    Json::Document document = Json::ParseInSitu(std::string(s));
+    Json::Value& content = document.Root();
+    StartupTimeline::Add(StartupTimeline::Counter::BytesParsed, s.size());
     if (content.is_null() || content.size() == 0)
     {
         return;
@@ -263,6 +389,17 @@ void App::Deserialize(const std::string& s)
         return;
     }
 
+    // Use the data the save was made with if it's available, the current one otherwise
+    if (switch_game && content.contains("game"))
+    {
+        const std::vector<std::string> games = Data::AvailableGames();
+        const std::string game(content["game"].get_string_view());
+        if (std::find(games.begin(), games.end(), game) != games.end())
+        {
+            SetGameData(game);
+        }
+    }
+
     // Clean current content
     for (const auto& n : nodes)
     {
@@ -434,318 +571,319 @@ void App::DeleteNode(const ax::NodeEditor::NodeId id)
 
 void App::UpdateNodesRate()
 {
-    if (updating_pins.size() == 0)
+    // Nothing to propagate says nothing about the current rates, keep the last result
+    if (!updating_pins.empty())
+    {
+        rates_settled = PropagateRates(updating_pins, nodes);
+    }
+}
+
+void App::NudgeNodes()
+{
+    // Don't nudge item if the add node popup is open (arrow keys are used for navigation in the dropdown menu)
+    if (ImGui::IsPopupOpen(add_node_popup_id.data()))
     {
         return;
     }
-    std::unordered_map<const Pin*, Constraint> updated_pins;
-    std::unordered_map<const Pin*, size_t> updated_count;
 
-    auto GetConstraint = [&](const Pin* p)
-        {
-            auto it = updated_pins.find(p);
-            return it == updated_pins.end() ? Constraint::None : it->second;
-        };
+    ImVec2 nudge{
+        -1.0f * ImGui::IsKeyPressed(ImGuiKey_LeftArrow, false) + 1.0f * ImGui::IsKeyPressed(ImGuiKey_RightArrow, false),
+        -1.0f * ImGui::IsKeyPressed(ImGuiKey_UpArrow, false) + 1.0f * ImGui::IsKeyPressed(ImGuiKey_DownArrow, false)
+    };
 
-    while (!updating_pins.empty())
+    if (nudge.x == 0.0f && nudge.y == 0.0f)
     {
-        const auto [updating_pin, updating_constraint] = updating_pins.front();
-        updating_pins.pop();
-        updated_pins[updating_pin] = updating_constraint;
-        updated_count[updating_pin] += 1;
+        return;
+    }
 
-        // Update node from this pin
-        switch (const Node::Kind kind = updating_pin->node->GetKind())
-        {
-        case Node::Kind::Craft:
+    for (const auto& n : nodes)
+    {
+        if (ax::NodeEditor::IsNodeSelected(n->id))
         {
-            CraftNode* node = static_cast<CraftNode*>(updating_pin->node);
-            // We can't use UpdateRate cause we wouldn't be able to know which pins have changed
-            if (updating_pin->direction == ax::NodeEditor::PinKind::Output)
-            {
-                node->current_rate = updating_pin->current_rate / (updating_pin->base_rate * (1 + node->num_somersloop * node->recipe->building->somersloop_mult));
-            }
-            else
-            {
-                node->current_rate = updating_pin->current_rate / updating_pin->base_rate;
-            }
-            node->ComputePowerUsage();
-            for (auto& p : node->ins)
-            {
-                const FractionalNumber new_rate = node->current_rate * p->base_rate;
-                if (new_rate == p->current_rate)
-                {
-                    continue;
-                }
-                p->current_rate = new_rate;
-                updated_pins[p.get()] = updating_constraint;
+            ax::NodeEditor::SetNodePosition(n->id, { n->pos.x + nudge.x, n->pos.y + nudge.y });
+        }
+    }
+}
 
-                // Don't need to push it if it's not linked to anything
-                if (p->link != nullptr)
-                {
-                    updating_pins.push({ p.get(), updating_constraint });
-                }
-            }
-            for (auto& p : node->outs)
-            {
-                const FractionalNumber new_rate = node->current_rate * p->base_rate * (1 + (node->num_somersloop * node->recipe->building->somersloop_mult));
-                if (new_rate == p->current_rate)
-                {
-                    continue;
-                }
-                p->current_rate = new_rate;
-                updated_pins[p.get()] = updating_constraint;
+void App::PullNodesPosition()
+{
+    for (auto& n : nodes)
+    {
+        n->pos = ax::NodeEditor::GetNodePosition(n->id);
+    }
+}
 
-                // Don't need to push it if it's not linked to anything
-                if (p->link != nullptr)
-                {
-                    updating_pins.push({ p.get(), updating_constraint });
-                }
-            }
-            break;
+void App::ReloadGameData(const Json::Value& data)
+{
+    // The ranking job uses recipes pointers, it has to be done before anything is destroyed
+    if (alternate_ranking.job.valid())
+    {
+        alternate_ranking.job.wait();
+        alternate_ranking.job = {};
+    }
+
+    const std::map<std::string, bool> unlocked_alts = UnlockedAltsByName();
+
+    PullNodesPosition();
+
+    // Old versions of changed objects stay alive until everything pointing to them is rebound
+    Data::ReplacedData replaced;
+    try
+    {
+        replaced = Data::ReloadData(data);
+    }
+    catch (const std::exception& e)
+    {
+        printf("Can't reload game data: %s\n", e.what());
+        return;
+    }
+    // New entries don't invalidate any pointer but still need the rebind (unlocked alts, raw costs...)
+    if (replaced.Empty())
+    {
+        return;
+    }
+
+    std::unordered_set<const Item*> replaced_items;
+    for (const auto& [name, i] : replaced.items)
+    {
+        replaced_items.insert(i.get());
+    }
+    std::unordered_set<const Recipe*> replaced_recipes;
+    for (const auto& r : replaced.recipes)
+    {
+        replaced_recipes.insert(r.get());
+    }
+
+    const std::function<bool(const Node*)> uses_replaced_data = [&](const Node* node) {
+        if (node->IsCraft())
+        {
+            const Recipe* recipe = static_cast<const CraftNode*>(node)->recipe;
+            return recipe != nullptr && replaced_recipes.count(recipe) > 0;
         }
-        case Node::Kind::Group:
+        if (node->IsOrganizer())
         {
-            GroupNode* node = static_cast<GroupNode*>(updating_pin->node);
-            // We can't use UpdateRate cause we wouldn't be able to know which pins have changed
-            node->current_rate = updating_pin->current_rate / updating_pin->base_rate;
-            node->PropagateRateToSubnodes();
-            node->ComputePowerUsage();
-            for (auto& p : node->ins)
-            {
-                const FractionalNumber new_rate = node->current_rate * p->base_rate;
-                if (new_rate == p->current_rate)
-                {
-                    continue;
-                }
-                p->current_rate = new_rate;
-                updated_pins[p.get()] = updating_constraint;
-
-                // Don't need to push it if it's not linked to anything
-                if (p->link != nullptr)
-                {
-                    updating_pins.push({ p.get(), updating_constraint });
-                }
-            }
-            for (auto& p : node->outs)
-            {
-                const FractionalNumber new_rate = node->current_rate * p->base_rate;
-                if (new_rate == p->current_rate)
-                {
-                    continue;
-                }
-                p->current_rate = new_rate;
-                updated_pins[p.get()] = updating_constraint;
+            const Item* item = static_cast<const OrganizerNode*>(node)->item;
+            return item != nullptr && replaced_items.count(item) > 0;
+        }
+        if (node->IsGroup())
+        {
+            const auto& subnodes = static_cast<const GroupNode*>(node)->nodes;
+            return std::any_of(subnodes.begin(), subnodes.end(), [&](const std::unique_ptr<Node>& n) { return uses_replaced_data(n.get()); });
+        }
+        return false;
+    };
 
-                // Don't need to push it if it's not linked to anything
-                if (p->link != nullptr)
-                {
-                    updating_pins.push({ p.get(), updating_constraint });
-                }
-            }
-            break;
+    // Organizers can just point to the new item, links and rates are still valid
+    std::vector<ax::NodeEditor::NodeId> removed_nodes;
+    std::vector<size_t> rebuilt_nodes;
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        if (!uses_replaced_data(nodes[i].get()))
+        {
+            continue;
         }
-        case Node::Kind::Splitter:
-        case Node::Kind::Merger:
+        if (nodes[i]->IsOrganizer())
         {
-            Node* node = updating_pin->node;
-            std::vector<std::unique_ptr<Pin>>& one_pin = kind == Node::Kind::Splitter ? node->ins : node->outs;
-            std::vector<std::unique_ptr<Pin>>& multi_pin = kind == Node::Kind::Splitter ? node->outs : node->ins;
-            // One of the "multi pin" side has been updated
-            if ((kind == Node::Kind::Splitter && updating_pin->direction == ax::NodeEditor::PinKind::Output) ||
-                (kind == Node::Kind::Merger && updating_pin->direction == ax::NodeEditor::PinKind::Input))
+            OrganizerNode* organizer = static_cast<OrganizerNode*>(nodes[i].get());
+            const auto it = Data::Items().find(organizer->item->name);
+            if (it != Data::Items().end())
             {
-                const Constraint constraint = GetConstraint(one_pin[0].get());
-                // Easy case, just sum all "multi pin" and update "single pin" side with the new value
-                if (constraint != Constraint::Strong)
-                {
-                    FractionalNumber new_rate = FractionalNumber(0, 1);
-                    const Pin* other_output_pin = nullptr;
-                    for (const auto& p : multi_pin)
-                    {
-                        new_rate += p->current_rate;
-                        if (p.get() != updating_pin)
-                        {
-                            other_output_pin = p.get();
-                        }
-                    }
-                    if (one_pin[0]->current_rate != new_rate)
-                    {
-                        one_pin[0]->current_rate = new_rate;
-                        const Constraint other_constraint = GetConstraint(other_output_pin);
-                        updating_pins.push({
-                            one_pin[0].get(),
-                            (updating_constraint == Constraint::Strong && other_constraint == Constraint::Strong) ? Constraint::Strong : Constraint::Weak
-                        });
-                    }
-                }
-                // We can't update "single pin", try to balance the node if there is a weaker constrained pin on the "multi pin" side
-                else
-                {
-                    Pin* other_pin = multi_pin[0].get() == updating_pin ? multi_pin[1].get() : multi_pin[0].get();
-                    Constraint other_constraint = GetConstraint(other_pin);
-                    if (other_constraint < Constraint::Strong && other_pin->link == nullptr)
-                    {
-                        other_constraint = Constraint::None;
-                    }
-                    // Can't balance
-                    if (other_constraint >= updating_constraint || one_pin[0]->current_rate < updating_pin->current_rate)
-                    {
-                        break;
-                    }
-
-                    const FractionalNumber new_rate = one_pin[0]->current_rate - updating_pin->current_rate;
-                    if (other_pin->current_rate != new_rate)
-                    {
-                        other_pin->current_rate = one_pin[0]->current_rate - updating_pin->current_rate;
-                        // If it's linked, propagate the update
-                        if (other_pin->link != nullptr)
-                        {
-                            updating_pins.push({
-                                other_pin,
-                                updating_constraint == Constraint::Strong ? Constraint::Strong : Constraint::Weak
-                                });
-                        }
-                    }
-                }
+                organizer->ChangeItem(it->second.get());
             }
-            // More complicated case, "one pin" side is updated, how do we split the items with all the other pins ?
             else
             {
-                Constraint constraint_0 = GetConstraint(multi_pin[0].get());
-                if (constraint_0 != Constraint::Strong && multi_pin[0]->link == nullptr)
-                {
-                    constraint_0 = Constraint::None;
-                }
-                Constraint constraint_1 = GetConstraint(multi_pin[1].get());
-                if (constraint_1 != Constraint::Strong && multi_pin[0]->link == nullptr)
-                {
-                    constraint_1 = Constraint::None;
-                }
-                // If one of the "multi pins" has a stronger constraint, use the other one to adjust if possible
-                if (constraint_0 > constraint_1 || constraint_1 > constraint_0)
-                {
-                    const int constrained_idx = constraint_0 > constraint_1 ? 0 : 1;
-                    const int other_idx = 1 - constrained_idx;
-                    if (updating_pin->current_rate > multi_pin[constrained_idx]->current_rate)
-                    {
-                        multi_pin[other_idx]->current_rate = updating_pin->current_rate - multi_pin[constrained_idx]->current_rate;
-                        if (multi_pin[other_idx]->link != nullptr)
-                        {
-                            const Constraint stronger_constraint = constraint_0 > constraint_1 ? constraint_0 : constraint_1;
-                            updating_pins.push({
-                                multi_pin[other_idx].get(),
-                                updating_constraint == Constraint::Strong && stronger_constraint == Constraint::Strong ? Constraint::Strong : Constraint::Weak
-                                });
-                        }
-                    }
-                }
-                // Else if pins have both no or weak constraints then try to split the new rate keeping the same split ratio
-                else if (constraint_0 == constraint_1 && constraint_0 < Constraint::Strong)
-                {
-                    const FractionalNumber sum = multi_pin[0]->current_rate + multi_pin[1]->current_rate;
-                    for (int i = 0; i < multi_pin.size(); ++i)
-                    {
-                        const FractionalNumber new_rate = sum.GetNumerator() == 0 ? (updating_pin->current_rate / FractionalNumber(2, 1)) : ((multi_pin[i]->current_rate / sum) * updating_pin->current_rate);
-                        if (multi_pin[i]->current_rate != new_rate)
-                        {
-                            multi_pin[i]->current_rate = new_rate;
-                            updating_pins.push({ multi_pin[i].get(), Constraint::Weak });
-                        }
-                    }
-                }
-                // Else, we can't know how the split should be so do nothing and let the user adjust
+                removed_nodes.push_back(organizer->id);
             }
-            break;
-        }
+            continue;
         }
+        rebuilt_nodes.push_back(i);
+    }
 
-        // If no link connected to this pin
-        if (updating_pin->link == nullptr)
+    // Pins of the rebuilt nodes are recreated, keep their links as node id + item name to restore them after
+    struct SavedLink
+    {
+        ax::NodeEditor::NodeId start_node;
+        std::string start_item;
+        ax::NodeEditor::NodeId end_node;
+        std::string end_item;
+    };
+    std::vector<SavedLink> saved_links;
+    std::vector<ax::NodeEditor::LinkId> removed_links;
+    for (const size_t i : rebuilt_nodes)
+    {
+        for (const auto* pins : { &nodes[i]->ins, &nodes[i]->outs })
         {
-            continue;
+            for (const auto& p : *pins)
+            {
+                // Links between two rebuilt nodes are seen twice
+                if (p->link == nullptr || std::find(removed_links.begin(), removed_links.end(), p->link->id) != removed_links.end())
+                {
+                    continue;
+                }
+                removed_links.push_back(p->link->id);
+                const Pin* start = p->link->start;
+                const Pin* end = p->link->end;
+                saved_links.push_back({
+                    start->node->id, start->item == nullptr ? "" : start->item->name,
+                    end->node->id, end->item == nullptr ? "" : end->item->name
+                });
+            }
         }
-        Pin* updated_pin = updating_pin->direction == ax::NodeEditor::PinKind::Input ? updating_pin->link->start : updating_pin->link->end;
+    }
+    for (const auto& id : removed_links)
+    {
+        DeleteLink(id);
+    }
 
-        // If rate already match new one (or if it's probably in an infinite cycle loop)
-        if (updated_pin->current_rate == updating_pin->current_rate || updated_count[updated_pin] > 8)
+    for (const size_t i : rebuilt_nodes)
+    {
+        // Same id so the node editor keeps its position and selection
+        try
         {
-            continue;
+            std::unique_ptr<Node> rebuilt = Node::Deserialize(nodes[i]->id, std::bind(&App::GetNextId, this), nodes[i]->Serialize());
+            nodes[i] = std::move(rebuilt);
         }
-
-        // If already updated with strong constraint
-        const Constraint constraint = GetConstraint(updated_pin);
-        if (constraint == Constraint::Strong)
+        catch (const std::exception&)
         {
-            continue;
+            // Recipe or item removed from the data
+            removed_nodes.push_back(nodes[i]->id);
         }
-
-        // If here, copy rate and schedule this pin to trigger updates too
-        updating_pin->link->flow = updating_pin->direction == ax::NodeEditor::PinKind::Input ? ax::NodeEditor::FlowDirection::Backward : ax::NodeEditor::FlowDirection::Forward;
-        updated_pin->current_rate = updating_pin->current_rate;
-        updating_pins.push({ updated_pin, updating_constraint });
     }
 
-    // Just in case we exited the loop prematurely
-    while (!updating_pins.empty())
+    for (const auto& id : removed_nodes)
     {
-        updating_pins.pop();
+        DeleteNode(id);
     }
 
-    // Make sure all crafting nodes are still valid regarding their recipe
-    for (auto& n : nodes)
-    {
-        if (n->GetKind() != Node::Kind::Craft)
+    const auto find_free_pin = [&](const ax::NodeEditor::NodeId node_id, const ax::NodeEditor::PinKind direction, const std::string& item) -> Pin* {
+        const auto it = std::find_if(nodes.begin(), nodes.end(), [&](const std::unique_ptr<Node>& n) { return n->id == node_id; });
+        if (it == nodes.end())
         {
-            continue;
+            return nullptr;
         }
-
-        CraftNode* node = static_cast<CraftNode*>(n.get());
-
-        for (auto& p : n->ins)
+        for (const auto& p : direction == ax::NodeEditor::PinKind::Input ? (*it)->ins : (*it)->outs)
         {
-            p->current_rate = p->base_rate * node->current_rate;
+            // Organizers lose their item when their last link is removed
+            if (p->link == nullptr && (p->item == nullptr ? (*it)->IsOrganizer() : p->item->name == item))
+            {
+                return p.get();
+            }
         }
-        for (auto& p : n->outs)
+        return nullptr;
+    };
+
+    // Links are created back if both ends still have a matching pin, this also propagates the new rates
+    for (const SavedLink& l : saved_links)
+    {
+        Pin* start = find_free_pin(l.start_node, ax::NodeEditor::PinKind::Output, l.start_item);
+        Pin* end = find_free_pin(l.end_node, ax::NodeEditor::PinKind::Input, l.end_item);
+        if (start != nullptr && end != nullptr)
         {
-            p->current_rate = p->base_rate * node->current_rate * (1 + (node->num_somersloop * node->recipe->building->somersloop_mult));
+            CreateLink(start, end);
         }
     }
+
+    RebindGameData(unlocked_alts);
 }
 
-void App::NudgeNodes()
+bool App::SetGameData(const std::string& game)
 {
-    // Don't nudge item if the add node popup is open (arrow keys are used for navigation in the dropdown menu)
-    if (ImGui::IsPopupOpen(add_node_popup_id.data()))
+    if (game == Data::Game())
     {
-        return;
+        return true;
     }
 
-    ImVec2 nudge{
-        -1.0f * ImGui::IsKeyPressed(ImGuiKey_LeftArrow, false) + 1.0f * ImGui::IsKeyPressed(ImGuiKey_RightArrow, false),
-        -1.0f * ImGui::IsKeyPressed(ImGuiKey_UpArrow, false) + 1.0f * ImGui::IsKeyPressed(ImGuiKey_DownArrow, false)
-    };
+    // Nodes still point to the previous data, it stays loaded until they're replaced
+    if (alternate_ranking.job.valid())
+    {
+        alternate_ranking.job.wait();
+        alternate_ranking.job = {};
+    }
 
-    if (nudge.x == 0.0f && nudge.y == 0.0f)
+    const std::map<std::string, bool> unlocked_alts = UnlockedAltsByName();
+
+    try
     {
-        return;
+        Data::LoadData(game);
+    }
+    catch (const std::exception& e)
+    {
+        printf("Can't load game data %s: %s\n", game.c_str(), e.what());
+        return false;
     }
 
-    for (const auto& n : nodes)
+    data_watcher = std::make_unique<DataWatcher>(Data::Game() + ".json");
+    RebindGameData(unlocked_alts);
+
+    return true;
+}
+
+std::map<std::string, bool> App::UnlockedAltsByName() const
+{
+    std::map<std::string, bool> unlocked_alts;
+    for (const auto& [r, b] : settings.unlocked_alts)
     {
-        if (ax::NodeEditor::IsNodeSelected(n->id))
-        {
-            ax::NodeEditor::SetNodePosition(n->id, { n->pos.x + nudge.x, n->pos.y + nudge.y });
-        }
+        unlocked_alts[r->name] = b;
     }
+    return unlocked_alts;
 }
 
-void App::PullNodesPosition()
+void App::RebindGameData(const std::map<std::string, bool>& unlocked_alts)
 {
-    for (auto& n : nodes)
+    settings.unlocked_alts = {};
+    for (const auto& r : Data::Recipes())
     {
-        n->pos = ax::NodeEditor::GetNodePosition(n->id);
+        if (r->alternate)
+        {
+            const auto it = unlocked_alts.find(r->name);
+            settings.unlocked_alts[r.get()] = it != unlocked_alts.end() && it->second;
+        }
+    }
+
+    // Everything else pointing to the game data is rebound by name or reset
+    const auto rebind_items = [](std::vector<std::pair<const Item*, std::string>>& entries) {
+        std::vector<std::pair<const Item*, std::string>> rebound;
+        for (const auto& [item, rate] : entries)
+        {
+            const auto it = Data::Items().find(item->name);
+            if (it != Data::Items().end())
+            {
+                rebound.emplace_back(it->second.get(), rate);
+            }
+        }
+        entries = std::move(rebound);
+    };
+    rebind_items(optimizer.targets);
+    rebind_items(optimizer.caps);
+    optimizer.craftable_items.clear();
+    optimizer.result = ProductionOptimizer::Result();
+    optimizer.build_requested = false;
+
+    clock_optimizer.recipes.clear();
+    clock_optimizer.has_result = false;
+    clock_optimizer.result = ClockOptimizer::Result();
+
+    somersloop_optimizer.recipes.clear();
+    somersloop_optimizer.current.clear();
+    somersloop_optimizer.has_result = false;
+    somersloop_optimizer.result = SomersloopOptimizer::Result();
+    if (somersloop_optimizer.target != nullptr)
+    {
+        const auto it = Data::Items().find(somersloop_optimizer.target->name);
+        somersloop_optimizer.target = it == Data::Items().end() ? nullptr : it->second.get();
     }
+
+    alternate_ranking.has_result = false;
+    alternate_ranking.result = AlternateRanking::Result();
+    alternate_ranking.current.targets.clear();
+    alternate_ranking.running = AlternateRankingState::Inputs();
+    alternate_ranking.ranked = AlternateRankingState::Inputs();
+
+    ledger = Ledger();
+    new_node_pin = nullptr;
+    recipe_indices.clear();
+
+    UpdateRawCosts();
 }
 
 void App::GroupSelectedNodes()
@@ -857,7 +995,12 @@ void App::UngroupSelectedNode()
     }
 
     const size_t num_node_before_add = nodes.size();
-    const Json::Value serialized = group_node->Serialize();
+    Json::Document document;
+    {
+        Json::Arena::Scope arena_scope(document.GetArena());
+        document.Root() = group_node->Serialize();
+    }
+    const Json::Value& serialized = document.Root();
     // Recreate the nodes of the group in the main graph
     for (auto& n : serialized["nodes"].get_array())
     {
@@ -884,7 +1027,280 @@ void App::UngroupSelectedNode()
     DeleteNode(group_node->id);
 }
 
-
+std::vector<std::pair<const Recipe*, FractionalNumber>> App::PlanProductionChain(const Recipe* recipe, const Item* item, const FractionalNumber& rate) const
+{
+    auto output_quantity = [](const Recipe* r, const Item* i) {
+        FractionalNumber quantity(0, 1);
+        for (const auto& o : r->outs)
+        {
+            if (o.item == i)
+            {
+                quantity += o.quantity;
+            }
+        }
+        return quantity;
+    };
+
+    // Choose a recipe for each item, cheapest first. A recipe which would create a cycle
+    // in the chain is skipped for the next cheapest one, if none is left the item stays an input of the chain
+    enum class State { InProgress, Done };
+    std::unordered_map<const Item*, State> states;
+    std::unordered_map<const Item*, const Recipe*> chosen;
+    // Items in post order, all inputs of an item are before it
+    std::vector<const Item*> sorted_items;
+    std::function<void(const Item*, const Recipe*)> choose = [&](const Item* i, const Recipe* preferred) {
+        states[i] = State::InProgress;
+        std::vector<std::pair<double, const Recipe*>> candidates;
+        if (preferred != nullptr)
+        {
+            candidates.emplace_back(0.0, preferred);
+        }
+        else if (!Data::Graph().IsRaw(i))
+        {
+            for (const Recipe* r : Data::Graph().Producers(i))
+            {
+                if (IsRecipeUsable(r))
+                {
+                    const std::optional<RawCost> cost = RecipeGraph::RecipeCost(r, i, raw_costs);
+                    candidates.emplace_back(cost.has_value() ? cost->total : std::numeric_limits<double>::infinity(), r);
+                }
+            }
+            std::stable_sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        }
+        for (const auto& [cost_ignored, r] : candidates)
+        {
+            bool valid = true;
+            for (const auto& in : r->ins)
+            {
+                if (const auto it = states.find(in.item); it != states.end() && it->second == State::InProgress)
+                {
+                    valid = false;
+                    break;
+                }
+            }
+            if (!valid)
+            {
+                continue;
+            }
+            for (const auto& in : r->ins)
+            {
+                if (states.find(in.item) == states.end())
+                {
+                    choose(in.item, nullptr);
+                }
+            }
+            chosen[i] = r;
+            break;
+        }
+        states[i] = State::Done;
+        sorted_items.push_back(i);
+    };
+    choose(item, recipe);
+
+    // Propagate demand from the target down to the inputs. A recipe chosen for several of its outputs
+    // only needs enough machines for the most demanding one, the others are byproducts
+    std::unordered_map<const Item*, FractionalNumber> demand;
+    std::unordered_map<const Recipe*, FractionalNumber> machines;
+    std::vector<std::pair<const Recipe*, FractionalNumber>> chain;
+    demand[item] = rate;
+    for (auto it = sorted_items.rbegin(); it != sorted_items.rend(); ++it)
+    {
+        const auto chosen_it = chosen.find(*it);
+        if (chosen_it == chosen.end())
+        {
+            continue;
+        }
+        const Recipe* r = chosen_it->second;
+        const FractionalNumber needed = demand[*it] / output_quantity(r, *it);
+        const auto [machines_it, inserted] = machines.emplace(r, FractionalNumber(0, 1));
+        if (inserted)
+        {
+            chain.emplace_back(r, FractionalNumber(0, 1));
+        }
+        if (!(needed > machines_it->second))
+        {
+            continue;
+        }
+        const FractionalNumber delta = needed - machines_it->second;
+        machines_it->second = needed;
+        for (const auto& in : r->ins)
+        {
+            demand[in.item] += delta * in.quantity;
+        }
+    }
+    for (auto& [r, n] : chain)
+    {
+        n = machines.at(r);
+    }
+
+    return chain;
+}
+
+void App::BuildProductionChain(const std::vector<std::pair<const Recipe*, FractionalNumber>>& chain, const ImVec2& position)
+{
+    constexpr float column_width = 450.0f;
+    constexpr float organizer_offset = 225.0f;
+    const float pin_height = ImGui::GetTextLineHeightWithSpacing() * 1.5f;
+
+    std::vector<CraftNode*> craft_nodes;
+    craft_nodes.reserve(chain.size());
+    for (const auto& [recipe, rate] : chain)
+    {
+        nodes.emplace_back(std::make_unique<CraftNode>(GetNextId(), recipe, std::bind(&App::GetNextId, this)));
+        CraftNode* node = static_cast<CraftNode*>(nodes.back().get());
+        node->UpdateRate(rate);
+        craft_nodes.push_back(node);
+    }
+
+    // Gather producers and consumers pins for each item
+    std::map<const Item*, std::vector<Pin*>, ItemPtrCompare> produced;
+    std::map<const Item*, std::vector<Pin*>, ItemPtrCompare> consumed;
+    std::unordered_map<const Node*, size_t> node_indices;
+    for (size_t i = 0; i < craft_nodes.size(); ++i)
+    {
+        node_indices[craft_nodes[i]] = i;
+        if (craft_nodes[i]->current_rate.GetNumerator() == 0)
+        {
+            continue;
+        }
+        for (auto& p : craft_nodes[i]->outs)
+        {
+            produced[p->item].push_back(p.get());
+        }
+        for (auto& p : craft_nodes[i]->ins)
+        {
+            consumed[p->item].push_back(p.get());
+        }
+    }
+
+    // Column of each craft node, a producer is always at least one column left of its consumers.
+    // Bounded number of passes in case the chain has cycles
+    std::vector<int> depths(craft_nodes.size(), 0);
+    for (size_t pass = 0; pass < craft_nodes.size(); ++pass)
+    {
+        bool changed = false;
+        for (const auto& [item, producers] : produced)
+        {
+            const auto consumers_it = consumed.find(item);
+            if (consumers_it == consumed.end())
+            {
+                continue;
+            }
+            for (const Pin* p : producers)
+            {
+                int& depth = depths[node_indices.at(p->node)];
+                for (const Pin* c : consumers_it->second)
+                {
+                    if (c->node != p->node && depths[node_indices.at(c->node)] + 1 > depth)
+                    {
+                        depth = depths[node_indices.at(c->node)] + 1;
+                        changed = true;
+                    }
+                }
+            }
+        }
+        if (!changed)
+        {
+            break;
+        }
+    }
+
+    std::vector<float> column_heights;
+    auto place_node = [&](Node* node, const float x, const int column) {
+        if (column >= column_heights.size())
+        {
+            column_heights.resize(column + 1, position.y);
+        }
+        node->pos = ImVec2(x, column_heights[column]);
+        column_heights[column] += (std::max(node->ins.size(), node->outs.size()) + 2) * pin_height;
+        ax::NodeEditor::SetNodePosition(node->id, node->pos);
+    };
+    for (size_t i = 0; i < craft_nodes.size(); ++i)
+    {
+        place_node(craft_nodes[i], position.x - depths[i] * column_width, 2 * depths[i]);
+    }
+
+    // Links are created directly, all rates are already consistent so no propagation is needed
+    auto link = [&](Pin* start, Pin* end) {
+        links.emplace_back(std::make_unique<Link>(GetNextId(), start, end));
+        start->link = links.back().get();
+        end->link = links.back().get();
+    };
+
+    for (const auto& [item, producers] : produced)
+    {
+        const auto consumers_it = consumed.find(item);
+        if (consumers_it == consumed.end())
+        {
+            continue;
+        }
+
+        // Organizers of this item are placed in the "half column" right of the rightmost producer
+        int column = std::numeric_limits<int>::max();
+        for (const Pin* p : producers)
+        {
+            column = std::min(column, depths[node_indices.at(p->node)]);
+        }
+        const float organizer_x = position.x - column * column_width + organizer_offset;
+        column = std::max(0, 2 * column - 1);
+
+        // Merge all producers into a single source
+        Pin* source = producers[0];
+        FractionalNumber supply = source->current_rate;
+        for (size_t i = 1; i < producers.size(); ++i)
+        {
+            nodes.emplace_back(std::make_unique<MergerNode>(GetNextId(), std::bind(&App::GetNextId, this), item));
+            MergerNode* merger = static_cast<MergerNode*>(nodes.back().get());
+            place_node(merger, organizer_x, column);
+            merger->ins[0]->current_rate = supply;
+            merger->ins[1]->current_rate = producers[i]->current_rate;
+            supply += producers[i]->current_rate;
+            merger->outs[0]->current_rate = supply;
+            link(source, merger->ins[0].get());
+            link(producers[i], merger->ins[1].get());
+            source = merger->outs[0].get();
+        }
+
+        // Feed consumers as long as there is enough supply, the remaining ones stay unlinked
+        std::vector<Pin*> targets;
+        FractionalNumber remaining = supply;
+        for (Pin* c : consumers_it->second)
+        {
+            if (c->node != source->node && !(c->current_rate > remaining))
+            {
+                targets.push_back(c);
+                remaining -= c->current_rate;
+            }
+        }
+        if (targets.empty())
+        {
+            continue;
+        }
+
+        // Split the source between all targets, any excess stays on the last splitter free output
+        const bool has_excess = remaining.GetNumerator() != 0;
+        for (size_t i = 0; i < targets.size(); ++i)
+        {
+            const bool last = i == targets.size() - 1;
+            if (last && !has_excess)
+            {
+                link(source, targets[i]);
+                break;
+            }
+            nodes.emplace_back(std::make_unique<SplitterNode>(GetNextId(), std::bind(&App::GetNextId, this), item));
+            SplitterNode* splitter = static_cast<SplitterNode*>(nodes.back().get());
+            place_node(splitter, organizer_x, column);
+            splitter->ins[0]->current_rate = source->current_rate;
+            splitter->outs[0]->current_rate = targets[i]->current_rate;
+            splitter->outs[1]->current_rate = source->current_rate - targets[i]->current_rate;
+            link(source, splitter->ins[0].get());
+            link(splitter->outs[0].get(), targets[i]);
+            source = splitter->outs[1].get();
+        }
+    }
+}
+
+
 /******************************************************\
 *              Rendering related functions             *
 \******************************************************/
@@ -900,6 +1316,12 @@ void App::Render()
 
     ImGui::SameLine();
 
+    // Optimizer solutions are added on the right part of the current view
+    const ImVec2 optimizer_position(
+        ImGui::GetCursorScreenPos().x + 0.75f * ImGui::GetContentRegionAvail().x,
+        ImGui::GetCursorScreenPos().y + 0.5f * ImGui::GetContentRegionAvail().y
+    );
+
     ax::NodeEditor::Begin("Graph", ImGui::GetContentRegionAvail());
 
     // First frame
@@ -910,6 +1332,11 @@ void App::Render()
         last_time_saved_session = ImGui::GetTime();
     }
 
+    if (std::optional<Json::Value> data = data_watcher->TakeChange(); data.has_value())
+    {
+        ReloadGameData(data.value());
+    }
+
     if (ImGui::GetTime() - last_time_saved_session > 30.0)
     {
         // We need to update last_time_saved_session here because SaveSession needs
@@ -927,6 +1354,12 @@ void App::Render()
 
     AddNewNode();
 
+    if (optimizer.build_requested)
+    {
+        BuildProductionChain(optimizer.result.recipes, ax::NodeEditor::ScreenToCanvas(optimizer_position));
+        optimizer.build_requested = false;
+    }
+
     UpdateNodesRate();
     CustomKeyControl();
 
@@ -1059,51 +1492,10 @@ void App::RenderLeftPanel()
             {
                 file_suggestions.clear();
                 // Retrieve existing saved files
-#if !defined(__EMSCRIPTEN__)
-                if (!std::filesystem::is_directory(save_folder))
-                {
-                    std::filesystem::create_directory(save_folder);
-                }
-                for (const auto& f : std::filesystem::recursive_directory_iterator(save_folder))
+                for (const std::string& f : ListSavedFiles(save_folder))
                 {
-                    if (f.is_regular_file())
-                    {
-                        std::string path = f.path().string();
-                        path = path.substr(0, path.size() - 4);
-                        path = path.substr(save_folder.size() + 1);
-                        file_suggestions.emplace_back(path, path.find(save_name));
-                    }
-                }
-#else
-                int names_size = 0;
-                // Get all existing keys in localStorage starting with save_folder
-                // return a pointer to string array and save array length in names_size
-                // TODO/CHECK: are pointers always guaranteed to be 32 bits?
-                char** names = static_cast<char**>(EM_ASM_PTR({
-                    const keys = Object.keys(localStorage).filter(k => k.startsWith(UTF8ToString($0)));
-                    var length = keys.length;
-                    var buffer = _malloc(length * 4);
-                    for (var i = 0; i < length; ++i)
-                    {
-                        var key = keys[i];
-                        var key_length = lengthBytesUTF8(key) + 1;
-                        var key_ptr = _malloc(key_length + 1);
-                        stringToUTF8(key, key_ptr, key_length);
-                        setValue(buffer + i * 4, key_ptr, "i32");
-                    }
-                    setValue($1, length, "i32");
-                    return buffer;
-                }, save_folder.data(), &names_size));
-
-                for (int i = 0; i < names_size; ++i)
-                {
-                    std::string filename = std::string(names[i]).substr(save_folder.size() + 1);
-                    filename = filename.substr(0, filename.size() - 4);
-                    file_suggestions.emplace_back(filename, filename.find(save_name));
-                    free(static_cast<void*>(names[i]));
+                    file_suggestions.emplace_back(f, f.find(save_name));
                 }
-                free(static_cast<void*>(names));
-#endif
             }
 
             if (file_suggestions.size() == 0)
@@ -1147,6 +1539,7 @@ void App::RenderLeftPanel()
                         return p.first == s;
                     }), file_suggestions.end());
                 RemoveFile(std::string(save_folder) + "/" + s + ".fcs");
+                alternate_ranking.current.saves_version += 1;
             }
 
             if (!save_name_active && !ImGui::IsWindowFocused())
@@ -1164,6 +1557,7 @@ void App::RenderLeftPanel()
     {
         // Save current state using provided name
         SaveFile(std::string(save_folder) + "/" + save_name + ".fcs", Serialize());
+        alternate_ranking.current.saves_version += 1;
         save_name = "";
     }
     ImGui::EndDisabled();
@@ -1192,6 +1586,31 @@ void App::RenderLeftPanel()
 
     ImGui::SeparatorText("Settings");
     // Display all settings here
+    if (const std::vector<std::string> games = Data::AvailableGames(); games.size() > 1)
+    {
+        ImGui::SetNextItemWidth(-FLT_MIN);
+        if (ImGui::BeginCombo("##game_data", Data::Game().c_str()))
+        {
+            for (const std::string& game : games)
+            {
+                if (ImGui::Selectable(game.c_str(), game == Data::Game()) && game != Data::Game())
+                {
+                    // Same factory, rebuilt with the other data
+                    PullNodesPosition();
+                    const std::string session = Serialize();
+                    if (SetGameData(game))
+                    {
+                        Deserialize(session, false);
+                    }
+                }
+            }
+            ImGui::EndCombo();
+        }
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("%s", "Game data used by the current factory, additional data files can be added in the datasets folder");
+        }
+    }
     if (ImGui::Checkbox("Hide somersloop amplifier", &settings.hide_somersloop))
     {
         SaveSettings();
@@ -1200,6 +1619,7 @@ void App::RenderLeftPanel()
     if (ImGui::Checkbox("Hide 1.0 new advanced recipes", &settings.hide_spoilers))
     {
         SaveSettings();
+        UpdateRawCosts();
     }
 #endif
     if (ImGui::Checkbox("Compute power with equal clocks", &settings.power_equal_clocks))
@@ -1212,6 +1632,18 @@ void App::RenderLeftPanel()
             "If set, the power per node will be calculated assuming all machines are set at the same clock value\n"
             "Otherwise, it will be calculated with machines at 100%% and one last machine underclocked");
     }
+    ImGui::SetNextItemWidth(ImGui::CalcTextSize("000000").x + ImGui::GetStyle().FramePadding.x * 2.0f + ImGui::GetFrameHeight() * 2.0f);
+    if (ImGui::InputInt("Icons memory (MB)", &settings.texture_budget_mb, 4, 16))
+    {
+        settings.texture_budget_mb = std::max(4, settings.texture_budget_mb);
+        SetTextureBudget(static_cast<size_t>(settings.texture_budget_mb) * 1024 * 1024);
+        SaveSettings();
+    }
+    if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
+    {
+        ImGui::SetTooltip("GPU memory budget for items icons, least recently displayed ones are unloaded past it\n"
+            "Currently used: %.1f MB", GetTextureResidentBytes() / (1024.0 * 1024.0));
+    }
 
     if (ImGui::Button("Unlock all alt recipes"))
     {
@@ -1224,6 +1656,7 @@ void App::RenderLeftPanel()
             }
         }
         SaveSettings();
+        UpdateRawCosts();
     }
     if (ImGui::GetContentRegionAvail().x - ImGui::GetItemRectSize().x > ImGui::CalcTextSize("Reset alt recipes").x + ImGui::GetStyle().FramePadding.x * 2.0f + ImGui::GetStyle().ItemSpacing.x)
     {
@@ -1240,89 +1673,29 @@ void App::RenderLeftPanel()
             }
         }
         SaveSettings();
+        UpdateRawCosts();
     }
 
-    std::map<const Item*, FractionalNumber, ItemPtrCompare> inputs;
-    std::map<const Item*, FractionalNumber, ItemPtrCompare> outputs;
-    std::map<const Item*, FractionalNumber, ItemPtrCompare> intermediates;
-    std::map<std::string, FractionalNumber> total_machines;
-    std::map<std::string, std::map<const Recipe*, FractionalNumber, RecipePtrCompare>> detailed_machines;
-    FractionalNumber total_power;
-    std::map<const Recipe*, FractionalNumber> detailed_power;
-    bool has_variable_power = false;
+    RenderOptimizer();
+    RenderClockOptimizer();
+    RenderSomersloopOptimizer();
+    RenderAlternateRanking();
 
-    // Gather all craft node stats (ins/outs/machines/power)
-    for (const auto& n : nodes)
+    if (!rates_settled)
     {
-        if (n->IsCraft())
-        {
-            for (const auto& p : n->ins)
-            {
-                inputs[p->item] += p->current_rate;
-            }
-            for (const auto& p : n->outs)
-            {
-                outputs[p->item] += p->current_rate;
-            }
-
-            const CraftNode* node = static_cast<const CraftNode*>(n.get());
-            total_machines[node->recipe->building->name] += node->current_rate;
-            detailed_machines[node->recipe->building->name][node->recipe] += node->current_rate;
-            total_power += settings.power_equal_clocks ? node->same_clock_power : node->last_underclock_power;
-            detailed_power[node->recipe] += settings.power_equal_clocks ? node->same_clock_power : node->last_underclock_power;
-            has_variable_power |= node->recipe->building->variable_power;
-        }
-        else if (n->IsGroup())
+        ImGui::TextColored(ImColor(255, 0, 0), "%s", "Rates did not settle, stats below are partial");
+        if (ImGui::IsItemHovered())
         {
-            const GroupNode* node = static_cast<const GroupNode*>(n.get());
-
-            for (const auto& [k, v] : node->inputs)
-            {
-                inputs[k] += v;
-            }
-            for (const auto& [k, v] : node->outputs)
-            {
-                outputs[k] += v;
-            }
-
-            total_power += settings.power_equal_clocks ? node->same_clock_power : node->last_underclock_power;
-            has_variable_power |= node->variable_power;
-            for (const auto& [k, v] : node->total_machines)
-            {
-                total_machines[k] += v;
-            }
-            for (const auto& [k, v] : node->detailed_machines)
-            {
-                for (const auto& [k2, v2] : v)
-                {
-                    detailed_machines[k][k2] += v2;
-                }
-            }
-            for (const auto& [k, v] : (settings.power_equal_clocks ? node->detailed_power_same_clock : node->detailed_power_last_underclock))
-            {
-                detailed_power[k] += v;
-            }
+            ImGui::SetTooltip("%s", "The last rate change went through a loop that can't be balanced");
         }
     }
 
-    std::map<std::string, int> min_number_machines;
-    for (const auto& [machine, map] : detailed_machines)
-    {
-        for (const auto& [r, n] : map)
-        {
-            min_number_machines[machine] += static_cast<int>(std::ceil(n.GetValue()));
-        }
-    }
+    const bool has_variable_power = ledger.Update(nodes, settings.power_equal_clocks);
 
     const float power_width = ImGui::CalcTextSize("000000.00").x + ImGui::GetStyle().FramePadding.x * 2.0f;
     ImGui::SeparatorText(has_variable_power ? "Average Power" : "Power");
-    if (total_power.GetNumerator() > 0)
+    if (ledger.power.value.GetNumerator() > 0)
     {
-        std::vector<std::pair<const Recipe*, FractionalNumber>> sorted_detailed_power(detailed_power.begin(), detailed_power.end());
-        std::stable_sort(sorted_detailed_power.begin(), sorted_detailed_power.end(), [](const auto& a, const auto& b) {
-            return a.second.GetValue() > b.second.GetValue();
-        });
-
         // No visible color change when hovered/click
         ImGui::PushStyleColor(ImGuiCol_::ImGuiCol_HeaderHovered, ImVec4(0, 0, 0, 0));
         ImGui::PushStyleColor(ImGuiCol_::ImGuiCol_HeaderActive, ImVec4(0, 0, 0, 0));
@@ -1332,16 +1705,16 @@ void App::RenderLeftPanel()
 
         // Displayed over the TreeNodeEx element (same line)
         ImGui::SameLine();
-        total_power.RenderInputText("##power", true, false, power_width);
+        ledger.power.value.RenderInputText("##power", true, false, power_width);
         ImGui::SameLine();
         ImGui::Text("%sMW", has_variable_power ? "~" : "");
         // Detailed list of recipes if the tree node is open
         if (display_power_details)
         {
             ImGui::Indent();
-            for (auto& [recipe, p] : sorted_detailed_power)
+            for (auto& [recipe, p] : ledger.sorted_detailed_power)
             {
-                p.RenderInputText("##power", true, false, power_width);
+                p->RenderInputText("##power", true, false, power_width);
                 ImGui::SameLine();
                 ImGui::Text("%sMW", recipe->building->variable_power ? "~" : "");
                 ImGui::SameLine();
@@ -1355,40 +1728,51 @@ void App::RenderLeftPanel()
 
     const float rate_width = ImGui::CalcTextSize("0000.000").x + ImGui::GetStyle().FramePadding.x * 2.0f;
     ImGui::SeparatorText("Machines");
-    for (auto& [machine, n] : total_machines)
+    for (auto& [building, machine] : ledger.machines)
     {
-        if (n.GetNumerator() == 0)
+        if (machine.total.value.GetNumerator() == 0)
         {
             continue;
         }
+        int min_number_machines = 0;
+        for (const auto& [recipe, e] : machine.recipes)
+        {
+            min_number_machines += static_cast<int>(std::ceil(e.value.GetValue()));
+        }
+
         // No visible color change when hovered/click
         ImGui::PushStyleColor(ImGuiCol_::ImGuiCol_HeaderHovered, ImVec4(0, 0, 0, 0));
         ImGui::PushStyleColor(ImGuiCol_::ImGuiCol_HeaderActive, ImVec4(0, 0, 0, 0));
-        const bool display_details = ImGui::TreeNodeEx(("##" + machine).c_str(), ImGuiTreeNodeFlags_FramePadding | ImGuiTreeNodeFlags_SpanAvailWidth);
+        // Building pointer as ID, label is displayed after the rate
+        const bool display_details = ImGui::TreeNodeEx(building, ImGuiTreeNodeFlags_FramePadding | ImGuiTreeNodeFlags_SpanAvailWidth, "%s", "");
         ImGui::PopStyleColor();
         ImGui::PopStyleColor();
 
         // Displayed over the TreeNodeEx element (same line)
         ImGui::SameLine();
-        n.RenderInputText("##rate", true, true, rate_width);
+        machine.total.value.RenderInputText("##rate", true, true, rate_width);
         ImGui::SameLine();
-        ImGui::Text("(%i)", min_number_machines[machine]);
+        ImGui::Text("(%i)", min_number_machines);
         if (ImGui::IsItemHovered())
         {
             ImGui::SetTooltip("%s", "Minimum number of machines at 100%");
         }
         ImGui::SameLine();
-        ImGui::TextUnformatted(machine.c_str());
+        ImGui::TextUnformatted(building->name.c_str());
 
         // Detailed list of recipes if the tree node is open
         if (display_details)
         {
             ImGui::Indent();
-            for (auto& [recipe, n2] : detailed_machines[machine])
+            for (auto& [recipe, e] : machine.recipes)
             {
-                n2.RenderInputText("##rate", true, true, rate_width);
+                if (e.value.GetNumerator() == 0)
+                {
+                    continue;
+                }
+                e.value.RenderInputText("##rate", true, true, rate_width);
                 ImGui::SameLine();
-                ImGui::Text("(%i)", static_cast<int>(std::ceil(n2.GetValue())));
+                ImGui::Text("(%i)", static_cast<int>(std::ceil(e.value.GetValue())));
                 if (ImGui::IsItemHovered())
                 {
                     ImGui::SetTooltip("%s", "Minimum number of machines at 100%");
@@ -1405,69 +1789,39 @@ void App::RenderLeftPanel()
     }
 
     ImGui::SeparatorText("Inputs");
-    for (auto& [item, n] : inputs)
+    for (auto& [item, l] : ledger.items)
     {
-        if (n.GetNumerator() == 0)
+        if (l.input.GetNumerator() == 0)
         {
             continue;
         }
-        if (const auto out_it = outputs.find(item); out_it != outputs.end())
-        {
-            // More output than input, don't display this in inputs
-            if (out_it->second > n)
-            {
-                continue;
-            }
-            // Equal, just add it to intermediate
-            else if (out_it->second == n)
-            {
-                outputs.erase(out_it);
-                intermediates[item] += n;
-                continue;
-            }
-            // More input than output, display the diff and add the common part to intermediate
-            else
-            {
-                n = n - out_it->second;
-                intermediates[item] += out_it->second;
-                outputs.erase(out_it);
-            }
-        }
-        n.RenderInputText("##rate", true, true, rate_width);
+        l.input.RenderInputText("##rate", true, true, rate_width);
         ImGui::SameLine();
-        ImGui::Image((void*)(intptr_t)item->icon_gl_index, ImVec2(ImGui::GetTextLineHeightWithSpacing(), ImGui::GetTextLineHeightWithSpacing()));
+        RenderIcon(item->icon);
         ImGui::SameLine();
         ImGui::TextUnformatted(item->name.c_str());
+        if (ImGui::IsItemHovered(ImGuiHoveredFlags_DelayNormal))
+        {
+            RenderRawCostTooltip(item);
+        }
     }
 
     ImGui::SeparatorText("Outputs");
-    for (auto& [item, n] : outputs)
+    for (auto& [item, l] : ledger.items)
     {
-        if (n.GetNumerator() == 0)
+        if (l.output.GetNumerator() == 0)
         {
             continue;
         }
-        if (const auto in_it = inputs.find(item); in_it != inputs.end())
-        {
-            // More input than output, skip this
-            if (in_it->second > n)
-            {
-                continue;
-            }
-            // Equal should not happen as it's removed from output in input loop
-            // More output than input, display the diff and add the common part to intermediate
-            else
-            {
-                n = n - in_it->second;
-                intermediates[item] += in_it->second;
-                inputs.erase(in_it);
-            }
-        }
-        n.RenderInputText("##rate", true, true, rate_width);
+        l.output.RenderInputText("##rate", true, true, rate_width);
         ImGui::SameLine();
-        ImGui::Image((void*)(intptr_t)item->icon_gl_index, ImVec2(ImGui::GetTextLineHeightWithSpacing(), ImGui::GetTextLineHeightWithSpacing()));
+        RenderIcon(item->icon);
         ImGui::SameLine();
         ImGui::TextUnformatted(item->name.c_str());
+        if (ImGui::IsItemHovered(ImGuiHoveredFlags_DelayNormal))
+        {
+            RenderRawCostTooltip(item);
+        }
     }
 
     ImGui::SeparatorText("Intermediates");
@@ -1475,17 +1829,21 @@ void App::RenderLeftPanel()
     {
         ImGui::SetTooltip("%s", "Items both produced and consumed in the production chain");
     }
-    for (auto& [item, n] : intermediates)
+    for (auto& [item, l] : ledger.items)
     {
-        if (n.GetNumerator() == 0)
+        if (l.intermediate.GetNumerator() == 0)
         {
             continue;
         }
-        n.RenderInputText("##rate", true, true, rate_width);
+        l.intermediate.RenderInputText("##rate", true, true, rate_width);
         ImGui::SameLine();
-        ImGui::Image((void*)(intptr_t)item->icon_gl_index, ImVec2(ImGui::GetTextLineHeightWithSpacing(), ImGui::GetTextLineHeightWithSpacing()));
+        RenderIcon(item->icon);
         ImGui::SameLine();
         ImGui::TextUnformatted(item->name.c_str());
+        if (ImGui::IsItemHovered(ImGuiHoveredFlags_DelayNormal))
+        {
+            RenderRawCostTooltip(item);
+        }
     }
 }
 
@@ -1493,8 +1851,6 @@ void App::RenderNodes()
 {
     const float rate_width = ImGui::CalcTextSize("000.000").x + ImGui::GetStyle().FramePadding.x * 2.0f;
     const float somersloop_width = ImGui::CalcTextSize("4").x + ImGui::GetStyle().FramePadding.x * 2.0f;
-    // Vector that will be reused to sort pins for all nodes (instead of creating two per nodes)
-    std::vector<size_t> sorted_pin_indices(4);
     auto sort_pin_indices = [&](const std::vector<std::unique_ptr<Pin>>& pins) {
         // Make sure there is enough elements in the vector
         const size_t N = pins.size();
@@ -1622,7 +1978,7 @@ void App::RenderNodes()
                             if (node->IsPowered())
                             {
                                 ImGui::Spring(0.0f);
-                                ImGui::Image((void*)(intptr_t)p->item->icon_gl_index, ImVec2(ImGui::GetTextLineHeightWithSpacing(), ImGui::GetTextLineHeightWithSpacing()));
+                                RenderIcon(p->item->icon);
                                 ImGui::Spring(0.0f);
                                 ImGui::TextUnformatted(p->item->new_line_name.c_str());
                                 ImGui::Spring(0.0f);
@@ -1658,7 +2014,7 @@ void App::RenderNodes()
                                 ImGui::Spring(0.0f);
                                 ImGui::TextUnformatted(p->item->new_line_name.c_str());
                                 ImGui::Spring(0.0f);
-                                ImGui::Image((void*)(intptr_t)p->item->icon_gl_index, ImVec2(ImGui::GetTextLineHeightWithSpacing(), ImGui::GetTextLineHeightWithSpacing()));
+                                RenderIcon(p->item->icon);
                             }
                             ImGui::Spring(0.0f);
                             p->current_rate.RenderInputText("##rate", false, false, rate_width);
@@ -1806,7 +2162,7 @@ void App::RenderNodes()
                                 }
                             }
                             ImGui::Spring(0.0f);
-                            ImGui::Image((void*)(intptr_t)somersloop_texture_id, ImVec2(ImGui::GetTextLineHeightWithSpacing(), ImGui::GetTextLineHeightWithSpacing()));
+                            RenderIcon(somersloop_icon);
                             if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
                             {
                                 frame_tooltips.push_back("Alien Production Amplification");
@@ -1824,7 +2180,7 @@ void App::RenderNodes()
                         ImGui::Spring(0.0f);
                         ImGui::TextUnformatted(org_node->item->name.c_str());
                         ImGui::Spring(0.0f);
-                        ImGui::Image((void*)(intptr_t)org_node->item->icon_gl_index, ImVec2(ImGui::GetTextLineHeightWithSpacing(), ImGui::GetTextLineHeightWithSpacing()));
+                        RenderIcon(org_node->item->icon);
                         ImGui::Spring(0.0f);
                     }
                     ImGui::Spring(1.0f);
@@ -1985,9 +2341,8 @@ void App::AddNewNode()
             recipe_index = 1;
         }
         ImGui::Separator();
-        // Stores the recipe index and a "match score" to sort them in the display
-        std::vector<std::pair<int, size_t>> recipe_indices;
-        const std::vector<std::unique_ptr<Recipe>>& recipes = Data::Recipes();
+        const std::vector<std::shared_ptr<Recipe>>& recipes = Data::Recipes();
+        recipe_indices.clear();
         recipe_indices.reserve(recipes.size());
         // If this is already linked to another node
         // only display matching recipes
@@ -2025,6 +2380,24 @@ void App::AddNewNode()
                 ImGui::SetKeyboardFocusHere();
             }
             ImGui::InputTextWithHint("##recipe_filter", "Filter...", &recipe_filter);
+            if (new_node_pin == nullptr)
+            {
+                ImGui::Checkbox("Build full production chain", &build_full_chain);
+                if (ImGui::IsItemHovered(ImGuiHoveredFlags_DelayNormal))
+                {
+                    ImGui::SetTooltip("%s", "Create the selected recipe and all its upstream recipes (cheapest unlocked ones) at once");
+                }
+                if (build_full_chain)
+                {
+                    ImGui::SameLine();
+                    ImGui::SetNextItemWidth(ImGui::CalcTextSize("0000.000").x + ImGui::GetStyle().FramePadding.x * 2.0f);
+                    ImGui::InputTextWithHint("##chain_rate", "Rate", &chain_rate, ImGuiInputTextFlags_CharsDecimal);
+                    if (ImGui::IsItemHovered())
+                    {
+                        ImGui::SetTooltip("%s", "Target rate (/min) of the recipe first output. Empty for one machine");
+                    }
+                }
+            }
 
             // If no filter, display all recipes in alphabetical order
             if (recipe_filter.empty())
@@ -2034,35 +2407,19 @@ void App::AddNewNode()
                     recipe_indices.push_back({ i, 0 });
                 }
             }
-            // Else display first all recipes with matching name, then matching ingredients
+            // Else display first all recipes with matching name, then matching ingredients/building, then fuzzy matches
             else
             {
                 // A recipe goes on top if it matched the search string "before" another
                 // If they both matched at the same place, the alternate goes after
+                // Last tie break is the index, to keep alphabetical order (std::sort to avoid std::stable_sort allocation)
                 auto scored_recipe_sorting = [&](const std::pair<int, size_t>& a, const std::pair<int, size_t>& b) {
-                    return a.second < b.second || (a.second == b.second && !recipes[a.first]->alternate && recipes[b.first]->alternate);
+                    return a.second < b.second ||
+                        (a.second == b.second && !recipes[a.first]->alternate && recipes[b.first]->alternate) ||
+                        (a.second == b.second && recipes[a.first]->alternate == recipes[b.first]->alternate && a.first < b.first);
                 };
-                for (int i = 0; i < recipes.size(); ++i)
-                {
-                    if (const size_t pos = recipes[i]->FindInName(recipe_filter); pos != std::string::npos)
-                    {
-                        recipe_indices.push_back({ i, pos });
-                    }
-                }
-                std::stable_sort(recipe_indices.begin(), recipe_indices.end(), scored_recipe_sorting);
-                const size_t num_recipe_match = recipe_indices.size();
-
-                for (int i = 0; i < recipes.size(); ++i)
-                {
-                    if (recipes[i]->FindInName(recipe_filter) == std::string::npos)
-                    {
-                        if (const size_t pos = recipes[i]->FindInIngredients(recipe_filter); pos != std::string::npos)
-                        {
-                            recipe_indices.push_back({ i, pos });
-                        }
-                    }
-                }
-                std::stable_sort(recipe_indices.begin() + num_recipe_match, recipe_indices.end(), scored_recipe_sorting);
+                Data::RecipeSearchIndex().Search(recipe_filter, recipe_indices);
+                std::sort(recipe_indices.begin(), recipe_indices.end(), scored_recipe_sorting);
             }
         }
 
@@ -2091,9 +2448,16 @@ void App::AddNewNode()
             ImGui::TableNextRow();
             ImGui::TableSetColumnIndex(0);
             ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(0.0f, 0.0f));
-            if (recipes[i]->alternate && ImGui::Checkbox(("##checkbox" + recipes[i]->name).c_str(), &settings.unlocked_alts.at(recipes[i].get())))
+            if (recipes[i]->alternate)
             {
-                SaveSettings();
+                // Recipe pointer as ID to get a unique label without building a string for each row
+                ImGui::PushID(recipes[i].get());
+                if (ImGui::Checkbox("##checkbox", &settings.unlocked_alts.at(recipes[i].get())))
+                {
+                    SaveSettings();
+                    UpdateRawCosts();
+                }
+                ImGui::PopID();
             }
             ImGui::PopStyleVar();
             ImGui::TableSetColumnIndex(1);
@@ -2106,13 +2470,35 @@ void App::AddNewNode()
                 break;
             }
             ImGui::EndDisabled();
+            if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled | ImGuiHoveredFlags_DelayNormal))
+            {
+                RenderRawCostTooltip(recipes[i].get());
+            }
             ImGui::TableSetColumnIndex(2);
 
             recipes[i]->Render(false);
         }
         ImGui::EndTable();
 
-        if (recipe_index != -1)
+        if (recipe_index > 1 && build_full_chain && new_node_pin == nullptr)
+        {
+            const Recipe* recipe = recipes[recipe_index - 2].get();
+            FractionalNumber rate = recipe->outs[0].quantity;
+            try
+            {
+                if (!chain_rate.empty())
+                {
+                    rate = FractionalNumber(chain_rate);
+                }
+            }
+            catch (const std::exception&)
+            {
+                // Invalid rate, keep the one machine rate
+            }
+            BuildProductionChain(PlanProductionChain(recipe, recipe->outs[0].item, rate), new_node_position);
+            on_popup_close();
+        }
+        else if (recipe_index != -1)
         {
             if (recipe_index == 0)
             {
@@ -2173,6 +2559,677 @@ void App::RenderTooltips()
     frame_tooltips.clear();
 }
 
+/// @brief Render raw amounts and power of a RawCost, to be called inside a tooltip
+/// @param cost Cost to display
+static void RenderRawCost(const RawCost& cost)
+{
+    ImGui::Indent();
+    for (const auto& [item, amount] : cost.raw)
+    {
+        RenderIcon(item->icon);
+        ImGui::SameLine();
+        ImGui::Text("%.3f %s", amount, item->name.c_str());
+    }
+    ImGui::Text("%.3f MW per item/min", cost.power);
+    ImGui::Unindent();
+}
+
+void App::RenderRawCostTooltip(const Item* item) const
+{
+    const auto it = raw_costs.find(item);
+    ImGui::BeginTooltip();
+    if (it == raw_costs.end())
+    {
+        ImGui::Text("%s can't be produced with unlocked recipes", item->name.c_str());
+    }
+    else if (it->second.recipe == nullptr)
+    {
+        ImGui::Text("%s is a raw resource", item->name.c_str());
+    }
+    else
+    {
+        ImGui::Text("Raw cost per %s (using %s):", item->name.c_str(), it->second.recipe->display_name.c_str());
+        RenderRawCost(it->second);
+    }
+    ImGui::EndTooltip();
+}
+
+void App::RenderRawCostTooltip(const Recipe* recipe) const
+{
+    ImGui::BeginTooltip();
+    for (size_t i = 0; i < recipe->outs.size(); ++i)
+    {
+        if (i > 0)
+        {
+            ImGui::Separator();
+        }
+        const Item* item = recipe->outs[i].item;
+        const std::optional<RawCost> cost = RecipeGraph::RecipeCost(recipe, item, raw_costs);
+        if (!cost.has_value())
+        {
+            ImGui::Text("%s: some inputs can't be produced with unlocked recipes", item->name.c_str());
+            continue;
+        }
+        ImGui::Text("Raw cost per %s:", item->name.c_str());
+        RenderRawCost(cost.value());
+    }
+    ImGui::EndTooltip();
+}
+
+void App::RenderOptimizer()
+{
+    ImGui::SeparatorText("Optimizer");
+    if (ImGui::IsItemHovered())
+    {
+        ImGui::SetTooltip("%s", "Find the best combination of usable recipes to produce some items");
+    }
+
+    if (optimizer.craftable_items.empty())
+    {
+        for (const auto& [name, item] : Data::Items())
+        {
+            if (!Data::Graph().IsRaw(item.get()) && !Data::Graph().Producers(item.get()).empty())
+            {
+                optimizer.craftable_items.push_back(item.get());
+            }
+        }
+        std::sort(optimizer.craftable_items.begin(), optimizer.craftable_items.end(), ItemPtrCompare());
+    }
+
+    if (optimizer.recipes_changed)
+    {
+        std::vector<const Recipe*> usable_recipes;
+        for (const auto& r : Data::Recipes())
+        {
+            if (IsRecipeUsable(r.get()))
+            {
+                usable_recipes.push_back(r.get());
+            }
+        }
+        optimizer.solver.SetRecipes(usable_recipes);
+        optimizer.recipes_changed = false;
+        optimizer.dirty = true;
+    }
+
+    static constexpr std::array objective_names = { "Minimize raw resources", "Minimize power", "Minimize buildings" };
+    ImGui::SetNextItemWidth(-FLT_MIN);
+    if (ImGui::BeginCombo("##objective", objective_names[static_cast<size_t>(optimizer.objective)]))
+    {
+        for (size_t i = 0; i < objective_names.size(); ++i)
+        {
+            if (ImGui::Selectable(objective_names[i], i == static_cast<size_t>(optimizer.objective)))
+            {
+                optimizer.objective = static_cast<ProductionOptimizer::Objective>(i);
+                optimizer.dirty = true;
+            }
+        }
+        ImGui::EndCombo();
+    }
+
+    const float rate_width = ImGui::CalcTextSize("0000.000").x + ImGui::GetStyle().FramePadding.x * 2.0f;
+    // Render a list of (item, rate) with a button to add new ones
+    auto render_entries = [&](std::vector<std::pair<const Item*, std::string>>& entries, const std::vector<const Item*>& items, const char* add_label, const char* rate_hint) {
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            ImGui::PushID(static_cast<int>(i));
+            optimizer.dirty |= ImGui::InputTextWithHint("##rate", rate_hint, &entries[i].second, ImGuiInputTextFlags_CharsDecimal);
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(std::max(rate_width, ImGui::GetContentRegionAvail().x - ImGui::CalcTextSize("X").x - ImGui::GetStyle().FramePadding.x * 2.0f - ImGui::GetStyle().ItemSpacing.x));
+            if (ImGui::BeginCombo("##item", entries[i].first == nullptr ? "Item..." : entries[i].first->name.c_str()))
+            {
+                for (const Item* item : items)
+                {
+                    if (ImGui::Selectable(item->name.c_str(), item == entries[i].first))
+                    {
+                        entries[i].first = item;
+                        optimizer.dirty = true;
+                    }
+                }
+                ImGui::EndCombo();
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("X"))
+            {
+                entries.erase(entries.begin() + i);
+                optimizer.dirty = true;
+                ImGui::PopID();
+                break;
+            }
+            ImGui::PopID();
+        }
+        if (ImGui::Button(add_label))
+        {
+            entries.emplace_back(nullptr, "");
+        }
+    };
+
+    ImGui::PushID("targets");
+    ImGui::PushItemWidth(rate_width);
+    render_entries(optimizer.targets, optimizer.craftable_items, "Add target", "Rate");
+    ImGui::PopItemWidth();
+    ImGui::PopID();
+    if (ImGui::GetContentRegionAvail().x - ImGui::GetItemRectSize().x > ImGui::CalcTextSize("Add resource cap").x + ImGui::GetStyle().FramePadding.x * 2.0f + ImGui::GetStyle().ItemSpacing.x)
+    {
+        ImGui::SameLine();
+    }
+    ImGui::PushID("caps");
+    ImGui::PushItemWidth(rate_width);
+    render_entries(optimizer.caps, optimizer.solver.RawItems(), "Add resource cap", "Max");
+    ImGui::PopItemWidth();
+    ImGui::PopID();
+
+    if (optimizer.dirty)
+    {
+        optimizer.dirty = false;
+        optimizer.invalid_rate = false;
+        // Parse user rates, empty rates are ignored
+        auto parse_entries = [&](const std::vector<std::pair<const Item*, std::string>>& entries) {
+            std::vector<std::pair<const Item*, double>> parsed;
+            for (const auto& [item, rate] : entries)
+            {
+                if (item == nullptr || rate.empty())
+                {
+                    continue;
+                }
+                try
+                {
+                    parsed.emplace_back(item, FractionalNumber(rate).GetValue());
+                }
+                catch (const std::exception&)
+                {
+                    optimizer.invalid_rate = true;
+                }
+            }
+            return parsed;
+        };
+        const std::vector<std::pair<const Item*, double>> targets = parse_entries(optimizer.targets);
+        const std::vector<std::pair<const Item*, double>> caps = parse_entries(optimizer.caps);
+        optimizer.result = (optimizer.invalid_rate || targets.empty()) ? ProductionOptimizer::Result() : optimizer.solver.Solve(targets, caps, optimizer.objective);
+    }
+
+    if (optimizer.invalid_rate)
+    {
+        ImGui::TextDisabled("%s", "Invalid rate");
+        return;
+    }
+    switch (optimizer.result.status)
+    {
+    case LinearProgram::Status::Optimal:
+        break;
+    case LinearProgram::Status::Infeasible:
+        if (std::any_of(optimizer.targets.begin(), optimizer.targets.end(), [](const auto& t) { return t.first != nullptr && !t.second.empty(); }))
+        {
+            ImGui::TextDisabled("%s", "No solution with usable recipes and caps");
+        }
+        return;
+    default:
+        ImGui::TextDisabled("%s", "Optimizer failed to find a solution");
+        return;
+    }
+
+    ImGui::Text("%.2f MW | %.2f machines | %.2f raw/min", optimizer.result.power, optimizer.result.machines, optimizer.result.total_raw);
+    if (ImGui::IsItemHovered(ImGuiHoveredFlags_DelayNormal))
+    {
+        ImGui::BeginTooltip();
+        for (const auto& [item, rate] : optimizer.result.raw)
+        {
+            ImGui::Text("%.2f", rate);
+            ImGui::SameLine();
+            RenderIcon(item->icon);
+            ImGui::SameLine();
+            ImGui::TextUnformatted(item->name.c_str());
+        }
+        ImGui::EndTooltip();
+    }
+
+    const bool display_details = ImGui::TreeNodeEx("##optimizer_recipes", ImGuiTreeNodeFlags_FramePadding | ImGuiTreeNodeFlags_SpanAvailWidth, "%zu recipes", optimizer.result.recipes.size());
+    if (display_details)
+    {
+        for (auto& [recipe, machines] : optimizer.result.recipes)
+        {
+            ImGui::PushID(recipe);
+            machines.RenderInputText("##machines", true, true, rate_width);
+            ImGui::PopID();
+            ImGui::SameLine();
+            ImGui::TextUnformatted("x");
+            ImGui::SameLine();
+            recipe->Render();
+        }
+        ImGui::TreePop();
+    }
+
+    if (ImGui::Button("Add to graph"))
+    {
+        optimizer.build_requested = true;
+    }
+}
+
+void App::RenderClockOptimizer()
+{
+    ImGui::SeparatorText("Clocks");
+    if (ImGui::IsItemHovered())
+    {
+        ImGui::SetTooltip("%s", "Find the number of machines, clocks and power shards of the current nodes");
+    }
+
+    static constexpr std::array objective_names = { "Minimize power", "Minimize buildings" };
+    ImGui::SetNextItemWidth(-FLT_MIN);
+    if (ImGui::BeginCombo("##clock_objective", objective_names[static_cast<size_t>(clock_optimizer.objective)]))
+    {
+        for (size_t i = 0; i < objective_names.size(); ++i)
+        {
+            if (ImGui::Selectable(objective_names[i], i == static_cast<size_t>(clock_optimizer.objective)))
+            {
+                clock_optimizer.objective = static_cast<ClockOptimizer::Objective>(i);
+            }
+        }
+        ImGui::EndCombo();
+    }
+
+    const float input_width = ImGui::CalcTextSize("000000").x + ImGui::GetStyle().FramePadding.x * 2.0f + ImGui::GetFrameHeight() * 2.0f;
+    ImGui::SetNextItemWidth(input_width);
+    if (ImGui::InputInt("Extra machines", &clock_optimizer.extra_machines))
+    {
+        clock_optimizer.extra_machines = std::max(0, clock_optimizer.extra_machines);
+    }
+    if (ImGui::IsItemHovered(ImGuiHoveredFlags_DelayNormal))
+    {
+        ImGui::SetTooltip("%s", "Machines that can be built on top of the current ones");
+    }
+    ImGui::Checkbox("##limit_shards", &clock_optimizer.limit_shards);
+    ImGui::SameLine();
+    ImGui::BeginDisabled(!clock_optimizer.limit_shards);
+    ImGui::SetNextItemWidth(input_width);
+    if (ImGui::InputInt("Power shards", &clock_optimizer.shard_budget))
+    {
+        clock_optimizer.shard_budget = std::max(0, clock_optimizer.shard_budget);
+    }
+    ImGui::EndDisabled();
+
+    if (ImGui::Button("Optimize clocks"))
+    {
+        std::vector<ClockOptimizer::Task> tasks;
+        clock_optimizer.recipes.clear();
+        clock_optimizer.current_power = 0.0;
+        clock_optimizer.current_machines = 0;
+        for (const CraftNode* node : GetAllCraftNodes())
+        {
+            if (node->current_rate.GetNumerator() == 0)
+            {
+                continue;
+            }
+            const Building* building = node->recipe->building;
+            tasks.push_back(ClockOptimizer::Task{
+                node->recipe,
+                node->current_rate.GetValue(),
+                std::pow(1.0 + node->num_somersloop.GetValue() * building->somersloop_mult.GetValue(), building->somersloop_power_exponent)
+            });
+            clock_optimizer.recipes.push_back(node->recipe);
+            clock_optimizer.current_power += node->same_clock_power.GetValue();
+            clock_optimizer.current_machines += static_cast<int>(std::ceil(node->current_rate.GetValue()));
+        }
+        clock_optimizer.result = ClockOptimizer::Optimize(tasks, clock_optimizer.objective,
+            clock_optimizer.current_machines + clock_optimizer.extra_machines,
+            clock_optimizer.limit_shards ? std::optional<int>(clock_optimizer.shard_budget) : std::nullopt);
+        clock_optimizer.has_result = true;
+    }
+
+    if (!clock_optimizer.has_result || clock_optimizer.recipes.empty())
+    {
+        return;
+    }
+    if (!clock_optimizer.result.feasible)
+    {
+        ImGui::TextDisabled("%s", "Not enough machines or power shards");
+        return;
+    }
+
+    ImGui::Text("%.2f MW (%+.2f) | %d machines (%+d) | %d shards", clock_optimizer.result.power, clock_optimizer.result.power - clock_optimizer.current_power,
+        clock_optimizer.result.machines, clock_optimizer.result.machines - clock_optimizer.current_machines, clock_optimizer.result.shards);
+    if (ImGui::IsItemHovered(ImGuiHoveredFlags_DelayNormal))
+    {
+        ImGui::SetTooltip("Compared to %.2f MW with %d machines at equal clocks when optimized", clock_optimizer.current_power, clock_optimizer.current_machines);
+    }
+
+    if (ImGui::TreeNodeEx("##clock_setups", ImGuiTreeNodeFlags_FramePadding | ImGuiTreeNodeFlags_SpanAvailWidth, "%zu nodes", clock_optimizer.recipes.size()))
+    {
+        for (size_t i = 0; i < clock_optimizer.recipes.size(); ++i)
+        {
+            const ClockOptimizer::Setup& setup = clock_optimizer.result.setups[i];
+            for (size_t j = 0; j < setup.groups.size(); ++j)
+            {
+                const ClockOptimizer::MachineGroup& group = setup.groups[j];
+                if (j > 0)
+                {
+                    ImGui::SameLine();
+                    ImGui::TextUnformatted("+");
+                    ImGui::SameLine();
+                }
+                ImGui::Text("%d x %.2f%%", group.count, group.clock * 100.0);
+                if (group.shards > 0)
+                {
+                    ImGui::SameLine();
+                    ImGui::TextDisabled("(%d shard%s)", group.shards, group.shards > 1 ? "s" : "");
+                }
+            }
+            ImGui::SameLine();
+            clock_optimizer.recipes[i]->Render();
+        }
+        ImGui::TreePop();
+    }
+}
+
+void App::RenderSomersloopOptimizer()
+{
+    ImGui::SeparatorText("Somersloops");
+    if (ImGui::IsItemHovered())
+    {
+        ImGui::SetTooltip("%s", "Distribute a limited number of somersloops between the current nodes, keeping the same outputs");
+    }
+
+    static constexpr std::array objective_names = { "Minimize imported items", "Maximize item output" };
+    ImGui::SetNextItemWidth(-FLT_MIN);
+    if (ImGui::BeginCombo("##somersloop_objective", objective_names[static_cast<size_t>(somersloop_optimizer.objective)]))
+    {
+        for (size_t i = 0; i < objective_names.size(); ++i)
+        {
+            if (ImGui::Selectable(objective_names[i], i == static_cast<size_t>(somersloop_optimizer.objective)))
+            {
+                somersloop_optimizer.objective = static_cast<SomersloopOptimizer::Objective>(i);
+            }
+        }
+        ImGui::EndCombo();
+    }
+    if (somersloop_optimizer.objective == SomersloopOptimizer::Objective::Item)
+    {
+        ImGui::SetNextItemWidth(-FLT_MIN);
+        if (ImGui::BeginCombo("##somersloop_target", somersloop_optimizer.target == nullptr ? "Output..." : somersloop_optimizer.target->name.c_str()))
+        {
+            // Only current outputs of the factory can be maximized
+            for (const auto& [item, l] : ledger.items)
+            {
+                if (l.output.GetNumerator() > 0 && ImGui::Selectable(item->name.c_str(), item == somersloop_optimizer.target))
+                {
+                    somersloop_optimizer.target = item;
+                }
+            }
+            ImGui::EndCombo();
+        }
+    }
+
+    ImGui::SetNextItemWidth(ImGui::CalcTextSize("000000").x + ImGui::GetStyle().FramePadding.x * 2.0f + ImGui::GetFrameHeight() * 2.0f);
+    if (ImGui::InputInt("Somersloops", &somersloop_optimizer.budget))
+    {
+        somersloop_optimizer.budget = std::max(0, somersloop_optimizer.budget);
+    }
+
+    ImGui::BeginDisabled(somersloop_optimizer.objective == SomersloopOptimizer::Objective::Item && somersloop_optimizer.target == nullptr);
+    if (ImGui::Button("Optimize somersloops"))
+    {
+        std::vector<SomersloopOptimizer::Task> tasks;
+        somersloop_optimizer.recipes.clear();
+        somersloop_optimizer.current.clear();
+        for (const CraftNode* node : GetAllCraftNodes())
+        {
+            if (node->current_rate.GetNumerator() == 0)
+            {
+                continue;
+            }
+            tasks.push_back(SomersloopOptimizer::Task{ node->recipe, node->current_rate.GetValue(), static_cast<int>(node->num_somersloop.GetNumerator()) });
+            somersloop_optimizer.recipes.push_back(node->recipe);
+            somersloop_optimizer.current.push_back(static_cast<int>(node->num_somersloop.GetNumerator()));
+        }
+        // Imported intermediates are worth the raw resources needed to craft them
+        somersloop_optimizer.result = SomersloopOptimizer::Optimize(tasks, somersloop_optimizer.budget, somersloop_optimizer.objective, somersloop_optimizer.target, [&](const Item* item) {
+            const auto it = raw_costs.find(item);
+            return (Data::Graph().IsRaw(item) || it == raw_costs.end() || it->second.total <= 0.0) ? 1.0 : it->second.total;
+        });
+        somersloop_optimizer.has_result = true;
+    }
+    ImGui::EndDisabled();
+
+    if (!somersloop_optimizer.has_result || somersloop_optimizer.recipes.empty())
+    {
+        return;
+    }
+
+    const SomersloopOptimizer::Result& result = somersloop_optimizer.result;
+    if (somersloop_optimizer.objective == SomersloopOptimizer::Objective::Item)
+    {
+        ImGui::Text("%+.2f%% output for the same inputs", result.score_after > 0.0 ? 100.0 * (result.score_before / result.score_after - 1.0) : 0.0);
+    }
+    else
+    {
+        ImGui::Text("%.2f raw/min (%+.2f%%)", result.score_after, result.score_before > 0.0 ? 100.0 * (result.score_after / result.score_before - 1.0) : 0.0);
+    }
+    if (ImGui::IsItemHovered(ImGuiHoveredFlags_DelayNormal))
+    {
+        ImGui::SetTooltip("%s", "Compared to the current somersloops. Imported intermediate items are counted as their raw resources cost");
+    }
+    ImGui::Text("%d somersloops | %.2f MW (%+.2f)", result.used, result.power_after, result.power_after - result.power_before);
+
+    if (ImGui::TreeNodeEx("##somersloop_nodes", ImGuiTreeNodeFlags_FramePadding | ImGuiTreeNodeFlags_SpanAvailWidth, "%zu nodes", somersloop_optimizer.recipes.size()))
+    {
+        for (size_t i = 0; i < somersloop_optimizer.recipes.size(); ++i)
+        {
+            if (result.num_somersloop[i] == 0 && somersloop_optimizer.current[i] == 0)
+            {
+                continue;
+            }
+            if (result.num_somersloop[i] == somersloop_optimizer.current[i])
+            {
+                ImGui::Text("%d", result.num_somersloop[i]);
+            }
+            else
+            {
+                ImGui::Text("%d -> %d", somersloop_optimizer.current[i], result.num_somersloop[i]);
+            }
+            ImGui::SameLine();
+            RenderIcon(somersloop_icon);
+            ImGui::SameLine();
+            ImGui::Text("x %.2f", result.rates[i]);
+            ImGui::SameLine();
+            somersloop_optimizer.recipes[i]->Render();
+        }
+        ImGui::TreePop();
+    }
+}
+
+bool App::AlternateRankingState::Inputs::operator==(const Inputs& other) const
+{
+    return scope == other.scope && recipes_version == other.recipes_version && saves_version == other.saves_version && targets == other.targets;
+}
+
+void App::RenderAlternateRanking()
+{
+    ImGui::SeparatorText("Alternates ranking");
+    if (ImGui::IsItemHovered())
+    {
+        ImGui::SetTooltip("%s", "Raw resources and power each alternate would save if unlocked (or saves if already unlocked), for the same outputs");
+    }
+
+    ImGui::Checkbox("Rank alternates in background", &alternate_ranking.enabled);
+    if (!alternate_ranking.enabled)
+    {
+        return;
+    }
+
+    static constexpr std::array scope_names = { "Current factory outputs", "All saved files outputs" };
+    AlternateRankingState::Inputs& current = alternate_ranking.current;
+    ImGui::SetNextItemWidth(-FLT_MIN);
+    if (ImGui::BeginCombo("##ranking_scope", scope_names[static_cast<size_t>(current.scope)]))
+    {
+        for (size_t i = 0; i < scope_names.size(); ++i)
+        {
+            if (ImGui::Selectable(scope_names[i], i == static_cast<size_t>(current.scope)))
+            {
+                current.scope = static_cast<AlternateRankingState::Scope>(i);
+            }
+        }
+        ImGui::EndCombo();
+    }
+
+    // Ledger from the previous frame, it's only updated after the optimizers are rendered
+    current.targets.clear();
+    if (current.scope == AlternateRankingState::Scope::Factory)
+    {
+        for (const auto& [item, l] : ledger.items)
+        {
+            if (l.output.GetNumerator() > 0)
+            {
+                current.targets.emplace_back(item, l.output);
+            }
+        }
+    }
+
+    const auto sort_entries = [&]() {
+        std::stable_sort(alternate_ranking.result.entries.begin(), alternate_ranking.result.entries.end(), [&](const AlternateRanking::Entry& a, const AlternateRanking::Entry& b) {
+            if (a.required != b.required)
+            {
+                return a.required;
+            }
+            return alternate_ranking.sort_by_power ? a.power_saved > b.power_saved : a.raw_saved > b.raw_saved;
+        });
+    };
+
+    // Web version has no thread, deferred jobs run here when their result is requested
+    if (alternate_ranking.job.valid() && alternate_ranking.job.wait_for(std::chrono::seconds(0)) != std::future_status::timeout)
+    {
+        alternate_ranking.result = alternate_ranking.job.get();
+        alternate_ranking.ranked = alternate_ranking.running;
+        alternate_ranking.has_result = true;
+        sort_entries();
+    }
+
+    if (!alternate_ranking.job.valid() && (!alternate_ranking.has_result || !(alternate_ranking.ranked == current)))
+    {
+        std::vector<const Recipe*> usable;
+        std::vector<const Recipe*> alternates;
+        for (const auto& r : Data::Recipes())
+        {
+            if (IsRecipeUsable(r.get()))
+            {
+                usable.push_back(r.get());
+            }
+            if (r->alternate && (!settings.hide_spoilers || !r->is_spoiler))
+            {
+                alternates.push_back(r.get());
+            }
+        }
+
+        std::vector<std::pair<const Item*, double>> targets;
+        for (const auto& [item, rate] : current.targets)
+        {
+            targets.emplace_back(item, rate.GetValue());
+        }
+
+        // Files are read here as LoadFile can't be used outside of the main thread in the web version
+        std::vector<Json::Value> saves;
+        if (current.scope == AlternateRankingState::Scope::SavedFiles)
+        {
+            for (const std::string& f : ListSavedFiles(save_folder))
+            {
+                const std::optional<std::string> content = LoadFile(std::string(save_folder) + "/" + f + ".fcs");
+                if (!content.has_value())
+                {
+                    continue;
+                }
+                try
+                {
+                    Json::Value save = Json::Parse(content.value());
+                    if (!save.is_null() && save.size() > 0 && UpdateSave(save, SAVE_VERSION))
+                    {
+                        saves.push_back(std::move(save));
+                    }
+                }
+                catch (const std::exception&)
+                {
+                    continue;
+                }
+            }
+        }
+
+        alternate_ranking.running = current;
+        auto task = [usable = std::move(usable), alternates = std::move(alternates), targets = std::move(targets), saves = std::move(saves)]() mutable {
+            // All saved files are ranked as one big factory producing all their outputs
+            std::map<const Item*, double, ItemPtrCompare> outputs;
+            for (const Json::Value& save : saves)
+            {
+                for (const auto& [item, rate] : ScenarioSweep::Run(save, { ScenarioSweep::Scenario{ "", {} } })[0].totals.outputs)
+                {
+                    outputs[item] += rate.GetValue();
+                }
+            }
+            targets.insert(targets.end(), outputs.begin(), outputs.end());
+            return AlternateRanking::Rank(usable, alternates, targets);
+        };
+#if defined(__EMSCRIPTEN__)
+        alternate_ranking.job = std::async(std::launch::deferred, std::move(task));
+#else
+        alternate_ranking.job = std::async(std::launch::async, std::move(task));
+#endif
+    }
+
+    if (!alternate_ranking.has_result)
+    {
+        ImGui::TextDisabled("%s", "Ranking alternates...");
+        return;
+    }
+
+    const AlternateRanking::Result& result = alternate_ranking.result;
+    if (result.status != LinearProgram::Status::Optimal)
+    {
+        ImGui::TextDisabled("%s", alternate_ranking.ranked.scope == AlternateRankingState::Scope::Factory && alternate_ranking.ranked.targets.empty() ?
+            "No factory output to rank alternates" : "Outputs can't be produced with usable recipes");
+        return;
+    }
+
+    ImGui::Text("%.2f raw/min | %.2f MW", result.raw, result.power);
+    if (ImGui::IsItemHovered(ImGuiHoveredFlags_DelayNormal))
+    {
+        ImGui::SetTooltip("%s", "Minimal raw resources and power to produce the outputs from scratch with usable recipes");
+    }
+    if (!(alternate_ranking.ranked == current))
+    {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s", "(updating)");
+    }
+
+    if (ImGui::Checkbox("Sort by power", &alternate_ranking.sort_by_power))
+    {
+        sort_entries();
+    }
+
+    if (ImGui::TreeNodeEx("##alternate_ranking", ImGuiTreeNodeFlags_FramePadding | ImGuiTreeNodeFlags_SpanAvailWidth, "%zu alternates", result.entries.size()))
+    {
+        for (const AlternateRanking::Entry& entry : result.entries)
+        {
+            // Alternates never used in the optimal solutions
+            if (!entry.required && std::abs(entry.raw_saved) < 1e-3 && std::abs(entry.power_saved) < 1e-3)
+            {
+                continue;
+            }
+            if (entry.required)
+            {
+                ImGui::TextUnformatted("Required");
+            }
+            else
+            {
+                ImGui::Text("%.2f raw/min | %.2f MW", entry.raw_saved, entry.power_saved);
+            }
+            ImGui::SameLine();
+            ImGui::BeginDisabled(entry.unlocked);
+            entry.recipe->Render();
+            ImGui::EndDisabled();
+            if (entry.unlocked && ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled | ImGuiHoveredFlags_DelayNormal))
+            {
+                ImGui::SetTooltip("%s", "Already unlocked, savings lost without it");
+            }
+        }
+        ImGui::TreePop();
+    }
+}
+
 void App::RenderControlsPopup()
 {
     if (ImGui::BeginTable("##controls_table", 2, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
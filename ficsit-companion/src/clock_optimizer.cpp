@@ -0,0 +1,467 @@
+#include "clock_optimizer.hpp"
+#include "building.hpp"
+#include "recipe.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <tuple>
+
+namespace ClockOptimizer
+{
+    namespace
+    {
+        constexpr double epsilon = 1e-9;
+        /// @brief Clock increase for each shard in a machine
+        constexpr double shard_clock = 0.5;
+        constexpr double min_clock = 0.01;
+        /// @brief When minimizing power, max number of machines of a node relative to its number of machines at 100%
+        constexpr int max_overbuild_factor = 4;
+        /// @brief Max number of bisection steps on the shards multiplier
+        constexpr int multiplier_steps = 30;
+        /// @brief Stop the bisection when the multiplier is known with this relative precision
+        constexpr double multiplier_tolerance = 1e-4;
+        /// @brief Max number of (task, machines, shards) combinations tried by the exact search
+        constexpr size_t max_exact_evaluations = 20000000;
+        /// @brief Max size of the exact search table, one entry per (task, machines used, shards used)
+        constexpr size_t max_exact_table_size = 4000000;
+
+        int MinMachines(const double rate)
+        {
+            return std::max(1, static_cast<int>(std::ceil(rate / max_clock - epsilon)));
+        }
+
+        /// @brief Min number of shards for some machines to reach a rate
+        int MinShards(const double rate, const int machines)
+        {
+            return std::max(0, static_cast<int>(std::ceil((rate - machines) / shard_clock - epsilon)));
+        }
+
+        /// @brief Number of shards for some machines to reach a rate with all machines at the same clock
+        int EqualClockShards(const double rate, const int machines)
+        {
+            const double clock = rate / machines;
+            return clock <= 1.0 + epsilon ? 0 : machines * static_cast<int>(std::ceil((clock - 1.0) / shard_clock - epsilon));
+        }
+
+        /// @brief Number of machines and shards of a node, without the clocks details
+        struct Choice
+        {
+            int machines = 0;
+            int shards = 0;
+            double power = 0.0;
+        };
+
+        /// @brief Compute the lowest power for a given number of machines and shards.
+        /// Power is convex in the clock, so the best is to spread shards evenly and have all machines
+        /// as close as possible to the same clock: extra machines with one more shard at high_clock,
+        /// the others at their max clock (or all machines at the same clock if shards are not limiting)
+        /// @param groups If not nullptr, filled with the machines details
+        Choice Evaluate(const Task& task, const int machines, const int shards, std::vector<MachineGroup>* groups = nullptr)
+        {
+            const int per_machine = shards / machines;
+            const int extra = shards % machines;
+            const double low_cap = 1.0 + shard_clock * per_machine;
+            const double level = task.rate / machines;
+            const double machine_power = task.recipe->power * task.somersloop_power_factor;
+            const double exponent = task.recipe->building->power_exponent;
+
+            Choice choice;
+            choice.machines = machines;
+            if (level <= low_cap + epsilon || extra == 0)
+            {
+                choice.shards = machines * MinShards(level, 1);
+                choice.power = machines * machine_power * std::pow(level, exponent);
+                if (groups != nullptr)
+                {
+                    groups->push_back(MachineGroup{ machines, MinShards(level, 1), level });
+                }
+            }
+            else
+            {
+                const double high_clock = (task.rate - (machines - extra) * low_cap) / extra;
+                choice.shards = shards;
+                choice.power = machine_power * (extra * std::pow(high_clock, exponent) + (machines - extra) * std::pow(low_cap, exponent));
+                if (groups != nullptr)
+                {
+                    groups->push_back(MachineGroup{ extra, per_machine + 1, high_clock });
+                    if (machines > extra)
+                    {
+                        groups->push_back(MachineGroup{ machines - extra, per_machine, low_cap });
+                    }
+                }
+            }
+            return choice;
+        }
+
+        /// @brief Get the choice minimizing power + multiplier * shards for a number of machines
+        Choice BestChoice(const Task& task, const int machines, const double multiplier)
+        {
+            const int min_shards = MinShards(task.rate, machines);
+            const int max_shards_needed = std::max(min_shards, EqualClockShards(task.rate, machines));
+            if (multiplier == 0.0)
+            {
+                return Evaluate(task, machines, max_shards_needed);
+            }
+            // Cost is convex in the number of shards, binary search on its slope
+            auto cost = [&](const int shards) {
+                return Evaluate(task, machines, shards).power + multiplier * shards;
+            };
+            int lo = min_shards;
+            int hi = max_shards_needed;
+            while (lo < hi)
+            {
+                const int mid = lo + (hi - lo) / 2;
+                if (cost(mid + 1) < cost(mid))
+                {
+                    lo = mid + 1;
+                }
+                else
+                {
+                    hi = mid;
+                }
+            }
+            return Evaluate(task, machines, lo);
+        }
+
+        int MaxMachines(const Task& task, const Objective objective)
+        {
+            const int full_clock_machines = std::max(MinMachines(task.rate), static_cast<int>(std::ceil(task.rate - epsilon)));
+            if (objective == Objective::Buildings)
+            {
+                return full_clock_machines;
+            }
+            return std::max(MinMachines(task.rate), std::min(max_overbuild_factor * full_clock_machines, static_cast<int>(std::floor(task.rate / min_clock))));
+        }
+
+        /// @brief Choices of all tasks and their totals
+        struct Allocation
+        {
+            bool feasible = false;
+            std::vector<Choice> choices;
+            int machines = 0;
+            int shards = 0;
+            double power = 0.0;
+
+            void Set(const size_t i, const Choice& choice)
+            {
+                machines += choice.machines - choices[i].machines;
+                shards += choice.shards - choices[i].shards;
+                power += choice.power - choices[i].power;
+                choices[i] = choice;
+            }
+        };
+
+        /// @brief Allocate machines one by one to the node with the best decrease of power + multiplier * shards
+        Allocation AllocateMachines(const std::vector<Task>& tasks, const int machine_budget, const double multiplier)
+        {
+            Allocation allocation;
+            allocation.choices.resize(tasks.size());
+            for (size_t i = 0; i < tasks.size(); ++i)
+            {
+                if (tasks[i].rate > epsilon)
+                {
+                    allocation.Set(i, BestChoice(tasks[i], MinMachines(tasks[i].rate), multiplier));
+                }
+            }
+            if (allocation.machines > machine_budget)
+            {
+                return allocation;
+            }
+
+            auto cost = [&](const Choice& c) { return c.power + multiplier * c.shards; };
+            // (gain, task index), the choice with one more machine is stored in next_choices
+            std::priority_queue<std::pair<double, size_t>> candidates;
+            std::vector<Choice> next_choices(tasks.size());
+            auto push_candidate = [&](const size_t i) {
+                const int next_machines = allocation.choices[i].machines + 1;
+                if (next_machines <= MaxMachines(tasks[i], Objective::Power))
+                {
+                    next_choices[i] = BestChoice(tasks[i], next_machines, multiplier);
+                    candidates.emplace(cost(allocation.choices[i]) - cost(next_choices[i]), i);
+                }
+            };
+            for (size_t i = 0; i < tasks.size(); ++i)
+            {
+                if (tasks[i].rate > epsilon)
+                {
+                    push_candidate(i);
+                }
+            }
+
+            while (allocation.machines < machine_budget && !candidates.empty())
+            {
+                const auto [gain, i] = candidates.top();
+                candidates.pop();
+                if (gain <= epsilon)
+                {
+                    break;
+                }
+                allocation.Set(i, next_choices[i]);
+                push_candidate(i);
+            }
+
+            allocation.feasible = true;
+            return allocation;
+        }
+
+        /// @brief Use remaining shards where they save the most power, without changing the number of machines
+        void SpendShards(const std::vector<Task>& tasks, Allocation& allocation, const int shard_budget)
+        {
+            std::priority_queue<std::pair<double, size_t>> candidates;
+            std::vector<Choice> next_choices(tasks.size());
+            auto push_candidate = [&](const size_t i) {
+                const Choice& current = allocation.choices[i];
+                if (current.machines == 0 || current.shards >= EqualClockShards(tasks[i].rate, current.machines))
+                {
+                    return;
+                }
+                next_choices[i] = Evaluate(tasks[i], current.machines, current.shards + 1);
+                candidates.emplace(current.power - next_choices[i].power, i);
+            };
+            for (size_t i = 0; i < tasks.size(); ++i)
+            {
+                push_candidate(i);
+            }
+
+            while (allocation.shards < shard_budget && !candidates.empty())
+            {
+                const size_t i = candidates.top().second;
+                candidates.pop();
+                allocation.Set(i, next_choices[i]);
+                push_candidate(i);
+            }
+        }
+
+        /// @brief Find the min power with both budgets by dynamic programming over the tasks, on the
+        /// number of machines and shards used so far. Only for small problems
+        /// @return The best allocation, nullopt if the problem is too big
+        std::optional<Allocation> MinimizePowerExact(const std::vector<Task>& tasks, const int machine_budget, const int shard_budget)
+        {
+            // Options of each task, more shards than needed for equal clocks never save power
+            std::vector<std::vector<Choice>> options(tasks.size());
+            int max_machines = 0;
+            int max_shards = 0;
+            size_t num_options = 0;
+            for (size_t i = 0; i < tasks.size(); ++i)
+            {
+                if (tasks[i].rate <= epsilon)
+                {
+                    continue;
+                }
+                int task_max_shards = 0;
+                for (int machines = MinMachines(tasks[i].rate); machines <= MaxMachines(tasks[i], Objective::Power); ++machines)
+                {
+                    const int min_shards = MinShards(tasks[i].rate, machines);
+                    const int shards_needed = std::max(min_shards, EqualClockShards(tasks[i].rate, machines));
+                    for (int shards = min_shards; shards <= shards_needed; ++shards)
+                    {
+                        options[i].push_back(Evaluate(tasks[i], machines, shards));
+                    }
+                    task_max_shards = std::max(task_max_shards, shards_needed);
+                    if (options[i].size() > max_exact_evaluations)
+                    {
+                        return std::nullopt;
+                    }
+                }
+                max_machines += MaxMachines(tasks[i], Objective::Power);
+                max_shards += task_max_shards;
+                num_options += options[i].size();
+            }
+            const size_t num_machines = static_cast<size_t>(std::min(machine_budget, max_machines)) + 1;
+            const size_t num_shards = static_cast<size_t>(std::min(shard_budget, max_shards)) + 1;
+            const size_t table_size = num_machines * num_shards;
+            if (tasks.size() * table_size > max_exact_table_size || num_options * table_size > max_exact_evaluations)
+            {
+                return std::nullopt;
+            }
+
+            // Min power for each number of machines and shards used by the tasks so far, and the option chosen
+            // for each task to backtrack from the best final state
+            constexpr double unreachable = std::numeric_limits<double>::infinity();
+            std::vector<double> power(table_size, unreachable);
+            std::vector<double> next_power(table_size);
+            std::vector<std::vector<int>> chosen(tasks.size());
+            power[0] = 0.0;
+            for (size_t i = 0; i < tasks.size(); ++i)
+            {
+                if (options[i].empty())
+                {
+                    continue;
+                }
+                std::fill(next_power.begin(), next_power.end(), unreachable);
+                chosen[i].assign(table_size, -1);
+                for (size_t used = 0; used < table_size; ++used)
+                {
+                    if (power[used] == unreachable)
+                    {
+                        continue;
+                    }
+                    const size_t used_machines = used / num_shards;
+                    const size_t used_shards = used % num_shards;
+                    for (size_t o = 0; o < options[i].size(); ++o)
+                    {
+                        const Choice& option = options[i][o];
+                        if (used_machines + option.machines >= num_machines || used_shards + option.shards >= num_shards)
+                        {
+                            continue;
+                        }
+                        const size_t next = used + option.machines * num_shards + option.shards;
+                        if (power[used] + option.power < next_power[next])
+                        {
+                            next_power[next] = power[used] + option.power;
+                            chosen[i][next] = static_cast<int>(o);
+                        }
+                    }
+                }
+                std::swap(power, next_power);
+            }
+
+            Allocation allocation;
+            allocation.choices.resize(tasks.size());
+            const size_t best = std::min_element(power.begin(), power.end()) - power.begin();
+            if (power[best] == unreachable)
+            {
+                return allocation;
+            }
+            size_t used = best;
+            for (size_t i = tasks.size(); i-- > 0;)
+            {
+                if (options[i].empty())
+                {
+                    continue;
+                }
+                const Choice& option = options[i][chosen[i][used]];
+                allocation.Set(i, option);
+                used -= option.machines * num_shards + option.shards;
+            }
+            allocation.feasible = true;
+            return allocation;
+        }
+
+        Allocation MinimizePower(const std::vector<Task>& tasks, const int machine_budget, const std::optional<int>& shard_budget)
+        {
+            Allocation allocation = AllocateMachines(tasks, machine_budget, 0.0);
+            if (!allocation.feasible || !shard_budget.has_value() || allocation.shards <= shard_budget.value())
+            {
+                return allocation;
+            }
+
+            // The Lagrangian search below has a duality gap, small problems are solved exactly instead
+            if (std::optional<Allocation> exact = MinimizePowerExact(tasks, machine_budget, shard_budget.value()); exact.has_value())
+            {
+                return std::move(exact.value());
+            }
+
+            // Increase the shards cost until the budget is respected
+            double lo = 0.0;
+            double hi = 1.0;
+            Allocation hi_allocation = AllocateMachines(tasks, machine_budget, hi);
+            while (hi_allocation.shards > shard_budget.value())
+            {
+                hi *= 4.0;
+                if (hi > 1e9)
+                {
+                    hi_allocation.feasible = false;
+                    return hi_allocation;
+                }
+                hi_allocation = AllocateMachines(tasks, machine_budget, hi);
+            }
+            // Remaining shards after the bisection are spent greedily, so an approximate multiplier is enough
+            for (int step = 0; step < multiplier_steps && hi_allocation.shards < shard_budget.value() && hi - lo > multiplier_tolerance * hi; ++step)
+            {
+                const double mid = 0.5 * (lo + hi);
+                Allocation mid_allocation = AllocateMachines(tasks, machine_budget, mid);
+                if (mid_allocation.shards > shard_budget.value())
+                {
+                    lo = mid;
+                }
+                else
+                {
+                    hi = mid;
+                    hi_allocation = std::move(mid_allocation);
+                }
+            }
+
+            SpendShards(tasks, hi_allocation, shard_budget.value());
+            return hi_allocation;
+        }
+
+        Allocation MinimizeBuildings(const std::vector<Task>& tasks, const int machine_budget, const std::optional<int>& shard_budget)
+        {
+            Allocation allocation;
+            allocation.choices.resize(tasks.size());
+            for (size_t i = 0; i < tasks.size(); ++i)
+            {
+                if (tasks[i].rate > epsilon)
+                {
+                    const int machines = MinMachines(tasks[i].rate);
+                    allocation.Set(i, Evaluate(tasks[i], machines, shard_budget.has_value() ? MinShards(tasks[i].rate, machines) : EqualClockShards(tasks[i].rate, machines)));
+                }
+            }
+
+            if (shard_budget.has_value())
+            {
+                // Add machines where it saves the most shards until the budget is respected, ties broken by smallest power increase
+                std::priority_queue<std::tuple<int, double, size_t>> candidates;
+                std::vector<Choice> next_choices(tasks.size());
+                auto push_candidate = [&](const size_t i) {
+                    const int machines = allocation.choices[i].machines;
+                    if (machines == 0 || machines + 1 > MaxMachines(tasks[i], Objective::Buildings))
+                    {
+                        return;
+                    }
+                    next_choices[i] = Evaluate(tasks[i], machines + 1, MinShards(tasks[i].rate, machines + 1));
+                    candidates.emplace(allocation.choices[i].shards - next_choices[i].shards, allocation.choices[i].power - next_choices[i].power, i);
+                };
+                for (size_t i = 0; i < tasks.size(); ++i)
+                {
+                    push_candidate(i);
+                }
+                while (allocation.shards > shard_budget.value() && !candidates.empty())
+                {
+                    const size_t i = std::get<2>(candidates.top());
+                    candidates.pop();
+                    allocation.Set(i, next_choices[i]);
+                    push_candidate(i);
+                }
+                if (allocation.shards > shard_budget.value())
+                {
+                    return allocation;
+                }
+                SpendShards(tasks, allocation, shard_budget.value());
+            }
+
+            allocation.feasible = allocation.machines <= machine_budget;
+            return allocation;
+        }
+    }
+
+    Result Optimize(const std::vector<Task>& tasks, const Objective objective, const int machine_budget, const std::optional<int>& shard_budget)
+    {
+        const Allocation allocation = objective == Objective::Power ?
+            MinimizePower(tasks, machine_budget, shard_budget) :
+            MinimizeBuildings(tasks, machine_budget, shard_budget);
+
+        Result result;
+        result.feasible = allocation.feasible;
+        result.machines = allocation.machines;
+        result.shards = allocation.shards;
+        result.power = allocation.power;
+        result.setups.resize(tasks.size());
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            const Choice& choice = allocation.choices[i];
+            if (choice.machines > 0)
+            {
+                Setup& setup = result.setups[i];
+                setup.machines = choice.machines;
+                setup.shards = choice.shards;
+                setup.power = choice.power;
+                Evaluate(tasks[i], choice.machines, choice.shards, &setup.groups);
+            }
+        }
+        return result;
+    }
+}
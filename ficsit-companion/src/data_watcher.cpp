@@ -0,0 +1,136 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "data_watcher.hpp"
+
+namespace
+{
+    /// @brief How often the stop flag (and the modification date when inotify isn't available) is checked
+    constexpr auto check_period = std::chrono::milliseconds(250);
+    /// @brief Time waited after a modification before reading the file, so a save written in several steps is read only once
+    constexpr auto debounce_delay = std::chrono::milliseconds(100);
+
+    std::string ReadContent(const std::string& path)
+    {
+        std::ifstream f(path, std::ios::in | std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    }
+}
+
+DataWatcher::DataWatcher(const std::string& path) : path(path), stop(false)
+{
+#if !defined(__EMSCRIPTEN__)
+    thread = std::thread(&DataWatcher::Watch, this);
+#endif
+}
+
+DataWatcher::~DataWatcher()
+{
+    stop = true;
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+}
+
+std::optional<Json::Value> DataWatcher::TakeChange()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::optional<Json::Value> output = std::move(change);
+    change.reset();
+    return output;
+}
+
+void DataWatcher::Watch()
+{
+    content = ReadContent(path);
+
+#if defined(__linux__)
+    // Watch the folder instead of the file, editors often save by replacing the file with a new one
+    const std::filesystem::path file_path = std::filesystem::absolute(path);
+    const std::string filename = file_path.filename().string();
+    const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    const int wd = fd < 0 ? -1 : inotify_add_watch(fd, file_path.parent_path().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd >= 0)
+    {
+        alignas(inotify_event) char buffer[4096];
+        while (!stop)
+        {
+            pollfd pfd{ fd, POLLIN, 0 };
+            if (poll(&pfd, 1, static_cast<int>(check_period.count())) <= 0)
+            {
+                continue;
+            }
+
+            bool modified = false;
+            ssize_t length;
+            while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+            {
+                for (ssize_t i = 0; i < length; i += sizeof(inotify_event) + reinterpret_cast<const inotify_event*>(buffer + i)->len)
+                {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + i);
+                    modified |= event->len > 0 && filename == event->name;
+                }
+            }
+
+            if (modified)
+            {
+                std::this_thread::sleep_for(debounce_delay);
+                // Drop the events of the rest of the save
+                while (read(fd, buffer, sizeof(buffer)) > 0) {}
+                ReadFile();
+            }
+        }
+        close(fd);
+        return;
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+#endif
+
+    // Fallback if inotify isn't available, check the modification date
+    std::error_code ec;
+    std::filesystem::file_time_type last_write = std::filesystem::last_write_time(path, ec);
+    while (!stop)
+    {
+        std::this_thread::sleep_for(check_period);
+        const std::filesystem::file_time_type write = std::filesystem::last_write_time(path, ec);
+        if (!ec && write != last_write)
+        {
+            last_write = write;
+            std::this_thread::sleep_for(debounce_delay);
+            ReadFile();
+        }
+    }
+}
+
+void DataWatcher::ReadFile()
+{
+    std::string new_content = ReadContent(path);
+    if (new_content.empty() || new_content == content)
+    {
+        return;
+    }
+    content = std::move(new_content);
+
+    try
+    {
+        Json::Value parsed = Json::Parse(content, false, true);
+        std::lock_guard<std::mutex> lock(mutex);
+        change = std::move(parsed);
+    }
+    catch (const std::exception&)
+    {
+        // File is probably still being edited, wait for the next save
+    }
+}
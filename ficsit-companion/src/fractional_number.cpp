@@ -4,7 +4,9 @@
 // For InputText with std::string
 #include <misc/cpp/imgui_stdlib.h>
 
+#include <cctype>
 #include <iomanip>
+#include <limits>
 #include <numeric>
 #include <regex>
 #include <sstream>
@@ -66,6 +68,102 @@ FractionalNumber::FractionalNumber(const std::string& s)
     Simplify();
 }
 
+FractionalNumber FractionalNumber::FromDecimal(std::string_view literal)
+{
+    constexpr long long int max_value = std::numeric_limits<long long int>::max();
+    // Append one digit to an accumulated value, checking for overflow
+    const auto push_digit = [](long long int& value, const char c) {
+        if (value > (max_value - (c - '0')) / 10)
+        {
+            throw std::domain_error("Decimal value too large for a fraction");
+        }
+        value = value * 10 + (c - '0');
+    };
+
+    size_t index = 0;
+    const bool negative = index < literal.size() && literal[index] == '-';
+    if (negative || (index < literal.size() && literal[index] == '+'))
+    {
+        index += 1;
+    }
+
+    long long int mantissa = 0;
+    int exponent = 0;
+    size_t num_digits = 0;
+    for (; index < literal.size() && std::isdigit(static_cast<unsigned char>(literal[index])); ++index, ++num_digits)
+    {
+        push_digit(mantissa, literal[index]);
+    }
+    if (index < literal.size() && literal[index] == '.')
+    {
+        for (index += 1; index < literal.size() && std::isdigit(static_cast<unsigned char>(literal[index])); ++index, ++num_digits)
+        {
+            // Trailing zeros after the point don't add precision, skip them to keep large values representable
+            if (literal[index] == '0' && literal.find_first_not_of('0', index) >= literal.size())
+            {
+                continue;
+            }
+            push_digit(mantissa, literal[index]);
+            exponent -= 1;
+        }
+    }
+    if (num_digits == 0)
+    {
+        throw std::domain_error("Invalid decimal literal");
+    }
+
+    if (index < literal.size() && (literal[index] == 'e' || literal[index] == 'E'))
+    {
+        index += 1;
+        const bool negative_exponent = index < literal.size() && literal[index] == '-';
+        if (negative_exponent || (index < literal.size() && literal[index] == '+'))
+        {
+            index += 1;
+        }
+        long long int exponent_value = 0;
+        const size_t exponent_start = index;
+        for (; index < literal.size() && std::isdigit(static_cast<unsigned char>(literal[index])); ++index)
+        {
+            push_digit(exponent_value, literal[index]);
+        }
+        if (index == exponent_start || exponent_value > std::numeric_limits<long long int>::digits10)
+        {
+            throw std::domain_error("Invalid decimal exponent");
+        }
+        exponent += static_cast<int>(negative_exponent ? -exponent_value : exponent_value);
+    }
+    if (index != literal.size())
+    {
+        throw std::domain_error("Invalid decimal literal");
+    }
+
+    long long int denominator = 1;
+    for (; exponent < 0; ++exponent)
+    {
+        // Remove common factors first so "0.5000e-10" style literals stay in range as long as the result does
+        if (mantissa % 10 == 0)
+        {
+            mantissa /= 10;
+            continue;
+        }
+        if (denominator > max_value / 10)
+        {
+            throw std::domain_error("Decimal value too small for a fraction");
+        }
+        denominator *= 10;
+    }
+    for (; exponent > 0; --exponent)
+    {
+        if (mantissa > max_value / 10)
+        {
+            throw std::domain_error("Decimal value too large for a fraction");
+        }
+        mantissa *= 10;
+    }
+
+    return FractionalNumber(negative ? -mantissa : mantissa, denominator);
+}
+
 long long int FractionalNumber::GetNumerator() const
 {
     return numerator;
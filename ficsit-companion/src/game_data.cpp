@@ -1,110 +1,558 @@
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <map>
 #include <stdexcept>
+#include <type_traits>
 
 #include "building.hpp"
 #include "game_data.hpp"
 #include "json.hpp"
 #include "recipe.hpp"
+#include "recipe_graph.hpp"
+#include "search_index.hpp"
+#include "startup_timeline.hpp"
 
 namespace Data
 {
     namespace // anonymous namespace to store the game data
     {
-        std::string version;
-        std::unordered_map<std::string, std::unique_ptr<Item>> items;
-        std::unordered_map<std::string, std::unique_ptr<Building>> buildings;
-        std::vector<std::unique_ptr<Recipe>> recipes;
+        /// @brief Everything loaded from one game data file
+        struct Dataset
+        {
+            std::string game;
+            std::string version;
+            std::unordered_map<std::string, std::shared_ptr<Item>> items;
+            std::unordered_map<std::string, std::shared_ptr<Building>> buildings;
+            std::vector<std::shared_ptr<Recipe>> recipes;
+            std::unordered_map<std::string, std::shared_ptr<Recipe>> recipes_by_name;
+            SearchIndex recipe_search_index;
+            RecipeGraph graph;
+        };
+
+        /// @brief All loaded datasets by game name. They are kept loaded so switching back to one doesn't parse it again
+        std::map<std::string, std::unique_ptr<Dataset>> datasets;
+        /// @brief Empty dataset used until some data is loaded
+        Dataset no_data;
+        /// @brief Dataset returned by all the accessors
+        const Dataset* current = &no_data;
+
+        /// @brief Folder where additional data files (modded or older versions) are found
+        constexpr std::string_view datasets_folder = "datasets";
     }
 
-    void LoadData(const std::string& game)
+    namespace
     {
-        if (!std::filesystem::exists(game + ".json"))
+        /// @brief Version of the binary database layout, must match FORMAT_VERSION in scripts/generate_game_database.py
+        constexpr uint32_t database_format_version = 1;
+
+        uint64_t Fnv1a(const std::string& data)
         {
-            throw std::runtime_error("Data file not found for game " + game);
+            uint64_t hash = 0xcbf29ce484222325ULL;
+            for (const char c : data)
+            {
+                hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+            }
+            return hash;
+        }
+
+        /// @brief Read values from a binary database loaded in memory. Values are stored in little endian
+        class DatabaseReader
+        {
+        public:
+            DatabaseReader(const std::string& data) : data(data), position(0) {}
+
+            template<typename T>
+            T Read()
+            {
+                static_assert(std::is_trivially_copyable_v<T>);
+                if (position + sizeof(T) > data.size())
+                {
+                    throw std::runtime_error("Unexpected end of game database");
+                }
+                T value;
+                std::memcpy(&value, data.data() + position, sizeof(T));
+                position += sizeof(T);
+                return value;
+            }
+
+            std::string ReadString()
+            {
+                const uint32_t size = Read<uint32_t>();
+                if (position + size > data.size())
+                {
+                    throw std::runtime_error("Unexpected end of game database");
+                }
+                std::string s = data.substr(position, size);
+                position += size;
+                return s;
+            }
+
+            FractionalNumber ReadFraction()
+            {
+                const int64_t numerator = Read<int64_t>();
+                const int64_t denominator = Read<int64_t>();
+                return FractionalNumber(numerator, denominator);
+            }
+
+        private:
+            const std::string& data;
+            size_t position;
+        };
+
+        std::string ReadFile(const std::string& path, const std::ios::openmode mode = std::ios::in)
+        {
+            std::ifstream f(path, mode);
+            std::string content(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>{});
+            StartupTimeline::Add(StartupTimeline::Counter::FilesRead, 1);
+            StartupTimeline::Add(StartupTimeline::Counter::BytesRead, content.size());
+            return content;
+        }
+
+        bool operator==(const Building& a, const Building& b)
+        {
+            return a.name == b.name &&
+                a.somersloop_mult == b.somersloop_mult &&
+                a.power == b.power &&
+                a.power_exponent == b.power_exponent &&
+                a.somersloop_power_exponent == b.somersloop_power_exponent &&
+                a.variable_power == b.variable_power;
+        }
+
+        bool operator==(const Item& a, const Item& b)
+        {
+            return a.name == b.name && a.icon == b.icon && a.is_resource == b.is_resource;
+        }
+
+        bool operator==(const std::vector<CountedItem>& a, const std::vector<CountedItem>& b)
+        {
+            return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const CountedItem& x, const CountedItem& y) {
+                return x.item == y.item && x.quantity == y.quantity;
+            });
         }
 
-        items.clear();
-        recipes.clear();
-        version = "";
+        bool operator==(const Recipe& a, const Recipe& b)
+        {
+            return a.name == b.name &&
+                a.ins == b.ins &&
+                a.outs == b.outs &&
+                a.building == b.building &&
+                a.alternate == b.alternate &&
+                a.is_spoiler == b.is_spoiler &&
+                a.power == b.power;
+        }
 
-        std::ifstream f(game + ".json");
-        Json::Value data;
-        f >> data;
-        f.close();
+        template <class T>
+        std::shared_ptr<T> Find(const std::unordered_map<std::string, std::shared_ptr<T>>& objects, const std::string& name)
+        {
+            const auto it = objects.find(name);
+            return it == objects.end() ? nullptr : it->second;
+        }
 
-        version = data["version"].get_string();
+        std::shared_ptr<Item> FindIn(const Dataset& dataset, const Item& item) { return Find(dataset.items, item.name); }
+        std::shared_ptr<Building> FindIn(const Dataset& dataset, const Building& building) { return Find(dataset.buildings, building.name); }
+        std::shared_ptr<Recipe> FindIn(const Dataset& dataset, const Recipe& recipe) { return Find(dataset.recipes_by_name, recipe.name); }
 
-        for (const auto& b : data["buildings"].get_array())
+        /// @brief Get an object identical to a new one from the loaded datasets, so identical entries are shared between
+        /// datasets and keep the same address when a dataset is reloaded
+        /// @param created New object
+        /// @return The existing identical object if there is one, created otherwise
+        template <class T>
+        std::shared_ptr<T> Share(std::shared_ptr<T>&& created)
         {
-            const std::string& name = b["name"].get_string();
-            buildings[name] = std::make_unique<Building>(
+            for (const auto& [game, dataset] : datasets)
+            {
+                if (std::shared_ptr<T> existing = FindIn(*dataset, *created); existing != nullptr && *existing == *created)
+                {
+                    return existing;
+                }
+            }
+            return std::move(created);
+        }
+
+        /// @brief Load game data from the binary database generated at build time
+        /// @param path Path to the database file
+        /// @param json_content Content of the json data file, the database is only used if it was generated from it
+        /// @param load_icons If false, items icons are not loaded
+        /// @param dataset Dataset to fill
+        /// @return False if the database can't be used
+        bool LoadDatabase(const std::string& path, const std::string& json_content, const bool load_icons, Dataset& dataset)
+        {
+            if (!std::filesystem::exists(path))
+            {
+                return false;
+            }
+
+            StartupTimeline::ScopedTimer timer("Load game database");
+            const std::string content = ReadFile(path, std::ios::in | std::ios::binary);
+            DatabaseReader reader(content);
+            try
+            {
+                if (reader.Read<uint32_t>() != 0x42444346 /* "FCDB" */ ||
+                    reader.Read<uint32_t>() != database_format_version ||
+                    reader.Read<uint64_t>() != json_content.size() ||
+                    reader.Read<uint64_t>() != Fnv1a(json_content))
+                {
+                    return false;
+                }
+
+                dataset.version = reader.ReadString();
+
+                std::vector<const Building*> building_list(reader.Read<uint32_t>());
+                for (auto& b : building_list)
+                {
+                    const std::string name = reader.ReadString();
+                    const FractionalNumber somersloop_mult = reader.ReadFraction();
+                    const double power = reader.Read<double>();
+                    const double power_exponent = reader.Read<double>();
+                    const double somersloop_power_exponent = reader.Read<double>();
+                    const bool variable_power = reader.Read<uint8_t>() != 0;
+                    auto& building = dataset.buildings[name];
+                    building = Share(std::make_shared<Building>(name, somersloop_mult, power, power_exponent, somersloop_power_exponent, variable_power));
+                    b = building.get();
+                }
+
+                std::vector<const Item*> item_list(reader.Read<uint32_t>());
+                for (auto& i : item_list)
+                {
+                    const std::string name = reader.ReadString();
+                    const std::string icon = reader.ReadString();
+                    const bool is_resource = reader.Read<uint8_t>() != 0;
+                    auto& item = dataset.items[name];
+                    item = Share(std::make_shared<Item>(name, load_icons ? icon : "", is_resource));
+                    i = item.get();
+                }
+
+                const uint32_t num_recipes = reader.Read<uint32_t>();
+                dataset.recipes.reserve(num_recipes);
+                for (uint32_t r = 0; r < num_recipes; ++r)
+                {
+                    const std::string name = reader.ReadString();
+                    const Building* building = building_list.at(reader.Read<uint32_t>());
+                    const bool alternate = reader.Read<uint8_t>() != 0;
+                    const bool is_spoiler = reader.Read<uint8_t>() != 0;
+                    const double power = reader.Read<double>();
+                    std::vector<CountedItem> inputs(reader.Read<uint32_t>(), CountedItem(nullptr, FractionalNumber()));
+                    for (auto& i : inputs)
+                    {
+                        const Item* item = item_list.at(reader.Read<uint32_t>());
+                        i = CountedItem(item, reader.ReadFraction());
+                    }
+                    std::vector<CountedItem> outputs(reader.Read<uint32_t>(), CountedItem(nullptr, FractionalNumber()));
+                    for (auto& o : outputs)
+                    {
+                        const Item* item = item_list.at(reader.Read<uint32_t>());
+                        o = CountedItem(item, reader.ReadFraction());
+                    }
+                    dataset.recipes.emplace_back(Share(std::make_shared<Recipe>(inputs, outputs, building, alternate, power, name, is_spoiler)));
+                }
+            }
+            catch (const std::exception&)
+            {
+                // Malformed database, fallback to the json file
+                return false;
+            }
+
+            return true;
+        }
+
+        void LoadBuilding(const Json::Value& b, Dataset& dataset)
+        {
+            const std::string name(b["name"].get_string_view());
+            dataset.buildings[name] = Share(std::make_shared<Building>(
                 name,
-                FractionalNumber(std::to_string(b["somersloop_mult"].get<double>())),
+                FractionalNumber::FromDecimal(b["somersloop_mult"].get_number_literal()),
                 b["power"].get<double>(),
                 b["power_exponent"].get<double>(),
                 b["somersloop_power_exponent"].get<double>(),
                 b["variable_power"].get<bool>()
-            );
+            ));
         }
 
-        for (const auto& i : data["items"].get_array())
+        void LoadItem(const Json::Value& i, const bool load_icons, Dataset& dataset)
         {
-            const std::string& name = i["name"].get_string();
-            items[name] = std::make_unique<Item>(name, i["icon"].get_string());
+            const std::string name(i["name"].get_string_view());
+            dataset.items[name] = Share(std::make_shared<Item>(name, load_icons ? std::string(i["icon"].get_string_view()) : "", i.contains("resource") && i["resource"].get<bool>()));
         }
 
-        const Json::Array& json_recipes = data["recipes"].get_array();
-
-        for (const auto& r : json_recipes)
+        /// @brief Load one recipe, its items and building must already be loaded
+        void LoadRecipe(const Json::Value& r, Dataset& dataset)
         {
-            const double time = r["time"].get<double>();
+            // Amounts are converted to items/min from the exact decimal text, not the parsed double
+            const FractionalNumber per_minute = FractionalNumber(60) / FractionalNumber::FromDecimal(r["time"].get_number_literal());
             std::vector<CountedItem> inputs;
             for (const auto& i : r["inputs"].get_array())
             {
-                inputs.emplace_back(CountedItem(items.at(i["name"].get_string()).get(), FractionalNumber(std::to_string(i["amount"].get<double>() * 60.0) + "/" + std::to_string(time))));
+                inputs.emplace_back(CountedItem(dataset.items.at(std::string(i["name"].get_string_view())).get(), FractionalNumber::FromDecimal(i["amount"].get_number_literal()) * per_minute));
             }
             std::vector<CountedItem> outputs;
             for (const auto& o : r["outputs"].get_array())
             {
-                outputs.emplace_back(CountedItem(items.at(o["name"].get_string()).get(), FractionalNumber(std::to_string(o["amount"].get<double>() * 60.0) + "/" + std::to_string(time))));
+                outputs.emplace_back(CountedItem(dataset.items.at(std::string(o["name"].get_string_view())).get(), FractionalNumber::FromDecimal(o["amount"].get_number_literal()) * per_minute));
             }
 
-            const Building* building = buildings.at(r["building"].get_string()).get();
-            recipes.emplace_back(std::make_unique<Recipe>(
+            const Building* building = dataset.buildings.at(std::string(r["building"].get_string_view())).get();
+            dataset.recipes.emplace_back(Share(std::make_shared<Recipe>(
                 inputs,
                 outputs,
                 building,
                 r["alternate"].get<bool>(),
                 (r.contains("power_constant") && r.contains("power_range")) ? r["power_constant"].get<double>() + 0.5 * r["power_range"].get<double>() : building->power,
-                r["name"].get_string(),
+                std::string(r["name"].get_string_view()),
                 r.contains("spoiler") && r["spoiler"].get<bool>()
-            ));
+            )));
+        }
+
+        /// @brief Load game data from the json data file
+        /// @param data Parsed json data file
+        /// @param load_icons If false, items icons are not loaded
+        /// @param dataset Dataset to fill
+        void LoadJson(const Json::Value& data, const bool load_icons, Dataset& dataset)
+        {
+            StartupTimeline::ScopedTimer timer("Load json data");
+            dataset.version = data["version"].get_string_view();
+
+            for (const auto& b : data["buildings"].get_array())
+            {
+                LoadBuilding(b, dataset);
+            }
+
+            for (const auto& i : data["items"].get_array())
+            {
+                LoadItem(i, load_icons, dataset);
+            }
+
+            const Json::Array& json_recipes = data["recipes"].get_array();
+            dataset.recipes.reserve(json_recipes.size());
+            for (const auto& r : json_recipes)
+            {
+                LoadRecipe(r, dataset);
+            }
+        }
+
+        /// @brief Load game data while parsing the json data file, one building/item/recipe at a time,
+        /// without building the whole document first
+        /// @param content Content of the json data file
+        /// @param load_icons If false, items icons are not loaded
+        /// @param dataset Dataset to fill
+        void StreamJson(const std::string& content, const bool load_icons, Dataset& dataset)
+        {
+            StartupTimeline::ScopedTimer timer("Stream json data");
+            StartupTimeline::Add(StartupTimeline::Counter::BytesParsed, content.size());
+
+            // Recipes need their items and buildings, they are kept aside if they come first in the file
+            std::vector<Json::Value> pending_recipes;
+
+            Json::RecordHandler handler(true);
+            handler.On("version", [&](const Json::Value& v) {
+                dataset.version = v.get_string_view();
+            });
+            handler.On("buildings", [&](const Json::Value& b) {
+                LoadBuilding(b, dataset);
+            });
+            handler.On("items", [&](const Json::Value& i) {
+                LoadItem(i, load_icons, dataset);
+            });
+            handler.On("recipes", [&](const Json::Value& r) {
+                if (dataset.items.empty() || dataset.buildings.empty())
+                {
+                    pending_recipes.push_back(r);
+                }
+                else
+                {
+                    LoadRecipe(r, dataset);
+                }
+            });
+            Json::Parse(content, handler);
+
+            for (const auto& r : pending_recipes)
+            {
+                LoadRecipe(r, dataset);
+            }
         }
 
-        std::stable_sort(recipes.begin(), recipes.end(), [](const std::unique_ptr<Recipe>& a, const std::unique_ptr<Recipe>& b) {
-            return a->name < b->name;
-        });
+        /// @brief Sort the recipes and build everything derived from them
+        void BuildIndices(Dataset& dataset)
+        {
+            StartupTimeline::ScopedTimer timer("Build recipe indices");
+            std::stable_sort(dataset.recipes.begin(), dataset.recipes.end(), [](const std::shared_ptr<Recipe>& a, const std::shared_ptr<Recipe>& b) {
+                return a->name < b->name;
+            });
+
+            for (const auto& r : dataset.recipes)
+            {
+                dataset.recipes_by_name[r->name] = r;
+            }
+            dataset.recipe_search_index.Build(dataset.recipes);
+            dataset.graph.Build(dataset.recipes);
+        }
+    }
+
+    bool ReplacedData::Empty() const
+    {
+        return items.empty() && buildings.empty() && recipes.empty()
+            && added_items.empty() && added_buildings.empty() && added_recipes.empty();
+    }
+
+    void LoadData(const std::string& game, const bool load_icons)
+    {
+        if (const auto it = datasets.find(game); it != datasets.end())
+        {
+            current = it->second.get();
+            return;
+        }
+
+        if (!std::filesystem::exists(game + ".json"))
+        {
+            throw std::runtime_error("Data file not found for game " + game);
+        }
+
+        StartupTimeline::ScopedTimer timer("Data::LoadData");
+        std::unique_ptr<Dataset> dataset = std::make_unique<Dataset>();
+        dataset->game = game;
+
+        // The binary database generated at build time is used if it matches the json file,
+        // a modified json (custom or modded data) is parsed as is. Read as binary so the hash is computed on the same
+        // bytes as the generation script, even with CRLF line endings
+        std::string json_content = ReadFile(game + ".json", std::ios::in | std::ios::binary);
+        if (!LoadDatabase(game + ".fcdb", json_content, load_icons, *dataset))
+        {
+            dataset = std::make_unique<Dataset>();
+            dataset->game = game;
+            StreamJson(json_content, load_icons, *dataset);
+        }
+
+        BuildIndices(*dataset);
+
+        current = dataset.get();
+        datasets[game] = std::move(dataset);
+    }
+
+    ReplacedData ReloadData(const Json::Value& data, const bool load_icons)
+    {
+        const auto it = datasets.find(current->game);
+        if (it == datasets.end())
+        {
+            throw std::runtime_error("No game data to reload");
+        }
+
+        // The new version is built aside, the current one is left untouched if data is unvalid
+        std::unique_ptr<Dataset> dataset = std::make_unique<Dataset>();
+        dataset->game = current->game;
+        LoadJson(data, load_icons, *dataset);
+        BuildIndices(*dataset);
+
+        ReplacedData replaced;
+        for (const auto& [name, i] : current->items)
+        {
+            if (Find(dataset->items, name) != i)
+            {
+                replaced.items[name] = i;
+            }
+        }
+        for (const auto& [name, b] : current->buildings)
+        {
+            if (Find(dataset->buildings, name) != b)
+            {
+                replaced.buildings[name] = b;
+            }
+        }
+        for (const auto& r : current->recipes)
+        {
+            if (Find(dataset->recipes_by_name, r->name) != r)
+            {
+                replaced.recipes.push_back(r);
+            }
+        }
+        for (const auto& [name, i] : dataset->items)
+        {
+            if (current->items.count(name) == 0)
+            {
+                replaced.added_items.push_back(name);
+            }
+        }
+        for (const auto& [name, b] : dataset->buildings)
+        {
+            if (current->buildings.count(name) == 0)
+            {
+                replaced.added_buildings.push_back(name);
+            }
+        }
+        for (const auto& r : dataset->recipes)
+        {
+            if (current->recipes_by_name.count(r->name) == 0)
+            {
+                replaced.added_recipes.push_back(r->name);
+            }
+        }
+
+        current = dataset.get();
+        it->second = std::move(dataset);
+
+        return replaced;
+    }
+
+    void Unload()
+    {
+        current = &no_data;
+        datasets.clear();
+    }
+
+    std::vector<std::string> AvailableGames()
+    {
+        std::vector<std::string> games;
+        if (std::filesystem::exists("satisfactory.json"))
+        {
+            games.push_back("satisfactory");
+        }
+        if (std::filesystem::is_directory(datasets_folder))
+        {
+            for (const auto& f : std::filesystem::directory_iterator(datasets_folder))
+            {
+                if (f.is_regular_file() && f.path().extension() == ".json")
+                {
+                    games.push_back((std::filesystem::path(datasets_folder) / f.path().stem()).generic_string());
+                }
+            }
+        }
+        std::sort(games.begin() + (games.empty() || games[0] != "satisfactory" ? 0 : 1), games.end());
+        return games;
+    }
+
+    const std::string& Game()
+    {
+        return current->game;
     }
 
     const std::string& Version()
     {
-        return version;
+        return current->version;
+    }
+
+    const std::unordered_map<std::string, std::shared_ptr<Item>>& Items()
+    {
+        return current->items;
+    }
+
+    const std::unordered_map<std::string, std::shared_ptr<Building>>& Buildings()
+    {
+        return current->buildings;
     }
 
-    const std::unordered_map<std::string, std::unique_ptr<Item>>& Items()
+    const std::vector<std::shared_ptr<Recipe>>& Recipes()
     {
-        return items;
+        return current->recipes;
     }
 
-    const std::unordered_map<std::string, std::unique_ptr<Building>>& Buildings()
+    const SearchIndex& RecipeSearchIndex()
     {
-        return buildings;
+        return current->recipe_search_index;
     }
 
-    const std::vector<std::unique_ptr<Recipe>>& Recipes()
+    const RecipeGraph& Graph()
     {
-        return recipes;
+        return current->graph;
     }
 }
@@ -1,22 +1,335 @@
+#include <algorithm>
 #include <array>
-#include <iomanip>
-#include <sstream>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <istream>
+#include <iterator>
+#include <optional>
+#include <ostream>
+#include <type_traits>
 #include <cmath>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JSON_SIMD_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define JSON_SIMD_NEON
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 #include "json.hpp"
 
 namespace Json
 {
+    namespace Internal
+    {
+        /// @brief Output buffer shared by all the Values of a Dump call. Everything is appended to
+        /// the same string, which is flushed to the stream from time to time when there is one
+        class Writer
+        {
+        public:
+            Writer(const int indent, const char indent_char, std::ostream* stream = nullptr) :
+                indent(indent), indent_char(indent_char), stream(stream)
+            {
+                buffer.reserve(stream == nullptr ? 4096 : 2 * flush_size);
+            }
+
+            ~Writer()
+            {
+
+            }
+
+            void Put(const char c)
+            {
+                buffer.push_back(c);
+            }
+
+            void Put(const std::string_view s)
+            {
+                buffer.append(s.data(), s.size());
+            }
+
+            /// @brief Write a string between quotes, with special characters escaped
+            void PutString(const std::string_view s);
+
+            /// @brief Go to the next line and indent it, does nothing in compact mode
+            void NewLine(const size_t depth_level);
+
+            /// @brief Separator between a key and its value
+            void PutKeySeparator()
+            {
+                Put(indent == -1 ? std::string_view(":") : std::string_view(": "));
+            }
+
+            template<typename T>
+            void PutInteger(const T i)
+            {
+                char chars[24];
+                const std::to_chars_result result = std::to_chars(chars, chars + sizeof(chars), i);
+                buffer.append(chars, result.ptr);
+            }
+
+            void PutDouble(const double d);
+
+            /// @brief Send the content of the buffer to the stream if it's big enough
+            void FlushIfNeeded()
+            {
+                if (stream != nullptr && buffer.size() >= flush_size)
+                {
+                    Flush();
+                }
+            }
+
+            void Flush()
+            {
+                if (stream != nullptr)
+                {
+                    stream->write(buffer.data(), buffer.size());
+                    buffer.clear();
+                }
+            }
+
+            std::string& GetBuffer()
+            {
+                return buffer;
+            }
+
+        private:
+            static constexpr size_t flush_size = 1 << 16;
+
+            const int indent;
+            const char indent_char;
+            std::ostream* stream;
+            std::string buffer;
+        };
+
+        /// @brief Parsing events receiver building a Value
+        class ValueBuilder
+        {
+        public:
+            /// @param keep_literals if true, non integer numbers also keep their text
+            /// @param in_situ if true, strings without escape sequence are views of the parsed string
+            ValueBuilder(const bool keep_literals, const bool in_situ) : keep_literals(keep_literals), in_situ(in_situ)
+            {
+
+            }
+
+            ~ValueBuilder()
+            {
+
+            }
+
+            void Null()
+            {
+                Add(Value());
+            }
+
+            void Bool(const bool b)
+            {
+                Add(b);
+            }
+
+            void Integer(const long long int i)
+            {
+                Add(i);
+            }
+
+            void Unsigned(const unsigned long long int u)
+            {
+                Add(u);
+            }
+
+            void Double(const double d, const std::string_view literal)
+            {
+                if (keep_literals)
+                {
+                    Add(Decimal{ d, std::string(literal) });
+                }
+                else
+                {
+                    Add(d);
+                }
+            }
+
+            /// @param from_input true if s is a slice of the parsed string, false if it's a temporary unescaped copy
+            void String(const std::string_view s, const bool from_input)
+            {
+                Add(in_situ && from_input ? Value::StringView(s) : Value(s));
+            }
+
+            void StartObject()
+            {
+                stack.push_back(&Add(Object()));
+            }
+
+            void Key(const std::string_view k)
+            {
+                key = k;
+            }
+
+            void EndObject()
+            {
+                stack.pop_back();
+            }
+
+            void StartArray()
+            {
+                stack.push_back(&Add(Array()));
+            }
+
+            void EndArray()
+            {
+                stack.pop_back();
+            }
+
+            Value& Root()
+            {
+                return root;
+            }
+
+            void Reset()
+            {
+                root = Value();
+                stack.clear();
+            }
+
+        private:
+            /// @brief Add a value in the current object or array
+            /// @return The added value, in its final place
+            Value& Add(Value&& v)
+            {
+                if (stack.empty())
+                {
+                    root = std::move(v);
+                    return root;
+                }
+
+                Value& parent = *stack.back();
+                if (parent.is_array())
+                {
+                    Array& a = parent.get_array();
+                    a.push_back(std::move(v));
+                    return a.back();
+                }
+
+                Value& added = parent.get_object()[key];
+                added = std::move(v);
+                return added;
+            }
+
+            const bool keep_literals;
+            const bool in_situ;
+
+            Value root;
+            /// @brief Objects and arrays being parsed, the last one is the parent of the next value.
+            /// They are already in their parent, and won't move as nothing is added to it until they are complete
+            std::vector<Value*> stack;
+            /// @brief Key of the next value when its parent is an object
+            std::string key;
+        };
+    }
+
     using namespace Internal;
 
-    std::string EscapeChars(const std::string& s);
+    namespace
+    {
+        /// @brief Size of a buffer big enough for any double, integral values can have 309 digits
+        constexpr size_t max_double_chars = 512;
+
+        /// @brief Write the shortest text that is parsed back to the same double, not locale dependant
+        /// @return Pointer past the last char written
+        char* DoubleToChars(char* first, char* last, const double d)
+        {
+#if defined(__cpp_lib_to_chars)
+            return std::to_chars(first, last, d).ptr;
+#else
+            // No floating point std::to_chars in this standard library, use the first precision that round trips
+            int size = 0;
+            for (int precision = 15; precision <= 17; ++precision)
+            {
+                size = std::snprintf(first, last - first, "%.*g", precision, d);
+                if (std::strtod(first, nullptr) == d)
+                {
+                    break;
+                }
+            }
+            return first + size;
+#endif
+        }
+    }
+
+    // Parsing functions send events to a handler H, either a ValueBuilder or a user Handler
     void SkipSpaces(std::string_view::const_iterator& iter, size_t& length);
-    Json::Value NumberFromString(const std::string& s, const bool is_scientific, const bool is_double);
-    Json::Value ParseNumber(std::string_view::const_iterator& iter, size_t& length);
-    Json::Value ParseString(std::string_view::const_iterator& iter, size_t& length);
-    Json::Value ParseObject(std::string_view::const_iterator& iter, size_t& length);
-    Json::Value ParseArray(std::string_view::const_iterator& iter, size_t& length);
-    Json::Value ParseValue(std::string_view::const_iterator& iter, size_t& length);
+    template<typename H> void EmitNumber(const std::string_view s, const bool is_scientific, const bool is_double, H& handler);
+    template<typename H> void ParseNumber(std::string_view::const_iterator& iter, size_t& length, H& handler);
+    std::optional<std::string_view> ReadString(std::string_view::const_iterator& iter, size_t& length, std::string& unescaped);
+    template<typename H> void ParseString(std::string_view::const_iterator& iter, size_t& length, H& handler);
+    template<typename H> void ParseObject(std::string_view::const_iterator& iter, size_t& length, H& handler);
+    template<typename H> void ParseArray(std::string_view::const_iterator& iter, size_t& length, H& handler);
+    template<typename H> void ParseValue(std::string_view::const_iterator& iter, size_t& length, H& handler);
+    template<typename H> void ParseRoot(std::string_view::const_iterator iter, size_t length, H& handler);
+
+    namespace
+    {
+        /// @brief Biggest size of the memory blocks allocated by an Arena
+        constexpr size_t max_block_size = 4 * 1024 * 1024;
+
+        thread_local Arena* current_arena = nullptr;
+    }
+
+    Arena::Arena(const size_t block_size) : next_block_size(block_size), reserved(0), cursor(nullptr), remaining(0)
+    {
+
+    }
+
+    Arena::~Arena()
+    {
+
+    }
+
+    void* Arena::Allocate(const size_t size, const size_t alignment)
+    {
+        size_t padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+        if (cursor == nullptr || padding + size > remaining)
+        {
+            const size_t block_size = std::max(next_block_size, size + alignment);
+            blocks.emplace_back(new char[block_size]);
+            cursor = blocks.back().get();
+            remaining = block_size;
+            reserved += block_size;
+            next_block_size = std::min(2 * next_block_size, max_block_size);
+            padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+        }
+
+        void* output = cursor + padding;
+        cursor += padding + size;
+        remaining -= padding + size;
+        return output;
+    }
+
+    size_t Arena::GetReservedBytes() const
+    {
+        return reserved;
+    }
+
+    Arena* Arena::Current()
+    {
+        return current_arena;
+    }
+
+    Arena::Scope::Scope(Arena& arena) : previous(current_arena)
+    {
+        current_arena = &arena;
+    }
+
+    Arena::Scope::~Scope()
+    {
+        current_arena = previous;
+    }
 
     Value::Value(std::nullptr_t)
     {
@@ -68,11 +381,16 @@ namespace Json
 
     }
 
+    Value::Value(Decimal&& d) : val(std::move(d))
+    {
+
+    }
+
     Value::Value(const std::initializer_list<Value>& init)
     {
         if (init.size() == 2 && init.begin()->is_string())
         {
-            val = Object({ { init.begin()->get<std::string>(), *(init.begin() + 1) } });
+            val = Object({ { std::string(init.begin()->get_string_view()), *(init.begin() + 1) } });
             return;
         }
 
@@ -98,6 +416,44 @@ namespace Json
         val = std::move(new_val);
     }
 
+    Value::Value(const Value& other)
+    {
+        // A copy can outlive the source buffer of the view
+        if (std::holds_alternative<std::string_view>(other.val))
+        {
+            val = std::string(std::get<std::string_view>(other.val));
+        }
+        else
+        {
+            val = other.val;
+        }
+    }
+
+    Value& Value::operator=(const Value& other)
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        if (std::holds_alternative<std::string_view>(other.val))
+        {
+            val = std::string(std::get<std::string_view>(other.val));
+        }
+        else
+        {
+            val = other.val;
+        }
+        return *this;
+    }
+
+    Value Value::StringView(const std::string_view s)
+    {
+        Value output;
+        output.val = s;
+        return output;
+    }
+
     Object& Value::get_object()
     {
         return get<Object>();
@@ -128,6 +484,15 @@ namespace Json
         return get<std::string>();
     }
 
+    std::string_view Value::get_string_view() const
+    {
+        if (std::holds_alternative<std::string_view>(val))
+        {
+            return std::get<std::string_view>(val);
+        }
+        return get<std::string>();
+    }
+
     bool Value::is_null() const
     {
         return is<std::monostate>();
@@ -135,7 +500,7 @@ namespace Json
 
     bool Value::is_string() const
     {
-        return is<std::string>();
+        return is<std::string>() || is<std::string_view>();
     }
 
     bool Value::is_object() const
@@ -163,10 +528,11 @@ namespace Json
     {
         return std::holds_alternative<long long int>(val)
             || std::holds_alternative<unsigned long long int>(val)
-            || std::holds_alternative<double>(val);
+            || std::holds_alternative<double>(val)
+            || std::holds_alternative<Decimal>(val);
     }
 
-    Value& Value::operator[](const std::string& s)
+    Value& Value::operator[](const std::string_view s)
     {
         if (std::holds_alternative<std::monostate>(val))
         {
@@ -181,7 +547,7 @@ namespace Json
         return get<Object>()[s];
     }
 
-    const Value& Value::operator[](const std::string& s) const
+    const Value& Value::operator[](const std::string_view s) const
     {
         if (!std::holds_alternative<RecursiveWrapper<Object>>(val))
         {
@@ -211,6 +577,28 @@ namespace Json
         return get<Array>().at(i);
     }
 
+    std::string Value::get_number_literal() const
+    {
+        if (std::holds_alternative<Decimal>(val))
+        {
+            return std::get<Decimal>(val).literal;
+        }
+        else if (std::holds_alternative<long long int>(val))
+        {
+            return std::to_string(std::get<long long int>(val));
+        }
+        else if (std::holds_alternative<unsigned long long int>(val))
+        {
+            return std::to_string(std::get<unsigned long long int>(val));
+        }
+        else if (std::holds_alternative<double>(val))
+        {
+            char chars[max_double_chars];
+            return std::string(chars, DoubleToChars(chars, chars + sizeof(chars), std::get<double>(val)));
+        }
+        throw std::runtime_error("Trying to get a number literal from a Json::Value that is something else");
+    }
+
     std::istream& operator>>(std::istream& is, Value& v)
     {
         v = Json::Parse(std::string(
@@ -221,7 +609,7 @@ namespace Json
         return is;
     }
 
-    bool Value::contains(const std::string& s) const
+    bool Value::contains(const std::string_view s) const
     {
         return is<Object>() && get<Object>().count(s);
     }
@@ -255,239 +643,907 @@ namespace Json
 
         if (!std::holds_alternative<RecursiveWrapper<Array>>(val))
         {
-            throw std::runtime_error("Can't push_back in a non-array Json");
+            throw std::runtime_error("Can't push_back in a non-array Json");
+        }
+
+        get<Array>().push_back(value);
+    }
+
+    void Value::push_back(Value&& value)
+    {
+        if (std::holds_alternative<std::monostate>(val))
+        {
+            val = Array();
+        }
+
+        if (!std::holds_alternative<RecursiveWrapper<Array>>(val))
+        {
+            throw std::runtime_error("Can't push_back in a non-array Json");
+        }
+
+        get<Array>().push_back(std::move(value));
+    }
+
+    std::string Value::Dump(const int indent, const char indent_char) const
+    {
+        Writer writer(indent, indent_char);
+        Dump(writer, 0);
+        return std::move(writer.GetBuffer());
+    }
+
+    void Value::Dump(std::ostream& os, const int indent, const char indent_char) const
+    {
+        Writer writer(indent, indent_char, &os);
+        Dump(writer, 0);
+        writer.Flush();
+    }
+
+    void Value::Dump(Writer& writer, const size_t depth_level) const
+    {
+        std::visit([&](auto&& arg)
+            {
+                using T = std::decay_t<decltype(arg)>;
+
+                if constexpr (std::is_same_v<T, std::monostate>)
+                {
+                    writer.Put("null");
+                }
+                else if constexpr (std::is_same_v<T, RecursiveWrapper<Object>>)
+                {
+                    const Object& o = arg.get();
+                    if (o.empty())
+                    {
+                        writer.Put("{}");
+                        return;
+                    }
+
+                    writer.Put('{');
+                    bool first = true;
+                    for (const auto& [k, v] : o)
+                    {
+                        if (!first)
+                        {
+                            writer.Put(',');
+                        }
+                        else
+                        {
+                            first = false;
+                        }
+                        writer.NewLine(depth_level + 1);
+                        writer.PutString(k);
+                        writer.PutKeySeparator();
+                        v.Dump(writer, depth_level + 1);
+                        writer.FlushIfNeeded();
+                    }
+                    writer.NewLine(depth_level);
+                    writer.Put('}');
+                }
+                else if constexpr (std::is_same_v<T, RecursiveWrapper<Array>>)
+                {
+                    const Array& a = arg.get();
+                    if (a.empty())
+                    {
+                        writer.Put("[]");
+                        return;
+                    }
+
+                    writer.Put('[');
+                    bool first = true;
+                    for (const auto& v : a)
+                    {
+                        if (!first)
+                        {
+                            writer.Put(',');
+                        }
+                        else
+                        {
+                            first = false;
+                        }
+                        writer.NewLine(depth_level + 1);
+                        v.Dump(writer, depth_level + 1);
+                        writer.FlushIfNeeded();
+                    }
+                    writer.NewLine(depth_level);
+                    writer.Put(']');
+                }
+                else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>)
+                {
+                    writer.PutString(arg);
+                }
+                else if constexpr (std::is_same_v<T, bool>)
+                {
+                    writer.Put(arg ? std::string_view("true") : std::string_view("false"));
+                }
+                else if constexpr (std::is_same_v<T, Decimal>)
+                {
+                    writer.Put(arg.literal);
+                }
+                else if constexpr (std::is_same_v<T, double>)
+                {
+                    writer.PutDouble(arg);
+                }
+                else
+                {
+                    writer.PutInteger(arg);
+                }
+            }, val);
+    }
+
+    Object::Object()
+    {
+
+    }
+
+    Object::Object(std::initializer_list<value_type> init)
+    {
+        elements.reserve(init.size());
+        for (const value_type& element : init)
+        {
+            insert(element);
+        }
+    }
+
+    Value& Object::operator[](const std::string_view key)
+    {
+        iterator it = LowerBound(key);
+        if (it == elements.end() || it->first != key)
+        {
+            it = elements.emplace(it, std::string(key), Value());
+        }
+        return it->second;
+    }
+
+    Value& Object::at(const std::string_view key)
+    {
+        const iterator it = find(key);
+        if (it == elements.end())
+        {
+            throw std::out_of_range("Json object doesn't contain key " + std::string(key));
+        }
+        return it->second;
+    }
+
+    const Value& Object::at(const std::string_view key) const
+    {
+        const const_iterator it = find(key);
+        if (it == elements.end())
+        {
+            throw std::out_of_range("Json object doesn't contain key " + std::string(key));
+        }
+        return it->second;
+    }
+
+    Object::iterator Object::find(const std::string_view key)
+    {
+        const iterator it = LowerBound(key);
+        return it != elements.end() && it->first == key ? it : elements.end();
+    }
+
+    Object::const_iterator Object::find(const std::string_view key) const
+    {
+        const const_iterator it = LowerBound(key);
+        return it != elements.end() && it->first == key ? it : elements.end();
+    }
+
+    size_t Object::count(const std::string_view key) const
+    {
+        return find(key) != elements.end() ? 1 : 0;
+    }
+
+    bool Object::contains(const std::string_view key) const
+    {
+        return find(key) != elements.end();
+    }
+
+    std::pair<Object::iterator, bool> Object::insert(const value_type& element)
+    {
+        const iterator it = LowerBound(element.first);
+        if (it != elements.end() && it->first == element.first)
+        {
+            return { it, false };
+        }
+        return { elements.insert(it, element), true };
+    }
+
+    std::pair<Object::iterator, bool> Object::insert(value_type&& element)
+    {
+        const iterator it = LowerBound(element.first);
+        if (it != elements.end() && it->first == element.first)
+        {
+            return { it, false };
+        }
+        return { elements.insert(it, std::move(element)), true };
+    }
+
+    size_t Object::erase(const std::string_view key)
+    {
+        const iterator it = find(key);
+        if (it == elements.end())
+        {
+            return 0;
+        }
+        elements.erase(it);
+        return 1;
+    }
+
+    Object::iterator Object::erase(const_iterator it)
+    {
+        return elements.erase(it);
+    }
+
+    void Object::reserve(const size_t n)
+    {
+        elements.reserve(n);
+    }
+
+    void Object::clear()
+    {
+        elements.clear();
+    }
+
+    size_t Object::size() const
+    {
+        return elements.size();
+    }
+
+    bool Object::empty() const
+    {
+        return elements.empty();
+    }
+
+    Object::iterator Object::begin()
+    {
+        return elements.begin();
+    }
+
+    Object::iterator Object::end()
+    {
+        return elements.end();
+    }
+
+    Object::const_iterator Object::begin() const
+    {
+        return elements.begin();
+    }
+
+    Object::const_iterator Object::end() const
+    {
+        return elements.end();
+    }
+
+    Object::const_iterator Object::cbegin() const
+    {
+        return elements.cbegin();
+    }
+
+    Object::const_iterator Object::cend() const
+    {
+        return elements.cend();
+    }
+
+    Object::iterator Object::LowerBound(const std::string_view key)
+    {
+        // Dumped objects are sorted, so parsed keys usually go at the end
+        if (elements.empty() || std::string_view(elements.back().first) < key)
+        {
+            return elements.end();
+        }
+        return std::lower_bound(elements.begin(), elements.end(), key, [](const value_type& element, const std::string_view k) {
+            return std::string_view(element.first) < k;
+        });
+    }
+
+    Object::const_iterator Object::LowerBound(const std::string_view key) const
+    {
+        if (elements.empty() || std::string_view(elements.back().first) < key)
+        {
+            return elements.end();
+        }
+        return std::lower_bound(elements.begin(), elements.end(), key, [](const value_type& element, const std::string_view k) {
+            return std::string_view(element.first) < k;
+        });
+    }
+
+    Document::Document() : arena(std::make_unique<Arena>())
+    {
+
+    }
+
+    Document::~Document()
+    {
+
+    }
+
+    Document::Document(Document&& other) noexcept : arena(std::move(other.arena)), source(std::move(other.source)), root(std::move(other.root))
+    {
+
+    }
+
+    Document& Document::operator=(Document&& other) noexcept
+    {
+        // Current root must be released before its arena
+        root = std::move(other.root);
+        arena = std::move(other.arena);
+        source = std::move(other.source);
+        return *this;
+    }
+
+    Value& Document::Root()
+    {
+        return root;
+    }
+
+    const Value& Document::Root() const
+    {
+        return root;
+    }
+
+    Arena& Document::GetArena()
+    {
+        return *arena;
+    }
+
+    Value Parse(std::string_view::const_iterator iter, size_t length, bool no_except, bool keep_literals)
+    {
+        ValueBuilder builder(keep_literals, false);
+        try
+        {
+            ParseRoot(iter, length, builder);
+        }
+        catch (const std::runtime_error&)
+        {
+            if (no_except)
+            {
+                return Value();
+            }
+            throw;
+        }
+        return std::move(builder.Root());
+    }
+
+    template<typename H>
+    void ParseRoot(std::string_view::const_iterator iter, size_t length, H& handler)
+    {
+        const size_t init_length = length;
+        try
+        {
+            ParseValue(iter, length, handler);
+            if (length > 0)
+            {
+                throw std::runtime_error(std::to_string(length) + " unread characters remaining after parsing");
+            }
+        }
+        catch (const std::runtime_error& e)
+        {
+            throw std::runtime_error(e.what() + std::string(" (at pos ") + std::to_string(init_length - length) + ')');
+        }
+    }
+
+    Value Parse(const std::string& s, bool no_except, bool keep_literals)
+    {
+        if (s.empty())
+        {
+            return Value();
+        }
+
+        size_t length = s.size();
+        std::string_view sview(s.begin().operator->(), s.end() - s.begin());
+        try
+        {
+            return Parse(sview.begin(), length, false, keep_literals);
+        }
+        catch (const std::runtime_error& e)
+        {
+            if (no_except)
+            {
+                return Value();
+            }
+            throw std::runtime_error(e.what() + std::string(" (at pos ") + std::to_string(s.size() - length) + ')');
+        }
+    }
+
+    Document ParseDocument(const std::string& s, bool no_except, bool keep_literals)
+    {
+        Document document;
+        Arena::Scope scope(document.GetArena());
+        document.Root() = Parse(s, no_except, keep_literals);
+        return document;
+    }
+
+    Document ParseInSitu(std::string&& s, bool no_except, bool keep_literals)
+    {
+        Document document;
+        document.source = std::make_unique<const std::string>(std::move(s));
+        if (document.source->empty())
+        {
+            return document;
+        }
+
+        Arena::Scope scope(document.GetArena());
+        const std::string_view text(*document.source);
+        ValueBuilder builder(keep_literals, true);
+        try
+        {
+            ParseRoot(text.begin(), text.size(), builder);
+        }
+        catch (const std::runtime_error&)
+        {
+            if (no_except)
+            {
+                return document;
+            }
+            throw;
+        }
+        document.root = std::move(builder.Root());
+        return document;
+    }
+
+    void Parse(const std::string_view s, Handler& handler)
+    {
+        if (s.empty())
+        {
+            return;
+        }
+        ParseRoot(s.begin(), s.size(), handler);
+    }
+
+    Handler::~Handler()
+    {
+
+    }
+
+    void Handler::Null()
+    {
+
+    }
+
+    void Handler::Bool(const bool b)
+    {
+
+    }
+
+    void Handler::Integer(const long long int i)
+    {
+
+    }
+
+    void Handler::Unsigned(const unsigned long long int u)
+    {
+
+    }
+
+    void Handler::Double(const double d, const std::string_view literal)
+    {
+
+    }
+
+    void Handler::String(const std::string_view s)
+    {
+
+    }
+
+    void Handler::StartObject()
+    {
+
+    }
+
+    void Handler::Key(const std::string_view key)
+    {
+
+    }
+
+    void Handler::EndObject()
+    {
+
+    }
+
+    void Handler::StartArray()
+    {
+
+    }
+
+    void Handler::EndArray()
+    {
+
+    }
+
+    RecordHandler::RecordHandler(const bool keep_literals) :
+        current(nullptr), builder(std::make_unique<ValueBuilder>(keep_literals, false)), depth(0), in_root_array(false), building(false)
+    {
+
+    }
+
+    RecordHandler::~RecordHandler()
+    {
+
+    }
+
+    void RecordHandler::On(const std::string& key, const std::function<void(const Value&)>& callback)
+    {
+        callbacks[key] = callback;
+    }
+
+    void RecordHandler::Null()
+    {
+        if (BeginValue())
+        {
+            builder->Null();
+            EndValue();
+        }
+    }
+
+    void RecordHandler::Bool(const bool b)
+    {
+        if (BeginValue())
+        {
+            builder->Bool(b);
+            EndValue();
+        }
+    }
+
+    void RecordHandler::Integer(const long long int i)
+    {
+        if (BeginValue())
+        {
+            builder->Integer(i);
+            EndValue();
+        }
+    }
+
+    void RecordHandler::Unsigned(const unsigned long long int u)
+    {
+        if (BeginValue())
+        {
+            builder->Unsigned(u);
+            EndValue();
+        }
+    }
+
+    void RecordHandler::Double(const double d, const std::string_view literal)
+    {
+        if (BeginValue())
+        {
+            builder->Double(d, literal);
+            EndValue();
+        }
+    }
+
+    void RecordHandler::String(const std::string_view s)
+    {
+        if (BeginValue())
+        {
+            builder->String(s, false);
+            EndValue();
+        }
+    }
+
+    void RecordHandler::StartObject()
+    {
+        if (depth == 0)
+        {
+            depth = 1;
+            return;
+        }
+        if (BeginValue())
+        {
+            builder->StartObject();
         }
-
-        get<Array>().push_back(value);
+        depth += 1;
     }
 
-    void Value::push_back(Value&& value)
+    void RecordHandler::Key(const std::string_view key)
     {
-        if (std::holds_alternative<std::monostate>(val))
+        if (depth == 1)
         {
-            val = Array();
+            const auto it = callbacks.find(key);
+            current = it == callbacks.end() ? nullptr : &it->second;
         }
-
-        if (!std::holds_alternative<RecursiveWrapper<Array>>(val))
+        else if (building)
         {
-            throw std::runtime_error("Can't push_back in a non-array Json");
+            builder->Key(key);
         }
-
-        get<Array>().push_back(std::move(value));
     }
 
-    std::string Value::Dump(const int indent, const char indent_char) const
+    void RecordHandler::EndObject()
     {
-        return Dump(0, indent, indent_char);
+        depth -= 1;
+        if (building)
+        {
+            builder->EndObject();
+            EndValue();
+        }
     }
 
-    std::string Value::Dump(const size_t depth_level, const int indent, const char indent_char) const
+    void RecordHandler::StartArray()
     {
-        std::ostringstream oss;
-
-        std::visit([&](auto&& arg)
-            {
-                using T = std::decay_t<decltype(arg)>;
-
-                if constexpr (std::is_same_v<T, std::monostate>)
-                {
-                    oss << "null";
-                }
-                else if constexpr (std::is_same_v<T, RecursiveWrapper<Object>>)
-                {
-                    const Object& o = arg.get();
-                    if (o.empty())
-                    {
-                        oss << "{}";
-                        return;
-                    }
-
-                    const std::string new_line = (indent == -1 ? "" : "\n");
-                    const std::string line_indentation = indent > -1 ? std::string(depth_level * indent, indent_char) : "";
-                    const std::string value_indentation = indent > -1 ? std::string(indent, indent_char) : "";
-
-                    oss << "{" << new_line;
-                    bool first = true;
-                    for (const auto& [k, v] : o)
-                    {
-                        if (!first)
-                        {
-                            oss << "," << new_line;
-                        }
-                        else
-                        {
-                            first = false;
-                        }
-                        oss << line_indentation << value_indentation << "\"" << k << "\"" << (indent == -1 ? ":" : ": ") << v.Dump(depth_level + 1, indent, indent_char);
-                    }
-                    oss << new_line << line_indentation << "}";
-                }
-                else if constexpr (std::is_same_v<T, RecursiveWrapper<Array>>)
-                {
-                    const Array& a = arg.get();
-                    if (a.empty())
-                    {
-                        oss << "[]";
-                        return;
-                    }
-                    const std::string new_line = (indent == -1 ? "" : "\n");
-                    const std::string line_indentation = indent > -1 ? std::string(depth_level * indent, indent_char) : "";
-                    const std::string value_indentation = indent > -1 ? std::string(indent, indent_char) : "";
-
-                    oss << '[' << new_line;
-                    bool first = true;
-                    for (const auto& v : a)
-                    {
-                        if (!first)
-                        {
-                            oss << ',' << new_line;
-                        }
-                        else
-                        {
-                            first = false;
-                        }
-                        oss << line_indentation << value_indentation << v.Dump(depth_level + 1, indent, indent_char);
-                    }
-                    oss << new_line << line_indentation << ']';
-                }
-                else if constexpr (std::is_same_v<T, std::string>)
-                {
-                    oss << "\"" << EscapeChars(arg) << "\"";
-                }
-                else if constexpr (std::is_same_v<T, bool>)
-                {
-                    oss << (arg ? "true" : "false");
-                }
-                else if constexpr (std::is_same_v<T, double>)
-                {
-                    if (arg == std::floor(arg))
-                    {
-                        oss << std::setprecision(1) << std::fixed << arg;
-                    }
-                    else
-                    {
-                        oss << arg;
-                    }
-                }
-                else
-                {
-                    oss << arg;
-                }
-            }, val);
-
-        return oss.str();
+        // Elements of the arrays of the root object are records
+        if (depth == 1)
+        {
+            in_root_array = true;
+            depth = 2;
+            return;
+        }
+        if (BeginValue())
+        {
+            builder->StartArray();
+        }
+        depth += 1;
     }
 
-    Value Parse(std::string_view::const_iterator iter, size_t length, bool no_except)
+    void RecordHandler::EndArray()
     {
-        const size_t init_length = length;
-        try
+        depth -= 1;
+        if (depth == 1 && in_root_array)
         {
-            Value out = ParseValue(iter, length);
-            if (length > 0)
-            {
-                throw std::runtime_error(std::to_string(length) + " unread characters remaining after parsing");
-            }
-            return out;
+            in_root_array = false;
+            return;
         }
-        catch (const std::runtime_error& e)
+        if (building)
         {
-            if (no_except)
-            {
-                return Value();
-            }
-            throw std::runtime_error(e.what() + std::string(" (at pos ") + std::to_string(init_length - length) + ')');
+            builder->EndArray();
+            EndValue();
         }
     }
 
-    Value Parse(const std::string& s, bool no_except)
+    bool RecordHandler::AtRecord() const
     {
-        if (s.empty())
+        return depth == (in_root_array ? 2 : 1);
+    }
+
+    bool RecordHandler::BeginValue()
+    {
+        if (depth == 0)
         {
-            return Value();
+            throw std::runtime_error("RecordHandler can only parse an object");
         }
-
-        size_t length = s.size();
-        std::string_view sview(s.begin().operator->(), s.end() - s.begin());
-        try
+        if (!building && current != nullptr && AtRecord())
         {
-            return Parse(sview.begin(), length);
+            builder->Reset();
+            building = true;
         }
-        catch (const std::runtime_error& e)
+        return building;
+    }
+
+    void RecordHandler::EndValue()
+    {
+        if (!AtRecord())
         {
-            if (no_except)
-            {
-                return Value();
-            }
-            throw std::runtime_error(e.what() + std::string(" (at pos ") + std::to_string(s.size() - length) + ')');
+            return;
         }
+        building = false;
+        (*current)(builder->Root());
+        builder->Reset();
     }
 
 
-    std::string EscapeChars(const std::string& s)
+    void Writer::PutString(const std::string_view s)
     {
-        std::ostringstream out;
-        auto it = s.begin();
-        while (it != s.end())
+        buffer.push_back('"');
+        // Copy all characters between two escaped ones at once
+        size_t run_start = 0;
+        for (size_t i = 0; i < s.size(); ++i)
         {
-            switch (*it)
+            char escaped;
+            switch (s[i])
             {
             case '\\':
             case '"':
-                out << '\\' << *it;
-                it += 1;
+                escaped = s[i];
                 break;
             case '\b':
-                out << '\\' << 'b';
-                it += 1;
+                escaped = 'b';
                 break;
             case '\f':
-                out << '\\' << 'f';
-                it += 1;
+                escaped = 'f';
                 break;
             case '\n':
-                out << '\\' << 'n';
-                it += 1;
+                escaped = 'n';
                 break;
             case '\r':
-                out << '\\' << 'r';
-                it += 1;
+                escaped = 'r';
                 break;
             case '\t':
-                out << '\\' << 't';
-                it += 1;
+                escaped = 't';
                 break;
             default:
-                out << *it;
-                it += 1;
-                break;
+                continue;
             }
+            buffer.append(s.data() + run_start, i - run_start);
+            buffer.push_back('\\');
+            buffer.push_back(escaped);
+            run_start = i + 1;
         }
+        buffer.append(s.data() + run_start, s.size() - run_start);
+        buffer.push_back('"');
+    }
 
-        return out.str();
+    void Writer::NewLine(const size_t depth_level)
+    {
+        if (indent == -1)
+        {
+            return;
+        }
+        buffer.push_back('\n');
+        buffer.append(depth_level * indent, indent_char);
     }
 
-    void SkipSpaces(std::string_view::const_iterator& iter, size_t& length)
+    void Writer::PutDouble(const double d)
     {
-        while (length)
+        char chars[max_double_chars];
+        // Integral values are written with one decimal so they are parsed back as doubles
+        if (std::isfinite(d) && d == std::floor(d))
         {
-            switch (*iter)
+#if defined(__cpp_lib_to_chars)
+            char* end = std::to_chars(chars, chars + sizeof(chars), d, std::chars_format::fixed).ptr;
+#else
+            char* end = chars + std::snprintf(chars, sizeof(chars), "%.0f", d);
+#endif
+            buffer.append(chars, end);
+            buffer.append(".0");
+            return;
+        }
+        buffer.append(chars, DoubleToChars(chars, chars + sizeof(chars), d));
+    }
+
+    namespace
+    {
+        bool IsSpace(const char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+        }
+
+        /// @brief Check if a char can't be copied as is in a string: end of the string, escape or control character
+        bool IsStringSpecial(const char c)
+        {
+            return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+        }
+
+#if defined(JSON_SIMD_SSE2) || defined(JSON_SIMD_NEON)
+        /// @brief Size of the blocks checked at once
+        constexpr size_t block_size = 16;
+#endif
+
+#if defined(JSON_SIMD_SSE2)
+        /// @brief Number of mask bits for each char of a block
+        constexpr unsigned int bits_per_char = 1;
+
+        /// @brief Get the index of the lowest set bit of a non zero mask
+        unsigned int LowestBit(const uint64_t mask)
+        {
+            // SSE2 masks only use the 16 lowest bits, the 32 bits version is also available on 32 bits x86
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, static_cast<unsigned long>(mask));
+            return index;
+#else
+            return __builtin_ctz(static_cast<unsigned int>(mask));
+#endif
+        }
+
+        /// @brief Get a mask with the bits of the chars of a block that are not spaces set
+        uint64_t NonSpaceMask(const char* p)
+        {
+            const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const __m128i spaces = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\t'))),
+                _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\n')))
+            );
+            return ~static_cast<uint64_t>(_mm_movemask_epi8(spaces)) & 0xFFFF;
+        }
+
+        /// @brief Get a mask with the bits of the chars of a block that are IsStringSpecial set
+        uint64_t StringSpecialMask(const char* p)
+        {
+            const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            // No unsigned comparison in SSE2, c <= 0x1F is max(c, 0x1F) == 0x1F
+            const __m128i control = _mm_set1_epi8(0x1F);
+            const __m128i special = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('"')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\\'))),
+                _mm_cmpeq_epi8(_mm_max_epu8(c, control), control)
+            );
+            return static_cast<uint64_t>(_mm_movemask_epi8(special));
+        }
+#elif defined(JSON_SIMD_NEON)
+        /// @brief Number of mask bits for each char of a block
+        constexpr unsigned int bits_per_char = 4;
+
+        /// @brief Get the index of the lowest set bit of a non zero mask
+        unsigned int LowestBit(const uint64_t mask)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward64(&index, mask);
+            return index;
+#else
+            return __builtin_ctzll(mask);
+#endif
+        }
+
+        /// @brief Turn a NEON comparison result into a mask with 4 bits per char
+        uint64_t ToMask(const uint8x16_t cmp)
+        {
+            return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4)), 0);
+        }
+
+        /// @brief Get a mask with the bits of the chars of a block that are not spaces set
+        uint64_t NonSpaceMask(const char* p)
+        {
+            const uint8x16_t c = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+            const uint8x16_t spaces = vorrq_u8(
+                vorrq_u8(vceqq_u8(c, vdupq_n_u8(' ')), vceqq_u8(c, vdupq_n_u8('\t'))),
+                vorrq_u8(vceqq_u8(c, vdupq_n_u8('\r')), vceqq_u8(c, vdupq_n_u8('\n')))
+            );
+            return ToMask(vmvnq_u8(spaces));
+        }
+
+        /// @brief Get a mask with the bits of the chars of a block that are IsStringSpecial set
+        uint64_t StringSpecialMask(const char* p)
+        {
+            const uint8x16_t c = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+            const uint8x16_t special = vorrq_u8(
+                vorrq_u8(vceqq_u8(c, vdupq_n_u8('"')), vceqq_u8(c, vdupq_n_u8('\\'))),
+                vcleq_u8(c, vdupq_n_u8(0x1F))
+            );
+            return ToMask(special);
+        }
+#endif
+
+        /// @brief Get the number of spaces at the beginning of p
+        size_t SpacesLength(const char* p, const size_t length)
+        {
+            size_t i = 0;
+#if defined(JSON_SIMD_SSE2) || defined(JSON_SIMD_NEON)
+            for (; i + block_size <= length; i += block_size)
             {
-            case ' ':
-            case '\t':
-            case '\r':
-            case '\n':
-                iter += 1;
-                length -= 1;
-                break;
-            default:
-                return;
-                break;
+                const uint64_t mask = NonSpaceMask(p + i);
+                if (mask != 0)
+                {
+                    return i + LowestBit(mask) / bits_per_char;
+                }
+            }
+#endif
+            while (i < length && IsSpace(p[i]))
+            {
+                i += 1;
+            }
+            return i;
+        }
+
+        /// @brief Get the number of chars at the beginning of p that can be copied as is in a string
+        size_t PlainStringLength(const char* p, const size_t length)
+        {
+            size_t i = 0;
+#if defined(JSON_SIMD_SSE2) || defined(JSON_SIMD_NEON)
+            for (; i + block_size <= length; i += block_size)
+            {
+                const uint64_t mask = StringSpecialMask(p + i);
+                if (mask != 0)
+                {
+                    return i + LowestBit(mask) / bits_per_char;
+                }
+            }
+#endif
+            while (i < length && !IsStringSpecial(p[i]))
+            {
+                i += 1;
             }
+            return i;
         }
     }
 
-    void ValidateStringNumber(const std::string& s)
+    void SkipSpaces(std::string_view::const_iterator& iter, size_t& length)
+    {
+        // Most calls have nothing to skip, don't bother loading a whole block for them
+        if (length == 0 || !IsSpace(*iter))
+        {
+            return;
+        }
+        const size_t spaces = SpacesLength(&*iter, length);
+        iter += spaces;
+        length -= spaces;
+    }
+
+    void ValidateStringNumber(const std::string_view s)
     {
         const size_t s_size = s.size();
         // Validate the string format
@@ -544,7 +1600,34 @@ namespace Json
         }
     }
 
-    Value NumberFromString(const std::string& s, const bool is_scientific, const bool is_double)
+    double DoubleFromString(const std::string_view s)
+    {
+        double output = 0.0;
+#if defined(__cpp_lib_to_chars)
+        const std::from_chars_result result = std::from_chars(s.data(), s.data() + s.size(), output);
+        if (result.ec == std::errc::result_out_of_range)
+        {
+            throw std::runtime_error("Out of range number encountered when parsing number");
+        }
+        if (result.ec != std::errc() || result.ptr != s.data() + s.size())
+        {
+            throw std::runtime_error("Unexpected character encountered when parsing number");
+        }
+#else
+        // No floating point std::from_chars in this standard library, strtod needs a null terminated string
+        const std::string null_terminated(s);
+        char* end = nullptr;
+        output = std::strtod(null_terminated.c_str(), &end);
+        if (end != null_terminated.c_str() + null_terminated.size())
+        {
+            throw std::runtime_error("Unexpected character encountered when parsing number");
+        }
+#endif
+        return output;
+    }
+
+    template<typename H>
+    void EmitNumber(const std::string_view s, const bool is_scientific, const bool is_double, H& handler)
     {
         if (s.empty())
         {
@@ -555,28 +1638,44 @@ namespace Json
 
         if (is_scientific || is_double)
         {
-            return std::stod(s);
+            handler.Double(DoubleFromString(s), s);
+            return;
         }
 
+        // Integers too big for long long int / unsigned long long int are stored as double
         if (s[0] == '-')
         {
-            // min long long int (but with > because string comparison)
-            if (s.size() > 20 || (s.size() >= 20 && s > "-9223372036854775808"))
+            long long int i = 0;
+            const std::from_chars_result result = std::from_chars(s.data(), s.data() + s.size(), i);
+            if (result.ec == std::errc::result_out_of_range)
+            {
+                handler.Double(DoubleFromString(s), s);
+                return;
+            }
+            if (result.ec != std::errc() || result.ptr != s.data() + s.size())
             {
-                return std::stod(s);
+                throw std::runtime_error("Unexpected character encountered when parsing number");
             }
-            return std::stoll(s);
+            handler.Integer(i);
+            return;
         }
 
-        // max unsigned long long int
-        if (s.size() > 20 || (s.size() >= 20 && s > "18446744073709551615"))
+        unsigned long long int u = 0;
+        const std::from_chars_result result = std::from_chars(s.data(), s.data() + s.size(), u);
+        if (result.ec == std::errc::result_out_of_range)
+        {
+            handler.Double(DoubleFromString(s), s);
+            return;
+        }
+        if (result.ec != std::errc() || result.ptr != s.data() + s.size())
         {
-            return std::stod(s);
+            throw std::runtime_error("Unexpected character encountered when parsing number");
         }
-        return std::stoull(s);
+        handler.Unsigned(u);
     }
 
-    Value ParseNumber(std::string_view::const_iterator& iter, size_t& length)
+    template<typename H>
+    void ParseNumber(std::string_view::const_iterator& iter, size_t& length, H& handler)
     {
         std::string_view::const_iterator start = iter;
 
@@ -622,12 +1721,13 @@ namespace Json
                 length -= 1;
                 break;
             default:
-                return NumberFromString(std::string(start, iter), is_scientific, is_double);
+                EmitNumber(std::string_view(&*start, iter - start), is_scientific, is_double, handler);
+                return;
             }
         }
 
         // This means the whole string was a number and no other character was present to stop the reading
-        return NumberFromString(std::string(start, iter), is_scientific, is_double);
+        EmitNumber(std::string_view(&*start, iter - start), is_scientific, is_double, handler);
     }
 
     bool IsValidCodepoint(const unsigned long cp)
@@ -673,7 +1773,7 @@ namespace Json
         }
     }
 
-    Value ParseString(std::string_view::const_iterator& iter, size_t& length)
+    std::optional<std::string_view> ReadString(std::string_view::const_iterator& iter, size_t& length, std::string& unescaped)
     {
         if (length < 2)
         {
@@ -686,9 +1786,21 @@ namespace Json
         iter += 1;
         length -= 1;
 
-        std::ostringstream output;
+        const std::string_view::const_iterator start = iter;
+        // Characters between two escape sequences are copied all at once
+        std::string_view::const_iterator run_start = iter;
+        bool escaped = false;
         while (length)
         {
+            // Only the chars ending the string or starting an escape sequence are looked at one by one
+            const size_t plain = PlainStringLength(&*iter, length);
+            iter += plain;
+            length -= plain;
+            if (length == 0)
+            {
+                break;
+            }
+
             switch (*iter)
             {
             case '\b':
@@ -698,82 +1810,74 @@ namespace Json
             case '\t':
                 throw std::runtime_error("Unexpected unescaped special character encountered when parsing string");
             case '"':
+            {
+                const std::string_view raw(&*start, iter - start);
                 iter += 1;
                 length -= 1;
-                return output.str();
+                if (!escaped)
+                {
+                    return raw;
+                }
+                unescaped.append(&*run_start, raw.data() + raw.size() - &*run_start);
+                return std::nullopt;
+            }
             case '\\':
                 if (length == 1)
                 {
                     throw std::runtime_error("Missing data after escape character when parsing string");
                 }
-                else
+                if (!escaped)
+                {
+                    escaped = true;
+                    unescaped.reserve(2 * (iter - start));
+                }
+                unescaped.append(&*run_start, iter - run_start);
+                switch (*(iter + 1))
                 {
-                    switch (*(iter + 1))
+                case '\"':
+                    unescaped.push_back('"');
+                    break;
+                case '\\':
+                    unescaped.push_back('\\');
+                    break;
+                case '/':
+                    unescaped.push_back('/');
+                    break;
+                case 'b':
+                    unescaped.push_back('\b');
+                    break;
+                case 'f':
+                    unescaped.push_back('\f');
+                    break;
+                case 'n':
+                    unescaped.push_back('\n');
+                    break;
+                case 'r':
+                    unescaped.push_back('\r');
+                    break;
+                case 't':
+                    unescaped.push_back('\t');
+                    break;
+                case 'u':
+                    if (length < 6)
                     {
-                    case '\"':
-                        output << *iter << *(iter + 1);
-                        iter += 2;
-                        length -= 2;
-                        break;
-                    case '\\':
-                        output << '\\';
-                        iter += 2;
-                        length -= 2;
-                        break;
-                    case '/':
-                        output << '/';
-                        iter += 2;
-                        length -= 2;
-                        break;
-                    case 'b':
-                        output << '\b';
-                        iter += 2;
-                        length -= 2;
-                        break;
-                    case 'f':
-                        output << '\f';
-                        iter += 2;
-                        length -= 2;
-                        break;
-                    case 'n':
-                        output << '\n';
-                        iter += 2;
-                        length -= 2;
-                        break;
-                    case 'r':
-                        output << '\r';
-                        iter += 2;
-                        length -= 2;
-                        break;
-                    case 't':
-                        output << '\t';
-                        iter += 2;
-                        length -= 2;
-                        break;
-                    case 'u':
-                        if (length < 6)
-                        {
-                            throw std::runtime_error("Missing data after \\u character when parsing string");
-                        }
-                        output << CodepointToUtf8(std::string(iter + 2, iter + 6));
-                        iter += 6;
-                        length -= 6;
-                        break;
-                    default:
-                        throw std::runtime_error("Unexpected escape character encountered when parsing string");
-                        break;
+                        throw std::runtime_error("Missing data after \\u character when parsing string");
                     }
+                    unescaped += CodepointToUtf8(std::string(iter + 2, iter + 6));
+                    iter += 4;
+                    length -= 4;
+                    break;
+                default:
+                    throw std::runtime_error("Unexpected escape character encountered when parsing string");
+                    break;
                 }
+                iter += 2;
+                length -= 2;
+                run_start = iter;
                 break;
             default:
-                if (*iter > -1 && *iter < 32)
-                {
-                    // Control characters are invalid
-                    throw std::runtime_error("Unexpected control character encountered when parsing string");
-                }
-                output << *iter;
-                iter += 1;
-                length -= 1;
+                // Control characters are invalid
+                throw std::runtime_error("Unexpected control character encountered when parsing string");
                 break;
             }
         }
@@ -781,7 +1885,24 @@ namespace Json
         throw std::runtime_error("Not enough input when reading string");
     }
 
-    Value ParseObject(std::string_view::const_iterator& iter, size_t& length)
+    template<typename H>
+    void ParseString(std::string_view::const_iterator& iter, size_t& length, H& handler)
+    {
+        std::string unescaped;
+        const std::optional<std::string_view> raw = ReadString(iter, length, unescaped);
+        // The builder can keep a view on the input as long as it isn't the temporary unescaped copy
+        if constexpr (std::is_same_v<H, ValueBuilder>)
+        {
+            handler.String(raw.has_value() ? raw.value() : std::string_view(unescaped), raw.has_value());
+        }
+        else
+        {
+            handler.String(raw.has_value() ? raw.value() : std::string_view(unescaped));
+        }
+    }
+
+    template<typename H>
+    void ParseObject(std::string_view::const_iterator& iter, size_t& length, H& handler)
     {
         if (length < 2)
         {
@@ -801,22 +1922,31 @@ namespace Json
             throw std::runtime_error("Not enough input when reading Object");
         }
 
-        Object output;
+        handler.StartObject();
         if (*iter == '}')
         {
             iter += 1;
             length -= 1;
-            return output;
+            handler.EndObject();
+            return;
         }
 
+        std::string key;
+
         while (length)
         {
             SkipSpaces(iter, length);
 
-            const Value key = ParseString(iter, length);
+            key.clear();
+            const std::optional<std::string_view> raw_key = ReadString(iter, length, key);
+            handler.Key(raw_key.has_value() ? raw_key.value() : std::string_view(key));
 
             SkipSpaces(iter, length);
 
+            if (length == 0)
+            {
+                break;
+            }
             if (*iter != ':')
             {
                 throw std::runtime_error(std::string("Unexpected char \"") + *iter + "\" when reading Object while expecting :");
@@ -826,16 +1956,20 @@ namespace Json
 
             SkipSpaces(iter, length);
 
-            const Value value = ParseValue(iter, length);
-            output[key.get<std::string>()] = value;
+            ParseValue(iter, length, handler);
 
             SkipSpaces(iter, length);
 
+            if (length == 0)
+            {
+                break;
+            }
             if (*iter == '}')
             {
                 iter += 1;
                 length -= 1;
-                return output;
+                handler.EndObject();
+                return;
             }
             else if (*iter != ',')
             {
@@ -849,7 +1983,8 @@ namespace Json
         throw std::runtime_error("Not enough input when reading Object");
     }
 
-    Value ParseArray(std::string_view::const_iterator& iter, size_t& length)
+    template<typename H>
+    void ParseArray(std::string_view::const_iterator& iter, size_t& length, H& handler)
     {
         if (length < 2)
         {
@@ -862,8 +1997,6 @@ namespace Json
         iter += 1;
         length -= 1;
 
-        Array output;
-
         SkipSpaces(iter, length);
 
         if (length == 0)
@@ -871,27 +2004,33 @@ namespace Json
             throw std::runtime_error("Not enough input when reading Array");
         }
 
+        handler.StartArray();
         if (*iter == ']')
         {
             iter += 1;
             length -= 1;
-            return output;
+            handler.EndArray();
+            return;
         }
 
         while (length)
         {
             SkipSpaces(iter, length);
 
-            const Value value = ParseValue(iter, length);
-            output.push_back(value);
+            ParseValue(iter, length, handler);
 
             SkipSpaces(iter, length);
 
+            if (length == 0)
+            {
+                break;
+            }
             if (*iter == ']')
             {
                 iter += 1;
                 length -= 1;
-                return output;
+                handler.EndArray();
+                return;
             }
             else if (*iter != ',')
             {
@@ -905,22 +2044,26 @@ namespace Json
         throw std::runtime_error("Not enough input when reading Array");
     }
 
-    Value ParseValue(std::string_view::const_iterator& iter, size_t& length)
+    template<typename H>
+    void ParseValue(std::string_view::const_iterator& iter, size_t& length, H& handler)
     {
         SkipSpaces(iter, length);
 
-        Value output;
+        if (length == 0)
+        {
+            throw std::runtime_error("Not enough input when reading value");
+        }
 
         switch (*iter)
         {
         case '{':
-            output = ParseObject(iter, length);
+            ParseObject(iter, length, handler);
             break;
         case '[':
-            output = ParseArray(iter, length);
+            ParseArray(iter, length, handler);
             break;
         case '\"':
-            output = ParseString(iter, length);
+            ParseString(iter, length, handler);
             break;
         case 'n':
             if (length < 4
@@ -934,6 +2077,7 @@ namespace Json
             {
                 iter += 4;
                 length -= 4;
+                handler.Null();
             }
             break;
         case 't':
@@ -948,7 +2092,7 @@ namespace Json
             {
                 iter += 4;
                 length -= 4;
-                output = true;
+                handler.Bool(true);
             }
             break;
         case 'f':
@@ -964,7 +2108,7 @@ namespace Json
             {
                 iter += 5;
                 length -= 5;
-                output = false;
+                handler.Bool(false);
             }
             break;
         case '0':
@@ -978,7 +2122,7 @@ namespace Json
         case '8':
         case '9':
         case '-':
-            output = ParseNumber(iter, length);
+            ParseNumber(iter, length, handler);
             break;
         default:
             throw std::runtime_error(std::string("Unexpected char \"") + *iter + "\"");
@@ -986,7 +2130,5 @@ namespace Json
         }
 
         SkipSpaces(iter, length);
-
-        return output;
     }
 }
@@ -0,0 +1,128 @@
+#include "ledger.hpp"
+#include "building.hpp"
+#include "node.hpp"
+#include "pin.hpp"
+#include "recipe.hpp"
+
+#include <algorithm>
+
+/// @brief Assign value to displayed only if it changed, so displayed keeps its cached strings
+/// @param displayed Value displayed in the UI
+/// @param value New value
+static void UpdateDisplayedValue(FractionalNumber& displayed, const FractionalNumber& value)
+{
+    if (displayed != value)
+    {
+        displayed = value;
+    }
+}
+
+/// @brief Move a sum accumulated during this frame into the displayed value and reset it
+/// @param sum Sum to commit, reset to 0
+/// @param displayed Value displayed in the UI
+static void CommitLedgerSum(FractionalNumber& sum, FractionalNumber& displayed)
+{
+    UpdateDisplayedValue(displayed, sum);
+    sum = 0;
+}
+
+bool Ledger::Update(const std::vector<std::unique_ptr<Node>>& nodes, const bool power_equal_clocks)
+{
+    bool has_variable_power = false;
+
+    // Gather all craft node stats (ins/outs/machines/power)
+    for (const auto& n : nodes)
+    {
+        if (n->IsCraft())
+        {
+            for (const auto& p : n->ins)
+            {
+                items[p->item].consumed += p->current_rate;
+            }
+            for (const auto& p : n->outs)
+            {
+                items[p->item].produced += p->current_rate;
+            }
+
+            const CraftNode* node = static_cast<const CraftNode*>(n.get());
+            MachineLedger& machine = machines[node->recipe->building];
+            machine.total.sum += node->current_rate;
+            machine.recipes[node->recipe].sum += node->current_rate;
+            power.sum += power_equal_clocks ? node->same_clock_power : node->last_underclock_power;
+            detailed_power[node->recipe].sum += power_equal_clocks ? node->same_clock_power : node->last_underclock_power;
+            has_variable_power |= node->recipe->building->variable_power;
+        }
+        else if (n->IsGroup())
+        {
+            const GroupNode* node = static_cast<const GroupNode*>(n.get());
+
+            for (const auto& [k, v] : node->inputs)
+            {
+                items[k].consumed += v;
+            }
+            for (const auto& [k, v] : node->outputs)
+            {
+                items[k].produced += v;
+            }
+
+            power.sum += power_equal_clocks ? node->same_clock_power : node->last_underclock_power;
+            has_variable_power |= node->variable_power;
+            for (const auto& [k, v] : node->total_machines)
+            {
+                machines[k].total.sum += v;
+            }
+            for (const auto& [k, v] : node->detailed_machines)
+            {
+                MachineLedger& machine = machines[k];
+                for (const auto& [k2, v2] : v)
+                {
+                    machine.recipes[k2].sum += v2;
+                }
+            }
+            for (const auto& [k, v] : (power_equal_clocks ? node->detailed_power_same_clock : node->detailed_power_last_underclock))
+            {
+                detailed_power[k].sum += v;
+            }
+        }
+    }
+
+    // Move this frame sums to the displayed values
+    for (auto& [item, l] : items)
+    {
+        // Items both consumed and produced are intermediates, only the difference is displayed as input/output
+        const FractionalNumber common = l.consumed < l.produced ? l.consumed : l.produced;
+        UpdateDisplayedValue(l.intermediate, common);
+        UpdateDisplayedValue(l.input, l.consumed - common);
+        UpdateDisplayedValue(l.output, l.produced - common);
+        l.consumed = 0;
+        l.produced = 0;
+    }
+    for (auto& [building, machine] : machines)
+    {
+        CommitLedgerSum(machine.total.sum, machine.total.value);
+        for (auto& [recipe, e] : machine.recipes)
+        {
+            CommitLedgerSum(e.sum, e.value);
+        }
+    }
+    for (auto& [recipe, e] : detailed_power)
+    {
+        CommitLedgerSum(e.sum, e.value);
+    }
+    CommitLedgerSum(power.sum, power.value);
+
+    sorted_detailed_power.clear();
+    for (auto& [recipe, e] : detailed_power)
+    {
+        if (e.value.GetNumerator() != 0)
+        {
+            sorted_detailed_power.emplace_back(recipe, &e.value);
+        }
+    }
+    // Recipe name as tie break so std::sort gives a stable order without std::stable_sort allocation
+    std::sort(sorted_detailed_power.begin(), sorted_detailed_power.end(), [](const auto& a, const auto& b) {
+        return a.second->GetValue() > b.second->GetValue() || (a.second->GetValue() == b.second->GetValue() && RecipePtrCompare()(a.first, b.first));
+    });
+
+    return has_variable_power;
+}
@@ -0,0 +1,564 @@
+#include "linear_program.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    /// @brief Smallest absolute value accepted as pivot element
+    constexpr double pivot_epsilon = 1e-9;
+    /// @brief Tolerance on basic variables (primal) and reduced costs (dual) sign
+    constexpr double feasibility_epsilon = 1e-9;
+    /// @brief Relative rhs perturbation during cold solves. Recipes programs are highly degenerate
+    /// (most items have a balance of 0), without it the simplex can stall on the same vertex for thousands of pivots
+    constexpr double perturbation_scale = 1e-6;
+
+    size_t MaxIterations(const size_t rows, const size_t cols)
+    {
+        return 10 * (rows + cols) + 1000;
+    }
+
+    /// @brief Deterministic pseudo random perturbation in [perturbation_scale, 2 * perturbation_scale[
+    double Perturbation(const size_t row)
+    {
+        return perturbation_scale * (1.0 + static_cast<double>((row * 2654435761u) % 1024) / 1024.0);
+    }
+}
+
+void LinearProgram::Tableau::Pivot(const size_t r, const size_t c)
+{
+    const size_t width = cols + 2;
+    double* pivot_row = data.data() + r * width;
+    const double inv_pivot = 1.0 / pivot_row[c];
+    for (size_t j = 0; j < width; ++j)
+    {
+        pivot_row[j] *= inv_pivot;
+    }
+    pivot_row[c] = 1.0;
+
+    for (size_t i = 0; i < rows + 1; ++i)
+    {
+        if (i == r)
+        {
+            continue;
+        }
+        double* row = data.data() + i * width;
+        const double factor = row[c];
+        if (factor == 0.0)
+        {
+            continue;
+        }
+        for (size_t j = 0; j < width; ++j)
+        {
+            row[j] -= factor * pivot_row[j];
+        }
+        row[c] = 0.0;
+    }
+    basis[r] = c;
+}
+
+size_t LinearProgram::AddVariable(const double cost)
+{
+    costs.push_back(cost);
+    warm_basis.clear();
+    return costs.size() - 1;
+}
+
+size_t LinearProgram::AddConstraint(const std::vector<std::pair<size_t, double>>& coefficients, const Relation relation, const double rhs)
+{
+    constraints.push_back(Constraint{ coefficients, relation, rhs });
+    warm_basis.clear();
+    return constraints.size() - 1;
+}
+
+void LinearProgram::SetCost(const size_t variable, const double cost)
+{
+    costs[variable] = cost;
+}
+
+void LinearProgram::SetRhs(const size_t constraint, const double rhs)
+{
+    constraints[constraint].rhs = rhs;
+}
+
+LinearProgram::Status LinearProgram::Solve()
+{
+    num_pivots = 0;
+
+    // Columns layout: structural variables, then one slack per inequality
+    num_columns = costs.size();
+    slack_columns.assign(constraints.size(), std::numeric_limits<size_t>::max());
+    for (size_t i = 0; i < constraints.size(); ++i)
+    {
+        if (constraints[i].relation != Relation::Equal)
+        {
+            slack_columns[i] = num_columns++;
+        }
+    }
+
+    Status status;
+    if (!SolveWarm(status))
+    {
+        status = SolveCold();
+    }
+
+    if (status == Status::Optimal)
+    {
+        ExtractSolution();
+        // Basis with remaining artificial columns can't be restored without them
+        if (std::all_of(tableau.basis.begin(), tableau.basis.end(), [&](const size_t c) { return c < num_columns; }))
+        {
+            warm_basis = tableau.basis;
+        }
+        else
+        {
+            warm_basis.clear();
+        }
+    }
+
+    return status;
+}
+
+const std::vector<double>& LinearProgram::GetSolution() const
+{
+    return solution;
+}
+
+double LinearProgram::GetObjective() const
+{
+    return objective;
+}
+
+size_t LinearProgram::GetNumPivots() const
+{
+    return num_pivots;
+}
+
+void LinearProgram::FillTableau(const size_t num_artificials)
+{
+    tableau.rows = constraints.size();
+    tableau.cols = num_columns + num_artificials;
+    tableau.data.assign((tableau.rows + 1) * (tableau.cols + 2), 0.0);
+    tableau.basis.assign(tableau.rows, std::numeric_limits<size_t>::max());
+
+    for (size_t i = 0; i < constraints.size(); ++i)
+    {
+        const Constraint& constraint = constraints[i];
+        for (const auto& [variable, coefficient] : constraint.coefficients)
+        {
+            tableau.At(i, variable) += coefficient;
+        }
+        if (constraint.relation == Relation::LessEqual)
+        {
+            tableau.At(i, slack_columns[i]) = 1.0;
+        }
+        else if (constraint.relation == Relation::GreaterEqual)
+        {
+            tableau.At(i, slack_columns[i]) = -1.0;
+        }
+        tableau.At(i, tableau.cols) = constraint.rhs;
+        tableau.At(i, tableau.cols + 1) = constraint.rhs;
+    }
+}
+
+void LinearProgram::ComputeReducedCosts()
+{
+    double* objective_row = tableau.data.data() + tableau.rows * (tableau.cols + 2);
+    std::fill(objective_row, objective_row + tableau.cols + 2, 0.0);
+    std::copy(costs.begin(), costs.end(), objective_row);
+
+    for (size_t r = 0; r < tableau.rows; ++r)
+    {
+        const size_t c = tableau.basis[r];
+        const double cost = c < costs.size() ? costs[c] : 0.0;
+        if (cost == 0.0)
+        {
+            continue;
+        }
+        for (size_t j = 0; j < tableau.cols + 2; ++j)
+        {
+            objective_row[j] -= cost * tableau.At(r, j);
+        }
+    }
+}
+
+LinearProgram::Status LinearProgram::RunPrimal(const size_t num_allowed_cols)
+{
+    const size_t rhs = tableau.cols;
+    const size_t objective_row = tableau.rows;
+    const size_t max_iterations = MaxIterations(tableau.rows, tableau.cols);
+    for (size_t iteration = 0; iteration < max_iterations; ++iteration)
+    {
+        // Entering column: most negative reduced cost
+        size_t entering = std::numeric_limits<size_t>::max();
+        double best_cost = -feasibility_epsilon;
+        for (size_t j = 0; j < num_allowed_cols; ++j)
+        {
+            const double d = tableau.At(objective_row, j);
+            if (d < best_cost)
+            {
+                entering = j;
+                best_cost = d;
+            }
+        }
+        if (entering == std::numeric_limits<size_t>::max())
+        {
+            return Status::Optimal;
+        }
+
+        // Harris ratio test: get the max step with relaxed bounds, then pick
+        // the largest pivot element among the rows blocking before this step
+        double max_step = std::numeric_limits<double>::infinity();
+        for (size_t r = 0; r < tableau.rows; ++r)
+        {
+            const double a = tableau.At(r, entering);
+            if (a > pivot_epsilon)
+            {
+                max_step = std::min(max_step, (std::max(0.0, tableau.At(r, rhs)) + feasibility_epsilon) / a);
+            }
+        }
+        if (max_step == std::numeric_limits<double>::infinity())
+        {
+            return Status::Unbounded;
+        }
+        size_t leaving = std::numeric_limits<size_t>::max();
+        double best_pivot = 0.0;
+        for (size_t r = 0; r < tableau.rows; ++r)
+        {
+            const double a = tableau.At(r, entering);
+            if (a > pivot_epsilon && std::max(0.0, tableau.At(r, rhs)) / a <= max_step && a > best_pivot)
+            {
+                leaving = r;
+                best_pivot = a;
+            }
+        }
+
+        tableau.Pivot(leaving, entering);
+        num_pivots += 1;
+        pivots_since_factorization += 1;
+    }
+
+    return Status::IterationLimit;
+}
+
+LinearProgram::Status LinearProgram::RunDual()
+{
+    const size_t rhs = tableau.cols;
+    const size_t objective_row = tableau.rows;
+    const size_t max_iterations = MaxIterations(tableau.rows, tableau.cols);
+    for (size_t iteration = 0; iteration < max_iterations; ++iteration)
+    {
+        // Leaving row: most negative basic variable
+        size_t leaving = std::numeric_limits<size_t>::max();
+        double most_negative = -feasibility_epsilon;
+        for (size_t r = 0; r < tableau.rows; ++r)
+        {
+            if (tableau.At(r, rhs) < most_negative)
+            {
+                leaving = r;
+                most_negative = tableau.At(r, rhs);
+            }
+        }
+        if (leaving == std::numeric_limits<size_t>::max())
+        {
+            return Status::Optimal;
+        }
+
+        // Harris ratio test on reduced costs, artificial columns can't enter
+        double max_step = std::numeric_limits<double>::infinity();
+        for (size_t j = 0; j < num_columns; ++j)
+        {
+            const double a = tableau.At(leaving, j);
+            if (a < -pivot_epsilon)
+            {
+                max_step = std::min(max_step, (std::max(0.0, tableau.At(objective_row, j)) + feasibility_epsilon) / -a);
+            }
+        }
+        if (max_step == std::numeric_limits<double>::infinity())
+        {
+            return Status::Infeasible;
+        }
+        size_t entering = std::numeric_limits<size_t>::max();
+        double best_pivot = 0.0;
+        for (size_t j = 0; j < num_columns; ++j)
+        {
+            const double a = tableau.At(leaving, j);
+            if (a < -pivot_epsilon && std::max(0.0, tableau.At(objective_row, j)) / -a <= max_step && -a > best_pivot)
+            {
+                entering = j;
+                best_pivot = -a;
+            }
+        }
+
+        tableau.Pivot(leaving, entering);
+        num_pivots += 1;
+        pivots_since_factorization += 1;
+    }
+
+    return Status::IterationLimit;
+}
+
+LinearProgram::Status LinearProgram::SolveCold()
+{
+    // A row can start with its slack in the basis if it has a +1 coefficient
+    // once the row is scaled to get a non negative rhs, else it needs an artificial
+    std::vector<double> row_signs(constraints.size(), 1.0);
+    std::vector<bool> needs_artificial(constraints.size(), false);
+    size_t num_artificials = 0;
+    for (size_t i = 0; i < constraints.size(); ++i)
+    {
+        const Constraint& constraint = constraints[i];
+        const double slack_sign = constraint.relation == Relation::LessEqual ? 1.0 : -1.0;
+        if (constraint.relation != Relation::Equal && slack_sign * constraint.rhs >= 0.0)
+        {
+            row_signs[i] = slack_sign;
+        }
+        else
+        {
+            row_signs[i] = constraint.rhs < 0.0 ? -1.0 : 1.0;
+            needs_artificial[i] = true;
+            num_artificials += 1;
+        }
+    }
+
+    FillTableau(num_artificials);
+    pivots_since_factorization = 0;
+
+    size_t artificial_column = num_columns;
+    double total_perturbation = 0.0;
+    const size_t rhs = tableau.cols;
+    const size_t objective_row = tableau.rows;
+    for (size_t i = 0; i < constraints.size(); ++i)
+    {
+        if (row_signs[i] < 0.0)
+        {
+            for (size_t j = 0; j < tableau.cols + 2; ++j)
+            {
+                tableau.At(i, j) = -tableau.At(i, j);
+            }
+        }
+        const double perturbation = Perturbation(i) * std::max(1.0, tableau.At(i, rhs));
+        tableau.At(i, rhs) += perturbation;
+        total_perturbation += perturbation;
+
+        if (needs_artificial[i])
+        {
+            tableau.At(i, artificial_column) = 1.0;
+            tableau.basis[i] = artificial_column;
+            artificial_column += 1;
+            // Phase 1 minimizes the sum of artificials
+            for (size_t j = 0; j < num_columns; ++j)
+            {
+                tableau.At(objective_row, j) -= tableau.At(i, j);
+            }
+            tableau.At(objective_row, rhs) -= tableau.At(i, rhs);
+            tableau.At(objective_row, rhs + 1) -= tableau.At(i, rhs + 1);
+        }
+        else
+        {
+            tableau.basis[i] = slack_columns[i];
+        }
+    }
+
+    if (num_artificials > 0)
+    {
+        const Status phase_one = RunPrimal(tableau.cols);
+        if (phase_one != Status::Optimal)
+        {
+            return phase_one;
+        }
+        // Remaining infeasibility can come from the perturbation only
+        if (-tableau.At(objective_row, rhs) > 10.0 * total_perturbation)
+        {
+            return Status::Infeasible;
+        }
+
+        // Drive remaining artificials out of the basis when possible.
+        // If not, the row is redundant and the artificial stays basic
+        for (size_t r = 0; r < tableau.rows; ++r)
+        {
+            if (tableau.basis[r] < num_columns)
+            {
+                continue;
+            }
+            size_t best_col = std::numeric_limits<size_t>::max();
+            double best_value = pivot_epsilon;
+            for (size_t j = 0; j < num_columns; ++j)
+            {
+                if (std::abs(tableau.At(r, j)) > best_value)
+                {
+                    best_col = j;
+                    best_value = std::abs(tableau.At(r, j));
+                }
+            }
+            if (best_col != std::numeric_limits<size_t>::max())
+            {
+                tableau.Pivot(r, best_col);
+                num_pivots += 1;
+            }
+        }
+    }
+
+    ComputeReducedCosts();
+    const Status phase_two = RunPrimal(num_columns);
+    if (phase_two != Status::Optimal)
+    {
+        return phase_two;
+    }
+
+    return RemovePerturbation();
+}
+
+LinearProgram::Status LinearProgram::RemovePerturbation()
+{
+    for (size_t r = 0; r < tableau.rows + 1; ++r)
+    {
+        tableau.At(r, tableau.cols) = tableau.At(r, tableau.cols + 1);
+    }
+
+    // The basis is still dual feasible, only a few dual pivots are needed if some variables became negative
+    const Status status = RunDual();
+    if (status != Status::Optimal)
+    {
+        return status;
+    }
+    return RunPrimal(num_columns);
+}
+
+bool LinearProgram::SolveWarm(Status& status)
+{
+    if (warm_basis.size() != constraints.size() || constraints.empty())
+    {
+        return false;
+    }
+
+    // The last optimal tableau can be used as is if there were not too many pivots since
+    // it was factorized, else rounding errors pile up and it's rebuilt from the constraints
+    if (tableau.basis == warm_basis && pivots_since_factorization < tableau.rows &&
+        std::none_of(constraints.begin(), constraints.end(), [](const Constraint& c) { return c.relation == Relation::Equal; }))
+    {
+        UpdateTableauRhs();
+    }
+    else
+    {
+        FillTableau(0);
+        pivots_since_factorization = 0;
+        // Same perturbation as cold solves, loosening each inequality, to avoid stalling on degenerate vertices
+        for (size_t i = 0; i < constraints.size(); ++i)
+        {
+            if (constraints[i].relation != Relation::Equal)
+            {
+                tableau.At(i, tableau.cols) += (constraints[i].relation == Relation::LessEqual ? 1.0 : -1.0) * Perturbation(i) * std::max(1.0, std::abs(constraints[i].rhs));
+            }
+        }
+
+        // Gauss-Jordan elimination on the basis columns, with partial pivoting
+        std::vector<bool> assigned(tableau.rows, false);
+        for (const size_t c : warm_basis)
+        {
+            size_t best_row = std::numeric_limits<size_t>::max();
+            double best_value = pivot_epsilon;
+            for (size_t r = 0; r < tableau.rows; ++r)
+            {
+                if (!assigned[r] && std::abs(tableau.At(r, c)) > best_value)
+                {
+                    best_row = r;
+                    best_value = std::abs(tableau.At(r, c));
+                }
+            }
+            if (best_row == std::numeric_limits<size_t>::max())
+            {
+                return false;
+            }
+            tableau.Pivot(best_row, c);
+            assigned[best_row] = true;
+        }
+    }
+
+    ComputeReducedCosts();
+
+    bool primal_feasible = true;
+    for (size_t r = 0; r < tableau.rows; ++r)
+    {
+        primal_feasible &= tableau.At(r, tableau.cols) >= -feasibility_epsilon;
+    }
+    bool dual_feasible = true;
+    // Artificial columns left by a cold solve can't enter the basis
+    for (size_t j = 0; j < num_columns; ++j)
+    {
+        dual_feasible &= tableau.At(tableau.rows, j) >= -feasibility_epsilon;
+    }
+
+    if (primal_feasible)
+    {
+        // Only costs changed (or nothing at all)
+        status = RunPrimal(num_columns);
+    }
+    else if (dual_feasible)
+    {
+        // Only rhs changed, dual simplex restores primal feasibility in a few pivots
+        status = RunDual();
+        if (status == Status::Optimal)
+        {
+            status = RunPrimal(num_columns);
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    if (status == Status::Optimal)
+    {
+        status = RemovePerturbation();
+    }
+
+    // Stalling from a degenerate basis, or numerical noise making the dual ratio test fail.
+    // A cold solve is more robust and is the only one trusted to report a non optimal status
+    return status == Status::Optimal;
+}
+
+void LinearProgram::UpdateTableauRhs()
+{
+    // Each slack column is (up to its sign) a column of the inverse of the basis
+    // matrix, so the new rhs is a combination of them. Rows flipped during the
+    // cold solve don't matter, both the slack and the rhs of the row were flipped
+    const size_t rhs = tableau.cols;
+    for (size_t r = 0; r < tableau.rows; ++r)
+    {
+        tableau.At(r, rhs) = 0.0;
+        tableau.At(r, rhs + 1) = 0.0;
+    }
+    for (size_t i = 0; i < constraints.size(); ++i)
+    {
+        const double value = (constraints[i].relation == Relation::LessEqual ? 1.0 : -1.0) * constraints[i].rhs;
+        const double perturbed_value = value + Perturbation(i) * std::max(1.0, std::abs(constraints[i].rhs));
+        for (size_t r = 0; r < tableau.rows; ++r)
+        {
+            const double a = tableau.At(r, slack_columns[i]);
+            if (a != 0.0)
+            {
+                tableau.At(r, rhs) += perturbed_value * a;
+                tableau.At(r, rhs + 1) += value * a;
+            }
+        }
+    }
+}
+
+void LinearProgram::ExtractSolution()
+{
+    solution.assign(costs.size(), 0.0);
+    for (size_t r = 0; r < tableau.rows; ++r)
+    {
+        if (tableau.basis[r] < costs.size())
+        {
+            solution[tableau.basis[r]] = std::max(0.0, tableau.At(r, tableau.cols));
+        }
+    }
+    objective = 0.0;
+    for (size_t j = 0; j < costs.size(); ++j)
+    {
+        objective += costs[j] * solution[j];
+    }
+}
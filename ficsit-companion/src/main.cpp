@@ -1,5 +1,10 @@
 #include <chrono>
+#include <cstdlib>
+#include <memory>
 #if !defined(__EMSCRIPTEN__)
+#include <fstream>
+#include <iostream>
+#include <sstream>
 #include <thread>
 #endif
 
@@ -18,7 +23,7 @@
 #include <emscripten.h>
 #include <emscripten/html5.h> // emscripten_set_beforeunload_callback
 #else
-// STB_IMAGE_IMPLEMENTATION is already defined in utils.cpp
+// STB_IMAGE_IMPLEMENTATION is already defined in texture_manager.cpp
 #include "stb_image.h"
 #if NDEBUG && defined(_WIN32)
 #include <windows.h>
@@ -27,6 +32,114 @@
 
 #include "app.hpp"
 #include "game_data.hpp"
+#include "json.hpp"
+#include "scenario_sweep.hpp"
+#include "startup_timeline.hpp"
+#include "texture_manager.hpp"
+#include "utils.hpp"
+
+/// @brief What to do with the startup timeline once the first fully loaded frame is displayed
+struct StartupOptions
+{
+    /// @brief If true, print the timeline and save it as a Chrome trace file
+    bool report = false;
+    /// @brief If > 0, quit with an error code if the startup took longer (ms)
+    double budget = 0.0;
+    /// @brief Exit code of the app
+    int exit_code = 0;
+} startup_options;
+
+/// @brief Path of the Chrome trace file saved with --startup-report
+constexpr const char* startup_trace_file = "startup_trace.json";
+
+/// @brief Stop the startup timeline and report it if asked to
+/// @return False if the app should quit
+bool FinishStartup()
+{
+    StartupTimeline::Set(StartupTimeline::Counter::TextureBytes, GetTextureResidentBytes());
+    StartupTimeline::Finish();
+
+    if (startup_options.report)
+    {
+        printf("%s", StartupTimeline::Report().c_str());
+#if !defined(__EMSCRIPTEN__)
+        std::ofstream trace(startup_trace_file);
+        StartupTimeline::ChromeTrace().Dump(trace);
+        printf("Chrome trace saved to %s\n", startup_trace_file);
+#endif
+    }
+
+    if (startup_options.budget > 0.0)
+    {
+        const bool over_budget = StartupTimeline::TotalMilliseconds() > startup_options.budget;
+        printf("Startup took %.1f ms, budget is %.1f ms%s\n", StartupTimeline::TotalMilliseconds(), startup_options.budget, over_budget ? " (OVER BUDGET)" : "");
+        startup_options.exit_code = over_budget ? 1 : 0;
+        // Only used to measure the startup
+        return false;
+    }
+    return true;
+}
+
+#if !defined(__EMSCRIPTEN__)
+/// @brief Evaluate scenarios on a save without creating any window
+/// @param save_path Path to a save file
+/// @param scenarios_path Path to a json list of scenarios
+/// @param output_path Output file, .json for a json output, anything else for CSV. Empty to print CSV to stdout
+/// @return Process exit code
+int RunSweep(const std::string& save_path, const std::string& scenarios_path, const std::string& output_path)
+{
+    try
+    {
+        std::ifstream save_file(save_path);
+        if (!save_file.good())
+        {
+            throw std::runtime_error("Can't open save file " + save_path);
+        }
+        std::stringstream save_content;
+        save_content << save_file.rdbuf();
+        Json::Value save = Json::Parse(save_content.str());
+        if (!UpdateSave(save, App::SAVE_VERSION))
+        {
+            throw std::runtime_error("Save format not supported with this version");
+        }
+        // Evaluate the save with the game data it was made with
+        Data::LoadData(save.contains("game") ? save["game"].get_string() : "satisfactory", false);
+
+        std::ifstream scenarios_file(scenarios_path);
+        if (!scenarios_file.good())
+        {
+            throw std::runtime_error("Can't open scenarios file " + scenarios_path);
+        }
+        std::stringstream scenarios_content;
+        scenarios_content << scenarios_file.rdbuf();
+        // Keep number literals so decimal rates are converted exactly, without going through a double
+        const Json::Value scenarios_json = Json::Parse(scenarios_content.str(), false, true);
+        std::vector<ScenarioSweep::Scenario> scenarios = ScenarioSweep::ParseScenarios(scenarios_json);
+        // Always evaluate the save as is first, as a reference
+        scenarios.insert(scenarios.begin(), ScenarioSweep::Scenario{ "baseline", {} });
+
+        const std::vector<ScenarioSweep::Result> results = ScenarioSweep::Run(save, scenarios);
+
+        const bool json_output = output_path.size() > 5 && output_path.substr(output_path.size() - 5) == ".json";
+        const std::string output = json_output ? ScenarioSweep::ToJson(results).Dump(4) : ScenarioSweep::ToCSV(results);
+        if (output_path.empty())
+        {
+            std::cout << output;
+        }
+        else
+        {
+            std::ofstream output_file(output_path);
+            output_file << output;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return -1;
+    }
+    return 0;
+}
+#endif
 
 bool Render(SDL_Window* window, App* app)
 {
@@ -112,9 +225,14 @@ bool Render(SDL_Window* window, App* app)
         }
     }
 
+    StartupTimeline::ScopedTimer frame_timer("Frame");
     const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    // Icons are decoded in the background, upload a few of them each frame so startup doesn't wait for all of them
+    StartupTimeline::ScopedTimer upload_timer("UploadLoadedTextures");
+    const bool loading_textures = UploadLoadedTextures(16);
+    upload_timer.Stop();
     // If no user interaction, go down to 5 FPS to save some CPU
-    const std::chrono::steady_clock::time_point end = start + std::chrono::milliseconds(app->HasRecentInteraction() ? 16 : 200);
+    const std::chrono::steady_clock::time_point end = start + std::chrono::milliseconds(app->HasRecentInteraction() || loading_textures ? 16 : 200);
 
     // Init imgui frame
     ImGui_ImplOpenGL3_NewFrame();
@@ -146,6 +264,15 @@ bool Render(SDL_Window* window, App* app)
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
     SDL_GL_SwapWindow(window);
 
+    // Startup is complete once a frame is displayed with all icons
+    if (!loading_textures && !StartupTimeline::IsFinished() && !FinishStartup())
+    {
+#if defined(__EMSCRIPTEN__)
+        emscripten_cancel_main_loop();
+#endif
+        return false;
+    }
+
 #if !defined(__EMSCRIPTEN__)
     std::this_thread::sleep_until(end);
 #else
@@ -160,6 +287,28 @@ bool Render(SDL_Window* window, App* app)
 
 int main(int argc, char* argv[])
 {
+#if !defined(__EMSCRIPTEN__)
+    // Headless mode: ficsit-companion --sweep save.fcs scenarios.json [output.csv|output.json]
+    if (argc > 3 && std::string(argv[1]) == "--sweep")
+    {
+        return RunSweep(argv[2], argv[3], argc > 4 ? argv[4] : "");
+    }
+
+    // Startup profiling: ficsit-companion [--startup-report] [--startup-budget ms]
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--startup-report")
+        {
+            startup_options.report = true;
+        }
+        else if (arg == "--startup-budget" && i + 1 < argc)
+        {
+            startup_options.budget = std::atof(argv[++i]);
+        }
+    }
+#endif
+
 #if NDEBUG && defined(_WIN32)
     // Hide console on Windows except if asked not to from the command line
     const std::vector<std::string> args(argv, argv + argc);
@@ -174,11 +323,13 @@ int main(int argc, char* argv[])
     }
 #endif
 
+    StartupTimeline::ScopedTimer sdl_timer("SDL_InitSubSystem");
     if (SDL_InitSubSystem(SDL_INIT_VIDEO) != 0)
     {
         printf("Error %s\n", SDL_GetError());
         return -1;
     }
+    sdl_timer.Stop();
 
     // Decide GL+GLSL versions
 #if defined(IMGUI_IMPL_OPENGL_ES2)
@@ -213,6 +364,7 @@ int main(int argc, char* argv[])
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
     SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
     SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
+    StartupTimeline::ScopedTimer window_timer("Create window");
     SDL_Window* window = SDL_CreateWindow(
         "Ficsit Companion",
         SDL_WINDOWPOS_CENTERED,
@@ -248,13 +400,17 @@ int main(int argc, char* argv[])
         }
     }
 #endif
+    window_timer.Stop();
 
+    StartupTimeline::ScopedTimer gl_timer("GL context");
     SDL_GLContext gl_context = SDL_GL_CreateContext(window);
     SDL_GL_MakeCurrent(window, gl_context);
     SDL_GL_SetSwapInterval(1); // Enable vsync
+    gl_timer.Stop();
 
     // imgui: setup context
     // ---------------------------------------
+    StartupTimeline::ScopedTimer imgui_timer("ImGui init");
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     // Don't save window layout in ini file
@@ -268,18 +424,22 @@ int main(int argc, char* argv[])
     // Setup platform/renderer
     ImGui_ImplSDL2_InitForOpenGL(window, gl_context);
     ImGui_ImplOpenGL3_Init(glsl_version);
+    imgui_timer.Stop();
 
     Data::LoadData("satisfactory");
 
-    App app;
+    StartupTimeline::ScopedTimer app_timer("App::App");
+    // Destroyed before the GL context, as it releases its textures
+    std::unique_ptr<App> app = std::make_unique<App>();
+    app_timer.Stop();
 #if !defined(__EMSCRIPTEN__)
-    while (Render(window, &app))
+    while (Render(window, app.get()))
     {
 
     }
 #else
     // Write to localStorage when quitting
-    emscripten_set_beforeunload_callback(static_cast<void*>(&app), [](int event_type, const void* reserved, void* user_data) {
+    emscripten_set_beforeunload_callback(static_cast<void*>(app.get()), [](int event_type, const void* reserved, void* user_data) {
         // Save current session to disk
         static_cast<App*>(user_data)->SaveSession();
         // return empty string does not trigger the popup asking if we *really* want to quit
@@ -287,13 +447,17 @@ int main(int argc, char* argv[])
     });
 
     struct WindowApp { SDL_Window* window; App* app; };
-    WindowApp arg{ window, &app };
+    WindowApp arg{ window, app.get() };
     emscripten_set_main_loop_arg([](void* arg) {
         WindowApp* window_app = static_cast<WindowApp*>(arg);
         Render(window_app->window, window_app->app);
     }, &arg, 0, true);
 #endif
 
+    app.reset();
+    // Items release their icon when destroyed
+    Data::Unload();
+
     // ImGui cleaning
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplSDL2_Shutdown();
@@ -310,5 +474,5 @@ int main(int argc, char* argv[])
     SDL_DestroyWindow(window);
     SDL_Quit();
 
-    return 0;
+    return startup_options.exit_code;
 }
@@ -137,8 +137,8 @@ CraftNode::CraftNode(const ax::NodeEditor::NodeId id, const std::function<unsign
         throw std::runtime_error("Trying to deserialize an unvalid node as a craft node");
     }
     recipe = nullptr;
-    const std::string& recipe_name = serialized["recipe"].get_string();
-    const auto it = std::find_if(Data::Recipes().begin(), Data::Recipes().end(), [&recipe_name](const std::unique_ptr<Recipe>& recipe) { return recipe->name == recipe_name; });
+    const std::string_view recipe_name = serialized["recipe"].get_string_view();
+    const auto it = std::find_if(Data::Recipes().begin(), Data::Recipes().end(), [&recipe_name](const std::shared_ptr<Recipe>& recipe) { return recipe->name == recipe_name; });
 
     if (it != Data::Recipes().end())
     {
@@ -268,7 +268,7 @@ GroupNode::GroupNode(const ax::NodeEditor::NodeId id, const std::function<unsign
     {
         throw std::runtime_error("Trying to deserialize an unvalid node as a group node");
     }
-    name = serialized["name"].get_string();
+    name = serialized["name"].get_string_view();
 
     unsigned long long int current_id = 0;
     auto local_id_generator = [&]() { return current_id++; };
@@ -346,7 +346,7 @@ Json::Value GroupNode::Serialize() const
     {
         serialized_nodes.push_back(n->Serialize());
     }
-    node["nodes"] = serialized_nodes;
+    node["nodes"] = std::move(serialized_nodes);
 
     auto get_node_index = [&](const Node* node) {
         for (int i = 0; i < nodes.size(); ++i)
@@ -396,7 +396,7 @@ Json::Value GroupNode::Serialize() const
             }}
         });
     }
-    node["links"] = serialized_links;
+    node["links"] = std::move(serialized_links);
 
     return node;
 }
@@ -574,8 +574,8 @@ void GroupNode::UpdateDetails()
         if (n->IsCraft())
         {
             const CraftNode* node = static_cast<const CraftNode*>(n.get());
-            total_machines[node->recipe->building->name] += node->current_rate;
-            detailed_machines[node->recipe->building->name][node->recipe] += node->current_rate;
+            total_machines[node->recipe->building] += node->current_rate;
+            detailed_machines[node->recipe->building][node->recipe] += node->current_rate;
             detailed_power_same_clock[node->recipe] += node->same_clock_power;
             detailed_power_last_underclock[node->recipe] += node->last_underclock_power;
         }
@@ -617,12 +617,12 @@ OrganizerNode::OrganizerNode(const ax::NodeEditor::NodeId id, const Json::Value&
     {
         throw std::runtime_error("Trying to deserialize an unvalid node as an organizer node");
     }
-    auto item_it = Data::Items().find(serialized["item"].get_string());
+    auto item_it = Data::Items().find(std::string(serialized["item"].get_string_view()));
     if (item_it != Data::Items().end())
     {
         item = item_it->second.get();
     }
-    else if (serialized["item"].get_string() != "")
+    else if (!serialized["item"].get_string_view().empty())
     {
         throw std::runtime_error("Unknown item when loading organizer node");
     }
@@ -653,7 +653,7 @@ Json::Value OrganizerNode::Serialize() const
             { "den", i->current_rate.GetDenominator() },
         });
     }
-    serialized["ins"] = ins_array;
+    serialized["ins"] = std::move(ins_array);
 
     Json::Array outs_array;
     outs_array.reserve(outs.size());
@@ -664,7 +664,7 @@ Json::Value OrganizerNode::Serialize() const
             { "den", o->current_rate.GetDenominator() },
         });
     }
-    serialized["outs"] = outs_array;
+    serialized["outs"] = std::move(outs_array);
 
     return serialized;
 }
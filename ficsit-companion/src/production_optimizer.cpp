@@ -0,0 +1,267 @@
+#include "production_optimizer.hpp"
+#include "game_data.hpp"
+#include "recipe.hpp"
+#include "recipe_graph.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace
+{
+    /// @brief Rhs of the cap constraint of raw items without user cap, keeps the program structure constant
+    constexpr double uncapped_rate = 1e9;
+    /// @brief Weight of the secondary terms of the objective, to break ties between equivalent solutions
+    constexpr double tie_break_weight = 1e-4;
+    /// @brief Solution values below this are considered 0
+    constexpr double zero_threshold = 1e-6;
+    /// @brief All machine counts are multiples of 1/machines_grid, so summing them never overflows the fractions.
+    /// Its small factors keep the usual values (1/3, 1/4, 5/6, 1/7...) exact
+    constexpr long long int machines_grid = 2 * 2 * 2 * 2 * 3 * 3 * 5 * 5 * 5 * 5 * 7;
+    constexpr double fraction_tolerance = 1e-9;
+    /// @brief Max number of passes to fix the deficits caused by rounding, more than one is only needed for long chains or cycles
+    constexpr size_t max_rounding_passes = 100;
+
+    /// @brief Get the closest fraction to x with a bounded denominator using continued fractions.
+    /// Simplex vertices of recipes programs are small fractions so this usually recovers the exact value
+    FractionalNumber ToFraction(const double x)
+    {
+        long long int p0 = 0, q0 = 1, p1 = 1, q1 = 0;
+        double remainder = x;
+        for (int i = 0; i < 32; ++i)
+        {
+            const long long int a = static_cast<long long int>(std::floor(remainder));
+            const long long int p2 = a * p1 + p0;
+            const long long int q2 = a * q1 + q0;
+            if (q2 > machines_grid)
+            {
+                break;
+            }
+            p0 = p1; q0 = q1;
+            p1 = p2; q1 = q2;
+            const double frac = remainder - static_cast<double>(a);
+            if (std::abs(x - static_cast<double>(p1) / static_cast<double>(q1)) < fraction_tolerance * std::max(1.0, x) || frac < 1e-12)
+            {
+                break;
+            }
+            remainder = 1.0 / frac;
+        }
+        return FractionalNumber(p1, q1);
+    }
+
+    /// @brief Keep f if it's on the machines grid, else round it up to the next grid value
+    FractionalNumber RoundUp(const FractionalNumber& f)
+    {
+        if (machines_grid % f.GetDenominator() == 0)
+        {
+            return f;
+        }
+        return FractionalNumber(static_cast<long long int>(std::ceil(f.GetValue() * machines_grid)), machines_grid);
+    }
+}
+
+void ProductionOptimizer::SetRecipes(const std::vector<const Recipe*>& recipes_, const std::vector<const Recipe*>& switchable)
+{
+    program = LinearProgram();
+    recipes = recipes_;
+    item_constraints.clear();
+    raw_items.clear();
+    raw_variables.clear();
+    cap_constraints.clear();
+    switch_constraints.clear();
+
+    // Net production coefficients of each item, sorted to get a deterministic program
+    std::map<const Item*, std::vector<std::pair<size_t, double>>, ItemPtrCompare> balances;
+    for (size_t i = 0; i < recipes.size(); ++i)
+    {
+        program.AddVariable(0.0);
+        for (const auto& in : recipes[i]->ins)
+        {
+            balances[in.item].emplace_back(i, -in.quantity.GetValue());
+        }
+        for (const auto& out : recipes[i]->outs)
+        {
+            balances[out.item].emplace_back(i, out.quantity.GetValue());
+        }
+    }
+
+    for (auto& [item, coefficients] : balances)
+    {
+        if (Data::Graph().IsRaw(item))
+        {
+            const size_t variable = program.AddVariable(0.0);
+            coefficients.emplace_back(variable, 1.0);
+            raw_items.push_back(item);
+            raw_variables.push_back(variable);
+            cap_constraints.push_back(program.AddConstraint({ { variable, 1.0 } }, LinearProgram::Relation::LessEqual, uncapped_rate));
+        }
+        // Surplus is allowed, every item must be produced at least as much as it's consumed
+        item_constraints[item] = program.AddConstraint(coefficients, LinearProgram::Relation::GreaterEqual, 0.0);
+    }
+
+    // Disabling a recipe is done with a cap on its machines. Changing a rhs keeps the
+    // basis so solving again with another set of enabled recipes is a warm start
+    for (size_t i = 0; i < recipes.size(); ++i)
+    {
+        if (std::find(switchable.begin(), switchable.end(), recipes[i]) != switchable.end())
+        {
+            switch_constraints[recipes[i]] = program.AddConstraint({ { i, 1.0 } }, LinearProgram::Relation::LessEqual, uncapped_rate);
+        }
+    }
+}
+
+void ProductionOptimizer::SetRecipeEnabled(const Recipe* recipe, const bool enabled)
+{
+    const auto it = switch_constraints.find(recipe);
+    if (it != switch_constraints.end())
+    {
+        program.SetRhs(it->second, enabled ? uncapped_rate : 0.0);
+    }
+}
+
+ProductionOptimizer::Result ProductionOptimizer::Solve(const std::vector<std::pair<const Item*, double>>& targets, const std::vector<std::pair<const Item*, double>>& caps, const Objective objective)
+{
+    Result result;
+
+    for (const auto& [item, constraint] : item_constraints)
+    {
+        program.SetRhs(constraint, 0.0);
+    }
+    for (const auto& [item, rate] : targets)
+    {
+        const auto it = item_constraints.find(item);
+        if (it == item_constraints.end())
+        {
+            // No usable recipe produces this item
+            return result;
+        }
+        program.SetRhs(it->second, rate);
+    }
+
+    for (const size_t constraint : cap_constraints)
+    {
+        program.SetRhs(constraint, uncapped_rate);
+    }
+    for (const auto& [item, rate] : caps)
+    {
+        const auto it = std::find(raw_items.begin(), raw_items.end(), item);
+        if (it != raw_items.end())
+        {
+            program.SetRhs(cap_constraints[std::distance(raw_items.begin(), it)], rate);
+        }
+    }
+
+    for (size_t i = 0; i < recipes.size(); ++i)
+    {
+        switch (objective)
+        {
+        case Objective::RawResources:
+            program.SetCost(i, tie_break_weight * recipes[i]->power);
+            break;
+        case Objective::Power:
+            program.SetCost(i, recipes[i]->power);
+            break;
+        case Objective::Buildings:
+            program.SetCost(i, 1.0);
+            break;
+        }
+    }
+    for (const size_t variable : raw_variables)
+    {
+        program.SetCost(variable, objective == Objective::RawResources ? 1.0 : tie_break_weight);
+    }
+
+    result.status = program.Solve();
+    result.num_pivots = program.GetNumPivots();
+    if (result.status != LinearProgram::Status::Optimal)
+    {
+        return result;
+    }
+
+    const std::vector<double>& solution = program.GetSolution();
+    for (size_t i = 0; i < raw_items.size(); ++i)
+    {
+        if (solution[raw_variables[i]] > zero_threshold)
+        {
+            result.raw.emplace_back(raw_items[i], solution[raw_variables[i]]);
+            result.total_raw += solution[raw_variables[i]];
+        }
+    }
+    for (size_t i = 0; i < recipes.size(); ++i)
+    {
+        if (solution[i] > zero_threshold)
+        {
+            result.recipes.emplace_back(recipes[i], RoundUp(ToFraction(solution[i])));
+        }
+    }
+
+    // Rounding errors can leave some produced items slightly in deficit, which would
+    // leave some inputs unconnected once converted to nodes. Add enough machines to the
+    // main producer of these items to get an exact balance (or a tiny surplus).
+    // Extracted items don't need it, the missing amount is just extracted too
+    std::map<const Item*, FractionalNumber, ItemPtrCompare> balance;
+    for (size_t pass = 0; pass < max_rounding_passes; ++pass)
+    {
+        balance.clear();
+        for (const auto& [item, rate] : targets)
+        {
+            balance[item] -= ToFraction(rate);
+        }
+        for (const auto& [recipe, machines] : result.recipes)
+        {
+            for (const auto& in : recipe->ins)
+            {
+                balance[in.item] -= in.quantity * machines;
+            }
+            for (const auto& out : recipe->outs)
+            {
+                balance[out.item] += out.quantity * machines;
+            }
+        }
+
+        bool balanced = true;
+        for (const auto& [item, value] : balance)
+        {
+            if (!(value < FractionalNumber(0)) || std::any_of(result.raw.begin(), result.raw.end(), [&](const auto& p) { return p.first == item; }))
+            {
+                continue;
+            }
+            FractionalNumber* producer_machines = nullptr;
+            FractionalNumber producer_quantity;
+            for (auto& [recipe, machines] : result.recipes)
+            {
+                for (const auto& out : recipe->outs)
+                {
+                    if (out.item == item && out.quantity > producer_quantity)
+                    {
+                        producer_machines = &machines;
+                        producer_quantity = out.quantity;
+                    }
+                }
+            }
+            if (producer_machines != nullptr)
+            {
+                *producer_machines = RoundUp(*producer_machines + (FractionalNumber(0) - value) / producer_quantity);
+                balanced = false;
+            }
+        }
+        if (balanced)
+        {
+            break;
+        }
+    }
+
+    for (const auto& [recipe, machines] : result.recipes)
+    {
+        result.power += machines.GetValue() * recipe->power;
+        result.machines += machines.GetValue();
+    }
+
+    return result;
+}
+
+const std::vector<const Item*>& ProductionOptimizer::RawItems() const
+{
+    return raw_items;
+}
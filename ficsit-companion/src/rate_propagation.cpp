@@ -0,0 +1,300 @@
+#include "rate_propagation.hpp"
+#include "building.hpp"
+#include "link.hpp"
+#include "node.hpp"
+#include "pin.hpp"
+#include "recipe.hpp"
+
+#include <unordered_map>
+
+/// @brief Max number of times a pin can be updated during one propagation. Some loops
+/// (e.g. splitters feeding back into their own chain) never settle and would run forever
+static constexpr size_t max_pin_updates = 64;
+
+bool PropagateRates(std::queue<std::pair<const Pin*, Constraint>>& updating_pins, const std::vector<std::unique_ptr<Node>>& nodes)
+{
+    if (updating_pins.size() == 0)
+    {
+        return true;
+    }
+    bool converged = true;
+    std::unordered_map<const Pin*, Constraint> updated_pins;
+    std::unordered_map<const Pin*, size_t> updated_count;
+
+    auto GetConstraint = [&](const Pin* p)
+        {
+            auto it = updated_pins.find(p);
+            return it == updated_pins.end() ? Constraint::None : it->second;
+        };
+
+    while (!updating_pins.empty())
+    {
+        const auto [updating_pin, updating_constraint] = updating_pins.front();
+        updating_pins.pop();
+        updated_pins[updating_pin] = updating_constraint;
+        if (++updated_count[updating_pin] > max_pin_updates)
+        {
+            converged = false;
+            break;
+        }
+
+        // Update node from this pin
+        switch (const Node::Kind kind = updating_pin->node->GetKind())
+        {
+        case Node::Kind::Craft:
+        {
+            CraftNode* node = static_cast<CraftNode*>(updating_pin->node);
+            // We can't use UpdateRate cause we wouldn't be able to know which pins have changed
+            if (updating_pin->direction == ax::NodeEditor::PinKind::Output)
+            {
+                node->current_rate = updating_pin->current_rate / (updating_pin->base_rate * (1 + node->num_somersloop * node->recipe->building->somersloop_mult));
+            }
+            else
+            {
+                node->current_rate = updating_pin->current_rate / updating_pin->base_rate;
+            }
+            node->ComputePowerUsage();
+            for (auto& p : node->ins)
+            {
+                const FractionalNumber new_rate = node->current_rate * p->base_rate;
+                if (new_rate == p->current_rate)
+                {
+                    continue;
+                }
+                p->current_rate = new_rate;
+                updated_pins[p.get()] = updating_constraint;
+
+                // Don't need to push it if it's not linked to anything
+                if (p->link != nullptr)
+                {
+                    updating_pins.push({ p.get(), updating_constraint });
+                }
+            }
+            for (auto& p : node->outs)
+            {
+                const FractionalNumber new_rate = node->current_rate * p->base_rate * (1 + (node->num_somersloop * node->recipe->building->somersloop_mult));
+                if (new_rate == p->current_rate)
+                {
+                    continue;
+                }
+                p->current_rate = new_rate;
+                updated_pins[p.get()] = updating_constraint;
+
+                // Don't need to push it if it's not linked to anything
+                if (p->link != nullptr)
+                {
+                    updating_pins.push({ p.get(), updating_constraint });
+                }
+            }
+            break;
+        }
+        case Node::Kind::Group:
+        {
+            GroupNode* node = static_cast<GroupNode*>(updating_pin->node);
+            // We can't use UpdateRate cause we wouldn't be able to know which pins have changed
+            node->current_rate = updating_pin->current_rate / updating_pin->base_rate;
+            node->PropagateRateToSubnodes();
+            node->ComputePowerUsage();
+            for (auto& p : node->ins)
+            {
+                const FractionalNumber new_rate = node->current_rate * p->base_rate;
+                if (new_rate == p->current_rate)
+                {
+                    continue;
+                }
+                p->current_rate = new_rate;
+                updated_pins[p.get()] = updating_constraint;
+
+                // Don't need to push it if it's not linked to anything
+                if (p->link != nullptr)
+                {
+                    updating_pins.push({ p.get(), updating_constraint });
+                }
+            }
+            for (auto& p : node->outs)
+            {
+                const FractionalNumber new_rate = node->current_rate * p->base_rate;
+                if (new_rate == p->current_rate)
+                {
+                    continue;
+                }
+                p->current_rate = new_rate;
+                updated_pins[p.get()] = updating_constraint;
+
+                // Don't need to push it if it's not linked to anything
+                if (p->link != nullptr)
+                {
+                    updating_pins.push({ p.get(), updating_constraint });
+                }
+            }
+            break;
+        }
+        case Node::Kind::Splitter:
+        case Node::Kind::Merger:
+        {
+            Node* node = updating_pin->node;
+            std::vector<std::unique_ptr<Pin>>& one_pin = kind == Node::Kind::Splitter ? node->ins : node->outs;
+            std::vector<std::unique_ptr<Pin>>& multi_pin = kind == Node::Kind::Splitter ? node->outs : node->ins;
+            // One of the "multi pin" side has been updated
+            if ((kind == Node::Kind::Splitter && updating_pin->direction == ax::NodeEditor::PinKind::Output) ||
+                (kind == Node::Kind::Merger && updating_pin->direction == ax::NodeEditor::PinKind::Input))
+            {
+                const Constraint constraint = GetConstraint(one_pin[0].get());
+                // Easy case, just sum all "multi pin" and update "single pin" side with the new value
+                if (constraint != Constraint::Strong)
+                {
+                    FractionalNumber new_rate = FractionalNumber(0, 1);
+                    const Pin* other_output_pin = nullptr;
+                    for (const auto& p : multi_pin)
+                    {
+                        new_rate += p->current_rate;
+                        if (p.get() != updating_pin)
+                        {
+                            other_output_pin = p.get();
+                        }
+                    }
+                    if (one_pin[0]->current_rate != new_rate)
+                    {
+                        one_pin[0]->current_rate = new_rate;
+                        const Constraint other_constraint = GetConstraint(other_output_pin);
+                        updating_pins.push({
+                            one_pin[0].get(),
+                            (updating_constraint == Constraint::Strong && other_constraint == Constraint::Strong) ? Constraint::Strong : Constraint::Weak
+                        });
+                    }
+                }
+                // We can't update "single pin", try to balance the node if there is a weaker constrained pin on the "multi pin" side
+                else
+                {
+                    Pin* other_pin = multi_pin[0].get() == updating_pin ? multi_pin[1].get() : multi_pin[0].get();
+                    Constraint other_constraint = GetConstraint(other_pin);
+                    if (other_constraint < Constraint::Strong && other_pin->link == nullptr)
+                    {
+                        other_constraint = Constraint::None;
+                    }
+                    // Can't balance
+                    if (other_constraint >= updating_constraint || one_pin[0]->current_rate < updating_pin->current_rate)
+                    {
+                        break;
+                    }
+
+                    const FractionalNumber new_rate = one_pin[0]->current_rate - updating_pin->current_rate;
+                    if (other_pin->current_rate != new_rate)
+                    {
+                        other_pin->current_rate = one_pin[0]->current_rate - updating_pin->current_rate;
+                        // If it's linked, propagate the update
+                        if (other_pin->link != nullptr)
+                        {
+                            updating_pins.push({
+                                other_pin,
+                                updating_constraint == Constraint::Strong ? Constraint::Strong : Constraint::Weak
+                                });
+                        }
+                    }
+                }
+            }
+            // More complicated case, "one pin" side is updated, how do we split the items with all the other pins ?
+            else
+            {
+                Constraint constraint_0 = GetConstraint(multi_pin[0].get());
+                if (constraint_0 != Constraint::Strong && multi_pin[0]->link == nullptr)
+                {
+                    constraint_0 = Constraint::None;
+                }
+                Constraint constraint_1 = GetConstraint(multi_pin[1].get());
+                if (constraint_1 != Constraint::Strong && multi_pin[0]->link == nullptr)
+                {
+                    constraint_1 = Constraint::None;
+                }
+                // If one of the "multi pins" has a stronger constraint, use the other one to adjust if possible
+                if (constraint_0 > constraint_1 || constraint_1 > constraint_0)
+                {
+                    const int constrained_idx = constraint_0 > constraint_1 ? 0 : 1;
+                    const int other_idx = 1 - constrained_idx;
+                    if (updating_pin->current_rate > multi_pin[constrained_idx]->current_rate)
+                    {
+                        multi_pin[other_idx]->current_rate = updating_pin->current_rate - multi_pin[constrained_idx]->current_rate;
+                        if (multi_pin[other_idx]->link != nullptr)
+                        {
+                            const Constraint stronger_constraint = constraint_0 > constraint_1 ? constraint_0 : constraint_1;
+                            updating_pins.push({
+                                multi_pin[other_idx].get(),
+                                updating_constraint == Constraint::Strong && stronger_constraint == Constraint::Strong ? Constraint::Strong : Constraint::Weak
+                                });
+                        }
+                    }
+                }
+                // Else if pins have both no or weak constraints then try to split the new rate keeping the same split ratio
+                else if (constraint_0 == constraint_1 && constraint_0 < Constraint::Strong)
+                {
+                    const FractionalNumber sum = multi_pin[0]->current_rate + multi_pin[1]->current_rate;
+                    for (int i = 0; i < multi_pin.size(); ++i)
+                    {
+                        const FractionalNumber new_rate = sum.GetNumerator() == 0 ? (updating_pin->current_rate / FractionalNumber(2, 1)) : ((multi_pin[i]->current_rate / sum) * updating_pin->current_rate);
+                        if (multi_pin[i]->current_rate != new_rate)
+                        {
+                            multi_pin[i]->current_rate = new_rate;
+                            updating_pins.push({ multi_pin[i].get(), Constraint::Weak });
+                        }
+                    }
+                }
+                // Else, we can't know how the split should be so do nothing and let the user adjust
+            }
+            break;
+        }
+        }
+
+        // If no link connected to this pin
+        if (updating_pin->link == nullptr)
+        {
+            continue;
+        }
+        Pin* updated_pin = updating_pin->direction == ax::NodeEditor::PinKind::Input ? updating_pin->link->start : updating_pin->link->end;
+
+        // If rate already match new one (or if it's probably in an infinite cycle loop)
+        if (updated_pin->current_rate == updating_pin->current_rate || updated_count[updated_pin] > 8)
+        {
+            continue;
+        }
+
+        // If already updated with strong constraint
+        const Constraint constraint = GetConstraint(updated_pin);
+        if (constraint == Constraint::Strong)
+        {
+            continue;
+        }
+
+        // If here, copy rate and schedule this pin to trigger updates too
+        updating_pin->link->flow = updating_pin->direction == ax::NodeEditor::PinKind::Input ? ax::NodeEditor::FlowDirection::Backward : ax::NodeEditor::FlowDirection::Forward;
+        updated_pin->current_rate = updating_pin->current_rate;
+        updating_pins.push({ updated_pin, updating_constraint });
+    }
+
+    // Just in case we exited the loop prematurely
+    while (!updating_pins.empty())
+    {
+        updating_pins.pop();
+    }
+
+    // Make sure all crafting nodes are still valid regarding their recipe
+    for (auto& n : nodes)
+    {
+        if (n->GetKind() != Node::Kind::Craft)
+        {
+            continue;
+        }
+
+        CraftNode* node = static_cast<CraftNode*>(n.get());
+
+        for (auto& p : n->ins)
+        {
+            p->current_rate = p->base_rate * node->current_rate;
+        }
+        for (auto& p : n->outs)
+        {
+            p->current_rate = p->base_rate * node->current_rate * (1 + (node->num_somersloop * node->recipe->building->somersloop_mult));
+        }
+    }
+
+    return converged;
+}
@@ -0,0 +1,360 @@
+#include "recipe_graph.hpp"
+#include "recipe.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    /// @brief Max number of relaxation passes inside a cycle before giving up on convergence
+    constexpr size_t max_relaxation_passes = 1000;
+    constexpr double relaxation_epsilon = 1e-9;
+
+    /// @brief Get the quantity of an item produced by a recipe
+    double OutputQuantity(const Recipe* recipe, const Item* item)
+    {
+        double quantity = 0.0;
+        for (const auto& o : recipe->outs)
+        {
+            if (o.item == item)
+            {
+                quantity += o.quantity.GetValue();
+            }
+        }
+        return quantity;
+    }
+
+    bool IsBetter(const double total, const double power, const double best_total, const double best_power)
+    {
+        if (best_total == std::numeric_limits<double>::infinity())
+        {
+            return true;
+        }
+        const double total_tolerance = relaxation_epsilon * std::max(1.0, best_total);
+        const double power_tolerance = relaxation_epsilon * std::max(1.0, best_power);
+        return total < best_total - total_tolerance ||
+            (total <= best_total + total_tolerance && power < best_power - power_tolerance);
+    }
+}
+
+void RecipeGraph::Build(const std::vector<std::shared_ptr<Recipe>>& recipes)
+{
+    items.clear();
+    item_indices.clear();
+
+    for (const auto& r : recipes)
+    {
+        for (const auto& i : r->ins)
+        {
+            items.push_back(i.item);
+        }
+        for (const auto& o : r->outs)
+        {
+            items.push_back(o.item);
+        }
+    }
+    std::sort(items.begin(), items.end(), ItemPtrCompare());
+    items.erase(std::unique(items.begin(), items.end()), items.end());
+
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        item_indices[items[i]] = i;
+    }
+
+    producers.assign(items.size(), {});
+    consumers.assign(items.size(), {});
+    for (const auto& r : recipes)
+    {
+        for (const auto& i : r->ins)
+        {
+            std::vector<const Recipe*>& c = consumers[item_indices.at(i.item)];
+            if (c.empty() || c.back() != r.get())
+            {
+                c.push_back(r.get());
+            }
+        }
+        for (const auto& o : r->outs)
+        {
+            std::vector<const Recipe*>& p = producers[item_indices.at(o.item)];
+            if (p.empty() || p.back() != r.get())
+            {
+                p.push_back(r.get());
+            }
+        }
+    }
+
+    is_raw.resize(items.size());
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        is_raw[i] = items[i]->is_resource || producers[i].empty();
+    }
+}
+
+bool RecipeGraph::IsRaw(const Item* item) const
+{
+    const auto it = item_indices.find(item);
+    return it == item_indices.end() ? item->is_resource : is_raw[it->second];
+}
+
+const std::vector<const Recipe*>& RecipeGraph::Producers(const Item* item) const
+{
+    static const std::vector<const Recipe*> empty;
+    const auto it = item_indices.find(item);
+    return it == item_indices.end() ? empty : producers[it->second];
+}
+
+const std::vector<const Recipe*>& RecipeGraph::Consumers(const Item* item) const
+{
+    static const std::vector<const Recipe*> empty;
+    const auto it = item_indices.find(item);
+    return it == item_indices.end() ? empty : consumers[it->second];
+}
+
+std::unordered_map<const Item*, RawCost> RecipeGraph::ComputeRawCosts(const std::function<bool(const Recipe*)>& is_allowed) const
+{
+    const size_t N = items.size();
+
+    // Dense index of raw items, cost vectors are stored as N x num_raw matrix
+    std::vector<size_t> raw_indices(N, std::numeric_limits<size_t>::max());
+    size_t num_raw = 0;
+    for (size_t i = 0; i < N; ++i)
+    {
+        if (is_raw[i])
+        {
+            raw_indices[i] = num_raw++;
+        }
+    }
+
+    std::vector<double> total(N, std::numeric_limits<double>::infinity());
+    std::vector<double> power(N, 0.0);
+    std::vector<double> raw(N * num_raw, 0.0);
+    std::vector<const Recipe*> best_recipe(N, nullptr);
+    for (size_t i = 0; i < N; ++i)
+    {
+        if (is_raw[i])
+        {
+            total[i] = 1.0;
+            raw[i * num_raw + raw_indices[i]] = 1.0;
+        }
+    }
+
+    // Allowed producers of each crafted item, and item --> input item edges as a flat adjacency list
+    std::vector<std::vector<const Recipe*>> allowed_producers(N);
+    std::vector<size_t> edge_offsets(N + 1, 0);
+    std::vector<size_t> edges;
+    for (size_t i = 0; i < N; ++i)
+    {
+        if (!is_raw[i])
+        {
+            for (const Recipe* r : producers[i])
+            {
+                if (is_allowed(r))
+                {
+                    allowed_producers[i].push_back(r);
+                    for (const auto& in : r->ins)
+                    {
+                        edges.push_back(item_indices.at(in.item));
+                    }
+                }
+            }
+        }
+        edge_offsets[i + 1] = edges.size();
+    }
+
+    // Relax the cost of all items in a strongly connected component until it stabilizes.
+    // For a single item without self loop, dependencies are already computed so one pass is enough
+    auto relax_component = [&](const std::vector<size_t>& component) {
+        for (size_t pass = 0; pass < max_relaxation_passes; ++pass)
+        {
+            bool changed = false;
+            for (const size_t i : component)
+            {
+                if (is_raw[i])
+                {
+                    continue;
+                }
+                double best_total = std::numeric_limits<double>::infinity();
+                double best_power = 0.0;
+                const Recipe* best = nullptr;
+                for (const Recipe* r : allowed_producers[i])
+                {
+                    const double out_quantity = OutputQuantity(r, items[i]);
+                    double t = 0.0;
+                    double p = r->power / out_quantity;
+                    bool valid = true;
+                    for (const auto& in : r->ins)
+                    {
+                        const size_t j = item_indices.at(in.item);
+                        if (total[j] == std::numeric_limits<double>::infinity())
+                        {
+                            valid = false;
+                            break;
+                        }
+                        const double k = in.quantity.GetValue() / out_quantity;
+                        t += k * total[j];
+                        p += k * power[j];
+                    }
+                    if (valid && IsBetter(t, p, best_total, best_power))
+                    {
+                        best_total = t;
+                        best_power = p;
+                        best = r;
+                    }
+                }
+                if (best == nullptr)
+                {
+                    continue;
+                }
+
+                changed |= best != best_recipe[i] || std::abs(best_total - total[i]) > relaxation_epsilon * std::max(1.0, best_total);
+                total[i] = best_total;
+                power[i] = best_power;
+                best_recipe[i] = best;
+
+                const double out_quantity = OutputQuantity(best, items[i]);
+                std::fill(raw.begin() + i * num_raw, raw.begin() + (i + 1) * num_raw, 0.0);
+                for (const auto& in : best->ins)
+                {
+                    const size_t j = item_indices.at(in.item);
+                    const double k = in.quantity.GetValue() / out_quantity;
+                    for (size_t r = 0; r < num_raw; ++r)
+                    {
+                        raw[i * num_raw + r] += k * raw[j * num_raw + r];
+                    }
+                }
+            }
+            if (!changed)
+            {
+                break;
+            }
+        }
+    };
+
+    // Iterative Tarjan, components are found in reverse topological order,
+    // meaning all inputs of a component are already computed when we reach it
+    std::vector<int> index(N, -1);
+    std::vector<int> low(N, 0);
+    std::vector<bool> on_stack(N, false);
+    std::vector<size_t> stack;
+    std::vector<std::pair<size_t, size_t>> call_stack;
+    std::vector<size_t> component;
+    int counter = 0;
+    auto visit = [&](const size_t v) {
+        index[v] = counter;
+        low[v] = counter;
+        counter += 1;
+        stack.push_back(v);
+        on_stack[v] = true;
+        call_stack.emplace_back(v, edge_offsets[v]);
+    };
+    for (size_t s = 0; s < N; ++s)
+    {
+        if (index[s] != -1)
+        {
+            continue;
+        }
+        visit(s);
+        while (!call_stack.empty())
+        {
+            const size_t v = call_stack.back().first;
+            if (call_stack.back().second < edge_offsets[v + 1])
+            {
+                const size_t w = edges[call_stack.back().second];
+                call_stack.back().second += 1;
+                if (index[w] == -1)
+                {
+                    visit(w);
+                }
+                else if (on_stack[w])
+                {
+                    low[v] = std::min(low[v], index[w]);
+                }
+                continue;
+            }
+
+            call_stack.pop_back();
+            if (!call_stack.empty())
+            {
+                const size_t u = call_stack.back().first;
+                low[u] = std::min(low[u], low[v]);
+            }
+            if (low[v] == index[v])
+            {
+                component.clear();
+                size_t w;
+                do
+                {
+                    w = stack.back();
+                    stack.pop_back();
+                    on_stack[w] = false;
+                    component.push_back(w);
+                } while (w != v);
+                relax_component(component);
+            }
+        }
+    }
+
+    std::unordered_map<const Item*, RawCost> costs;
+    for (size_t i = 0; i < N; ++i)
+    {
+        if (total[i] == std::numeric_limits<double>::infinity())
+        {
+            continue;
+        }
+        RawCost& cost = costs[items[i]];
+        cost.total = total[i];
+        cost.power = power[i];
+        cost.recipe = best_recipe[i];
+        // Raw indices follow items order, so raw items are already sorted by name
+        for (size_t j = 0; j < N; ++j)
+        {
+            if (is_raw[j] && raw[i * num_raw + raw_indices[j]] > 0.0)
+            {
+                cost.raw.emplace_back(items[j], raw[i * num_raw + raw_indices[j]]);
+            }
+        }
+    }
+
+    return costs;
+}
+
+std::optional<RawCost> RecipeGraph::RecipeCost(const Recipe* recipe, const Item* output, const std::unordered_map<const Item*, RawCost>& costs)
+{
+    const double out_quantity = OutputQuantity(recipe, output);
+    if (out_quantity == 0.0)
+    {
+        return std::nullopt;
+    }
+
+    RawCost cost;
+    cost.recipe = recipe;
+    cost.power = recipe->power / out_quantity;
+    for (const auto& in : recipe->ins)
+    {
+        const auto it = costs.find(in.item);
+        if (it == costs.end())
+        {
+            return std::nullopt;
+        }
+        const double k = in.quantity.GetValue() / out_quantity;
+        cost.total += k * it->second.total;
+        cost.power += k * it->second.power;
+        for (const auto& [raw_item, amount] : it->second.raw)
+        {
+            auto raw_it = std::find_if(cost.raw.begin(), cost.raw.end(), [&](const auto& p) { return p.first == raw_item; });
+            if (raw_it == cost.raw.end())
+            {
+                cost.raw.emplace_back(raw_item, k * amount);
+            }
+            else
+            {
+                raw_it->second += k * amount;
+            }
+        }
+    }
+    std::sort(cost.raw.begin(), cost.raw.end(), [](const auto& a, const auto& b) { return ItemPtrCompare()(a.first, b.first); });
+
+    return cost;
+}
@@ -0,0 +1,560 @@
+#include "scenario_sweep.hpp"
+#include "building.hpp"
+#include "game_data.hpp"
+#include "link.hpp"
+#include "node.hpp"
+#include "pin.hpp"
+#include "rate_propagation.hpp"
+#include "recipe.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace ScenarioSweep
+{
+    namespace
+    {
+        /// @brief Headless copy of a saved production graph
+        struct Graph
+        {
+            std::vector<std::unique_ptr<Node>> nodes;
+            std::vector<std::unique_ptr<Link>> links;
+            /// @brief Loaded node for each node of the save, nullptr if it couldn't be loaded
+            std::vector<Node*> save_nodes;
+            std::queue<std::pair<const Pin*, Constraint>> updating_pins;
+            unsigned long long int next_id = 1;
+
+            unsigned long long int GetNextId()
+            {
+                return next_id++;
+            }
+
+            void CreateLink(Pin* start, Pin* end)
+            {
+                links.emplace_back(std::make_unique<Link>(GetNextId(), start, end));
+                start->link = links.back().get();
+                end->link = links.back().get();
+                if (start->node->IsOrganizer())
+                {
+                    if (OrganizerNode* organizer_node = static_cast<OrganizerNode*>(start->node); organizer_node->item == nullptr)
+                    {
+                        organizer_node->ChangeItem(end->item);
+                    }
+                }
+                if (end->node->IsOrganizer())
+                {
+                    if (OrganizerNode* organizer_node = static_cast<OrganizerNode*>(end->node); organizer_node->item == nullptr)
+                    {
+                        organizer_node->ChangeItem(start->item);
+                    }
+                }
+            }
+
+            void DeleteLink(Link* link)
+            {
+                link->start->link = nullptr;
+                link->end->link = nullptr;
+                links.erase(std::find_if(links.begin(), links.end(), [link](const std::unique_ptr<Link>& l) { return l.get() == link; }));
+            }
+
+            /// @brief Same as App::Deserialize, without the node editor
+            void Load(const Json::Value& save)
+            {
+                const auto id_generator = [this]() { return GetNextId(); };
+                for (const auto& n : save["nodes"].get_array())
+                {
+                    try
+                    {
+                        nodes.emplace_back(Node::Deserialize(GetNextId(), id_generator, n));
+                        save_nodes.push_back(nodes.back().get());
+                    }
+                    catch (const std::exception&)
+                    {
+                        save_nodes.push_back(nullptr);
+                    }
+                }
+
+                for (const auto& l : save["links"].get_array())
+                {
+                    const size_t start_node_index = l["start"]["node"].get<int>();
+                    const size_t end_node_index = l["end"]["node"].get<int>();
+                    if (start_node_index >= save_nodes.size() || end_node_index >= save_nodes.size() ||
+                        save_nodes[start_node_index] == nullptr || save_nodes[end_node_index] == nullptr)
+                    {
+                        continue;
+                    }
+
+                    const Node* start_node = save_nodes[start_node_index];
+                    const Node* end_node = save_nodes[end_node_index];
+                    const size_t start_pin_index = l["start"]["pin"].get<int>();
+                    const size_t end_pin_index = l["end"]["pin"].get<int>();
+                    if (start_pin_index >= start_node->outs.size() || end_pin_index >= end_node->ins.size())
+                    {
+                        continue;
+                    }
+
+                    CreateLink(start_node->outs[start_pin_index].get(), end_node->ins[end_pin_index].get());
+                }
+            }
+
+            Node* GetNode(const Change& change) const
+            {
+                if (change.node >= save_nodes.size() || save_nodes[change.node] == nullptr)
+                {
+                    throw std::runtime_error("Node " + std::to_string(change.node) + " not found in the save");
+                }
+                return save_nodes[change.node];
+            }
+
+            void SetRate(const Change& change)
+            {
+                Node* node = GetNode(change);
+                if (!node->IsCraft() && !node->IsGroup())
+                {
+                    throw std::runtime_error("Node " + std::to_string(change.node) + " has no rate");
+                }
+                static_cast<PoweredNode*>(node)->UpdateRate(change.rate);
+                for (auto& p : node->ins)
+                {
+                    updating_pins.push({ p.get(), Constraint::Strong });
+                }
+                for (auto& p : node->outs)
+                {
+                    updating_pins.push({ p.get(), Constraint::Strong });
+                }
+            }
+
+            void SetSomersloop(const Change& change)
+            {
+                Node* node = GetNode(change);
+                if (!node->IsCraft())
+                {
+                    throw std::runtime_error("Node " + std::to_string(change.node) + " is not a craft node");
+                }
+                CraftNode* craft_node = static_cast<CraftNode*>(node);
+                const FractionalNumber num_somersloop(change.num_somersloop, 1);
+                // Check we don't try to boost more than 2x
+                if (change.num_somersloop < 0 || num_somersloop * craft_node->recipe->building->somersloop_mult > 1)
+                {
+                    throw std::runtime_error("Invalid number of somersloops for node " + std::to_string(change.node));
+                }
+                craft_node->num_somersloop = num_somersloop;
+                craft_node->UpdateRate(craft_node->current_rate);
+                for (auto& p : craft_node->outs)
+                {
+                    updating_pins.push({ p.get(), Constraint::Strong });
+                }
+            }
+
+            void SetRecipe(const Change& change)
+            {
+                Node* node = GetNode(change);
+                if (!node->IsCraft())
+                {
+                    throw std::runtime_error("Node " + std::to_string(change.node) + " is not a craft node");
+                }
+                CraftNode* craft_node = static_cast<CraftNode*>(node);
+
+                // Keep the rate of the first output shared by both recipes, or the number of machines if there is none
+                const Pin* kept_output = nullptr;
+                for (const auto& o : change.recipe->outs)
+                {
+                    for (const auto& p : craft_node->outs)
+                    {
+                        if (kept_output == nullptr && p->item == o.item)
+                        {
+                            kept_output = p.get();
+                        }
+                    }
+                }
+                const FractionalNumber kept_rate = kept_output != nullptr ? kept_output->current_rate : FractionalNumber();
+                const Item* kept_item = kept_output != nullptr ? kept_output->item : nullptr;
+
+                // Detach links from the old pins, they are recreated on the new pins with the same item
+                struct DetachedLink
+                {
+                    const Item* item;
+                    ax::NodeEditor::PinKind direction;
+                    Pin* other;
+                };
+                std::vector<DetachedLink> detached;
+                for (const auto* pins : { &craft_node->ins, &craft_node->outs })
+                {
+                    for (const auto& p : *pins)
+                    {
+                        if (p->link != nullptr)
+                        {
+                            detached.push_back({ p->item, p->direction, p->direction == ax::NodeEditor::PinKind::Input ? p->link->start : p->link->end });
+                            DeleteLink(p->link);
+                        }
+                    }
+                }
+
+                const bool same_building = craft_node->recipe->building == change.recipe->building;
+                const auto id_generator = [this]() { return GetNextId(); };
+                craft_node->ChangeRecipe(nullptr, id_generator);
+                craft_node->ChangeRecipe(change.recipe, id_generator);
+                if (!same_building)
+                {
+                    craft_node->num_somersloop = 0;
+                }
+
+                FractionalNumber new_rate = craft_node->current_rate;
+                for (const auto& o : change.recipe->outs)
+                {
+                    if (o.item == kept_item)
+                    {
+                        new_rate = kept_rate / (o.quantity * (1 + craft_node->num_somersloop * change.recipe->building->somersloop_mult));
+                        break;
+                    }
+                }
+                craft_node->UpdateRate(new_rate);
+
+                for (const DetachedLink& d : detached)
+                {
+                    auto& pins = d.direction == ax::NodeEditor::PinKind::Input ? craft_node->ins : craft_node->outs;
+                    auto it = std::find_if(pins.begin(), pins.end(), [&](const std::unique_ptr<Pin>& p) { return p->item == d.item && p->link == nullptr; });
+                    if (it == pins.end())
+                    {
+                        continue;
+                    }
+                    if (d.direction == ax::NodeEditor::PinKind::Input)
+                    {
+                        CreateLink(d.other, it->get());
+                    }
+                    else
+                    {
+                        CreateLink(it->get(), d.other);
+                    }
+                }
+
+                for (auto& p : craft_node->ins)
+                {
+                    updating_pins.push({ p.get(), Constraint::Strong });
+                }
+                for (auto& p : craft_node->outs)
+                {
+                    updating_pins.push({ p.get(), Constraint::Strong });
+                }
+            }
+
+            Totals ComputeTotals() const
+            {
+                std::map<const Item*, FractionalNumber, ItemPtrCompare> consumed;
+                std::map<const Item*, FractionalNumber, ItemPtrCompare> produced;
+                Totals totals;
+                for (const auto& n : nodes)
+                {
+                    if (n->IsCraft())
+                    {
+                        const CraftNode* node = static_cast<const CraftNode*>(n.get());
+                        for (const auto& p : node->ins)
+                        {
+                            consumed[p->item] += p->current_rate;
+                        }
+                        for (const auto& p : node->outs)
+                        {
+                            produced[p->item] += p->current_rate;
+                        }
+                        totals.machines[node->recipe->building] += node->current_rate;
+                        totals.power += node->same_clock_power;
+                    }
+                    else if (n->IsGroup())
+                    {
+                        const GroupNode* node = static_cast<const GroupNode*>(n.get());
+                        for (const auto& [k, v] : node->inputs)
+                        {
+                            consumed[k] += v;
+                        }
+                        for (const auto& [k, v] : node->outputs)
+                        {
+                            produced[k] += v;
+                        }
+                        for (const auto& [k, v] : node->total_machines)
+                        {
+                            totals.machines[k] += v;
+                        }
+                        totals.power += node->same_clock_power;
+                    }
+                }
+
+                for (const auto& [item, rate] : consumed)
+                {
+                    auto it = produced.find(item);
+                    if (it == produced.end())
+                    {
+                        totals.inputs[item] = rate;
+                    }
+                    else if (rate > it->second)
+                    {
+                        totals.inputs[item] = rate - it->second;
+                    }
+                }
+                for (const auto& [item, rate] : produced)
+                {
+                    auto it = consumed.find(item);
+                    if (it == consumed.end())
+                    {
+                        totals.outputs[item] = rate;
+                    }
+                    else if (rate > it->second)
+                    {
+                        totals.outputs[item] = rate - it->second;
+                    }
+                }
+                for (auto it = totals.machines.begin(); it != totals.machines.end();)
+                {
+                    it = it->second.GetNumerator() == 0 ? totals.machines.erase(it) : std::next(it);
+                }
+
+                return totals;
+            }
+        };
+
+        Result Evaluate(const Json::Value& save, const Scenario& scenario)
+        {
+            Result result;
+            result.name = scenario.name;
+            try
+            {
+                Graph graph;
+                graph.Load(save);
+                for (size_t i = 0; i < scenario.changes.size(); ++i)
+                {
+                    const Change& change = scenario.changes[i];
+                    switch (change.kind)
+                    {
+                    case Change::Kind::Rate:
+                        graph.SetRate(change);
+                        break;
+                    case Change::Kind::Recipe:
+                        graph.SetRecipe(change);
+                        break;
+                    case Change::Kind::Somersloop:
+                        graph.SetSomersloop(change);
+                        break;
+                    }
+                    if (!PropagateRates(graph.updating_pins, graph.nodes))
+                    {
+                        throw std::runtime_error("Rates did not settle after change " + std::to_string(i + 1));
+                    }
+                }
+                result.totals = graph.ComputeTotals();
+            }
+            catch (const std::exception& e)
+            {
+                result.error = e.what();
+            }
+            return result;
+        }
+
+        FractionalNumber ParseRate(const Json::Value& rate)
+        {
+            try
+            {
+                if (rate.is_string())
+                {
+                    return FractionalNumber(rate.get_string());
+                }
+                if (rate.is_number())
+                {
+                    return FractionalNumber::FromDecimal(rate.get_number_literal());
+                }
+            }
+            catch (const std::domain_error&)
+            {
+            }
+            throw std::runtime_error("Invalid rate in scenario change");
+        }
+
+        /// @brief Quote a CSV field if needed
+        std::string CsvField(const std::string& s)
+        {
+            if (s.find_first_of(",\"\n") == std::string::npos)
+            {
+                return s;
+            }
+            std::string quoted = "\"";
+            for (const char c : s)
+            {
+                quoted += c;
+                if (c == '"')
+                {
+                    quoted += c;
+                }
+            }
+            return quoted + "\"";
+        }
+    }
+
+    std::vector<Scenario> ParseScenarios(const Json::Value& json)
+    {
+        if (!json.is_array())
+        {
+            throw std::runtime_error("Scenarios should be a json array");
+        }
+
+        std::vector<Scenario> scenarios;
+        scenarios.reserve(json.size());
+        for (const auto& s : json.get_array())
+        {
+            Scenario scenario;
+            scenario.name = s.contains("name") ? s["name"].get_string() : ("scenario " + std::to_string(scenarios.size()));
+            if (s.contains("changes"))
+            {
+                for (const auto& c : s["changes"].get_array())
+                {
+                    if (!c.contains("node") || !c["node"].is_integer() || c["node"].get<long long int>() < 0)
+                    {
+                        throw std::runtime_error("Missing node index in a change of scenario " + scenario.name);
+                    }
+                    Change change;
+                    change.node = c["node"].get<long long int>();
+                    if (c.contains("rate"))
+                    {
+                        change.kind = Change::Kind::Rate;
+                        change.rate = ParseRate(c["rate"]);
+                    }
+                    else if (c.contains("recipe"))
+                    {
+                        change.kind = Change::Kind::Recipe;
+                        const std::string& recipe_name = c["recipe"].get_string();
+                        const auto it = std::find_if(Data::Recipes().begin(), Data::Recipes().end(), [&recipe_name](const std::shared_ptr<Recipe>& recipe) { return recipe->name == recipe_name; });
+                        if (it == Data::Recipes().end())
+                        {
+                            throw std::runtime_error("Unknown recipe " + recipe_name + " in scenario " + scenario.name);
+                        }
+                        change.recipe = it->get();
+                    }
+                    else if (c.contains("somersloop"))
+                    {
+                        change.kind = Change::Kind::Somersloop;
+                        change.num_somersloop = c["somersloop"].get<int>();
+                    }
+                    else
+                    {
+                        throw std::runtime_error("Unknown change in scenario " + scenario.name);
+                    }
+                    scenario.changes.push_back(change);
+                }
+            }
+            scenarios.push_back(std::move(scenario));
+        }
+        return scenarios;
+    }
+
+    std::vector<Result> Run(const Json::Value& save, const std::vector<Scenario>& scenarios)
+    {
+        std::vector<Result> results(scenarios.size());
+        // Each scenario works on its own graph, the save and the game data are only read
+        ParallelFor(scenarios.size(), [&](const size_t begin, const size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                results[i] = Evaluate(save, scenarios[i]);
+            }
+        });
+        return results;
+    }
+
+    std::string ToCSV(const std::vector<Result>& results)
+    {
+        std::set<const Building*, BuildingPtrCompare> buildings;
+        std::set<const Item*, ItemPtrCompare> inputs;
+        std::set<const Item*, ItemPtrCompare> outputs;
+        for (const Result& r : results)
+        {
+            for (const auto& [k, v] : r.totals.machines)
+            {
+                buildings.insert(k);
+            }
+            for (const auto& [k, v] : r.totals.inputs)
+            {
+                inputs.insert(k);
+            }
+            for (const auto& [k, v] : r.totals.outputs)
+            {
+                outputs.insert(k);
+            }
+        }
+
+        std::stringstream csv;
+        csv << "scenario,error,power";
+        for (const Building* b : buildings)
+        {
+            csv << "," << CsvField(b->name);
+        }
+        for (const Item* i : inputs)
+        {
+            csv << "," << CsvField("in:" + i->name);
+        }
+        for (const Item* i : outputs)
+        {
+            csv << "," << CsvField("out:" + i->name);
+        }
+        csv << "\n";
+
+        auto write_column = [&csv](const auto& values, const auto* key) {
+            auto it = values.find(key);
+            csv << "," << (it == values.end() ? 0.0 : it->second.GetValue());
+        };
+        for (const Result& r : results)
+        {
+            csv << CsvField(r.name) << "," << CsvField(r.error) << "," << r.totals.power.GetValue();
+            for (const Building* b : buildings)
+            {
+                write_column(r.totals.machines, b);
+            }
+            for (const Item* i : inputs)
+            {
+                write_column(r.totals.inputs, i);
+            }
+            for (const Item* i : outputs)
+            {
+                write_column(r.totals.outputs, i);
+            }
+            csv << "\n";
+        }
+        return csv.str();
+    }
+
+    Json::Value ToJson(const std::vector<Result>& results)
+    {
+        Json::Array output;
+        output.reserve(results.size());
+        for (const Result& r : results)
+        {
+            Json::Value scenario;
+            scenario["name"] = r.name;
+            if (!r.error.empty())
+            {
+                scenario["error"] = r.error;
+            }
+            scenario["power"] = r.totals.power.GetValue();
+            Json::Value machines = Json::Object();
+            for (const auto& [k, v] : r.totals.machines)
+            {
+                machines[k->name] = v.GetValue();
+            }
+            scenario["machines"] = std::move(machines);
+            Json::Value inputs = Json::Object();
+            for (const auto& [k, v] : r.totals.inputs)
+            {
+                inputs[k->name] = v.GetValue();
+            }
+            scenario["inputs"] = std::move(inputs);
+            Json::Value outputs = Json::Object();
+            for (const auto& [k, v] : r.totals.outputs)
+            {
+                outputs[k->name] = v.GetValue();
+            }
+            scenario["outputs"] = std::move(outputs);
+            output.push_back(std::move(scenario));
+        }
+        return output;
+    }
+}
@@ -0,0 +1,220 @@
+#include "search_index.hpp"
+#include "building.hpp"
+#include "recipe.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace
+{
+    std::string ToLower(const std::string& s)
+    {
+        std::string output = s;
+        std::transform(output.begin(), output.end(), output.begin(), [](unsigned char c) { return std::tolower(c); });
+        return output;
+    }
+
+    uint32_t TrigramKey(const char* c)
+    {
+        return
+            (static_cast<uint32_t>(static_cast<unsigned char>(c[0])) << 16) |
+            (static_cast<uint32_t>(static_cast<unsigned char>(c[1])) << 8) |
+            static_cast<uint32_t>(static_cast<unsigned char>(c[2]));
+    }
+
+    /// @brief Fill trigrams with all distinct trigram keys of s, sorted
+    void ExtractTrigrams(const std::string& s, std::vector<uint32_t>& trigrams)
+    {
+        trigrams.clear();
+        for (size_t i = 0; i + 3 <= s.size(); ++i)
+        {
+            trigrams.push_back(TrigramKey(s.data() + i));
+        }
+        std::sort(trigrams.begin(), trigrams.end());
+        trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    }
+}
+
+void SearchIndex::Build(const std::vector<std::shared_ptr<Recipe>>& recipes)
+{
+    terms.clear();
+    term_is_name.clear();
+    term_num_trigrams.clear();
+
+    // Collect all distinct terms and the recipes they appear in
+    std::unordered_map<std::string, uint32_t> name_terms;
+    std::unordered_map<std::string, uint32_t> field_terms;
+    std::vector<std::pair<uint32_t, int>> postings;
+    auto add_term = [&](const std::string& s, const bool is_name, const int recipe_index) {
+        std::unordered_map<std::string, uint32_t>& known_terms = is_name ? name_terms : field_terms;
+        std::string lower = ToLower(s);
+        auto it = known_terms.find(lower);
+        if (it == known_terms.end())
+        {
+            it = known_terms.emplace(lower, static_cast<uint32_t>(terms.size())).first;
+            terms.emplace_back(std::move(lower));
+            term_is_name.push_back(is_name);
+        }
+        postings.emplace_back(it->second, recipe_index);
+    };
+
+    for (int i = 0; i < recipes.size(); ++i)
+    {
+        add_term(recipes[i]->name, true, i);
+        for (const auto& in : recipes[i]->ins)
+        {
+            add_term(in.item->name, false, i);
+        }
+        for (const auto& out : recipes[i]->outs)
+        {
+            add_term(out.item->name, false, i);
+        }
+        add_term(recipes[i]->building->name, false, i);
+    }
+
+    // Flatten term --> recipes
+    std::sort(postings.begin(), postings.end());
+    postings.erase(std::unique(postings.begin(), postings.end()), postings.end());
+    term_offsets.assign(terms.size() + 1, 0);
+    term_recipes.clear();
+    term_recipes.reserve(postings.size());
+    for (const auto& [term, recipe] : postings)
+    {
+        term_offsets[term + 1] += 1;
+        term_recipes.push_back(recipe);
+    }
+    for (size_t i = 1; i < term_offsets.size(); ++i)
+    {
+        term_offsets[i] += term_offsets[i - 1];
+    }
+
+    // Flatten trigram --> terms
+    std::vector<std::pair<uint32_t, uint32_t>> trigram_postings;
+    std::vector<uint32_t> trigrams;
+    term_num_trigrams.reserve(terms.size());
+    for (uint32_t t = 0; t < terms.size(); ++t)
+    {
+        ExtractTrigrams(terms[t], trigrams);
+        term_num_trigrams.push_back(static_cast<uint32_t>(trigrams.size()));
+        for (const uint32_t k : trigrams)
+        {
+            trigram_postings.emplace_back(k, t);
+        }
+    }
+    std::sort(trigram_postings.begin(), trigram_postings.end());
+    trigram_keys.clear();
+    trigram_offsets.clear();
+    trigram_terms.clear();
+    trigram_terms.reserve(trigram_postings.size());
+    for (const auto& [key, term] : trigram_postings)
+    {
+        if (trigram_keys.empty() || trigram_keys.back() != key)
+        {
+            trigram_keys.push_back(key);
+            trigram_offsets.push_back(static_cast<uint32_t>(trigram_terms.size()));
+        }
+        trigram_terms.push_back(term);
+    }
+    trigram_offsets.push_back(static_cast<uint32_t>(trigram_terms.size()));
+
+    // Size scratch buffers so queries don't have to
+    term_hits.assign(terms.size(), 0);
+    touched_terms.reserve(terms.size());
+    recipe_scores.assign(recipes.size(), std::string::npos);
+    touched_recipes.reserve(recipes.size());
+    lower_query.reserve(64);
+    query_trigrams.reserve(64);
+}
+
+void SearchIndex::Search(const std::string& query, std::vector<std::pair<int, size_t>>& results) const
+{
+    results.clear();
+
+    lower_query.assign(query);
+    std::transform(lower_query.begin(), lower_query.end(), lower_query.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (lower_query.empty())
+    {
+        return;
+    }
+
+    // Too short to have any trigram, fall back to a scan over all distinct terms
+    if (lower_query.size() < 3)
+    {
+        for (uint32_t t = 0; t < terms.size(); ++t)
+        {
+            if (const size_t pos = terms[t].find(lower_query); pos != std::string::npos)
+            {
+                ScoreTerm(t, (term_is_name[t] ? 0 : 1) * tier_stride + std::min(pos, tier_stride - 1));
+            }
+        }
+    }
+    else
+    {
+        ExtractTrigrams(lower_query, query_trigrams);
+        const uint32_t num_query_trigrams = static_cast<uint32_t>(query_trigrams.size());
+
+        // Count how many query trigrams each term contains
+        for (const uint32_t k : query_trigrams)
+        {
+            const auto it = std::lower_bound(trigram_keys.begin(), trigram_keys.end(), k);
+            if (it == trigram_keys.end() || *it != k)
+            {
+                continue;
+            }
+            const size_t key_index = std::distance(trigram_keys.begin(), it);
+            for (uint32_t i = trigram_offsets[key_index]; i < trigram_offsets[key_index + 1]; ++i)
+            {
+                const uint32_t t = trigram_terms[i];
+                if (term_hits[t] == 0)
+                {
+                    touched_terms.push_back(t);
+                }
+                term_hits[t] += 1;
+            }
+        }
+
+        for (const uint32_t t : touched_terms)
+        {
+            const uint32_t hits = term_hits[t];
+            term_hits[t] = 0;
+            // Term contains all query trigrams, check for an exact substring match
+            if (hits == num_query_trigrams)
+            {
+                if (const size_t pos = terms[t].find(lower_query); pos != std::string::npos)
+                {
+                    ScoreTerm(t, (term_is_name[t] ? 0 : 1) * tier_stride + std::min(pos, tier_stride - 1));
+                    continue;
+                }
+            }
+            // Fuzzy match if at least half the query trigrams are found in the term,
+            // scored by missing trigrams first, then by how many term trigrams are not in the query
+            if (2 * hits >= num_query_trigrams)
+            {
+                const size_t missing = num_query_trigrams - hits;
+                const size_t extra = std::min<size_t>(term_num_trigrams[t] - hits, 255);
+                ScoreTerm(t, (term_is_name[t] ? 2 : 3) * tier_stride + std::min(missing * 256 + extra, tier_stride - 1));
+            }
+        }
+        touched_terms.clear();
+    }
+
+    for (const int r : touched_recipes)
+    {
+        results.emplace_back(r, recipe_scores[r]);
+        recipe_scores[r] = std::string::npos;
+    }
+    touched_recipes.clear();
+}
+
+void SearchIndex::ScoreTerm(const uint32_t term, const size_t score) const
+{
+    for (uint32_t i = term_offsets[term]; i < term_offsets[term + 1]; ++i)
+    {
+        const int r = term_recipes[i];
+        if (recipe_scores[r] == std::string::npos)
+        {
+            touched_recipes.push_back(r);
+        }
+        recipe_scores[r] = std::min(recipe_scores[r], score);
+    }
+}
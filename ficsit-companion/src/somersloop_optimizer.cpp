@@ -0,0 +1,667 @@
+#include "somersloop_optimizer.hpp"
+#include "building.hpp"
+#include "recipe.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+
+namespace SomersloopOptimizer
+{
+    namespace
+    {
+        constexpr double epsilon = 1e-9;
+        /// @brief Changes of a node output scale below this are not propagated, required to stop on production loops
+        constexpr double propagation_tolerance = 1e-9;
+        /// @brief Max number of times a node is updated during one propagation, in case a loop converges slowly
+        constexpr size_t max_node_updates = 64;
+        /// @brief Local search after the greedy pass is skipped if a pass would need more evaluations than this
+        constexpr size_t max_move_evaluations = 4000;
+        constexpr size_t max_local_search_passes = 20;
+
+        /// @brief Number of buildings needed for a rate in machines at 100%
+        int NumMachines(const double machines)
+        {
+            return static_cast<int>(std::ceil(machines - epsilon));
+        }
+
+        struct IndexedQuantity
+        {
+            size_t index;
+            double quantity;
+        };
+
+        struct ModelNode
+        {
+            /// @brief Items/min consumed by one machine at 100%
+            std::vector<IndexedQuantity> ins;
+            /// @brief Items/min produced by one machine at 100% without somersloop
+            std::vector<IndexedQuantity> outs;
+            /// @brief Output at the start, as a number of machines at 100% without somersloop
+            double runs = 0.0;
+            double somersloop_mult = 0.0;
+            int max_somersloop = 0;
+            const Building* building = nullptr;
+            double power = 0.0;
+        };
+
+        struct ModelItem
+        {
+            std::vector<size_t> producers;
+            /// @brief Items/min leaving the factory at the start
+            double exported = 0.0;
+            /// @brief Items/min entering the factory at the start
+            double imported = 0.0;
+            /// @brief Items/min demand at the start (consumed + exported)
+            double total = 0.0;
+            double weight = 0.0;
+        };
+
+        /// @brief Nodes and items of the factory, shared by all evaluations
+        struct Model
+        {
+            std::vector<ModelNode> nodes;
+            std::vector<ModelItem> items;
+            /// @brief Propagation order of each node, higher first. Consumers are ranked above their producers (except in loops)
+            std::vector<size_t> rank;
+        };
+
+        constexpr size_t no_node = std::numeric_limits<size_t>::max();
+
+        /// @brief Somersloops change of an assignment
+        struct Move
+        {
+            /// @brief Node with one less somersloop per machine, or no_node
+            size_t removed = no_node;
+            /// @brief Node with more somersloops per machine
+            size_t added = no_node;
+            int levels = 1;
+        };
+
+        /// @brief Nodes waiting for an update, as (rank, node)
+        using NodeQueue = std::priority_queue<std::pair<size_t, size_t>>;
+
+        /// @brief Rank nodes with a depth first post order on the consumer --> producer edges
+        void ComputeRanks(Model& model)
+        {
+            const size_t num_nodes = model.nodes.size();
+            model.rank.assign(num_nodes, 0);
+            std::vector<bool> visited(num_nodes, false);
+            size_t next_rank = 0;
+            // (node, next input to explore) and index in the current input producers
+            std::vector<std::pair<size_t, size_t>> stack;
+            for (size_t root = 0; root < num_nodes; ++root)
+            {
+                if (visited[root])
+                {
+                    continue;
+                }
+                visited[root] = true;
+                stack.emplace_back(root, 0);
+                while (!stack.empty())
+                {
+                    auto& [node, next] = stack.back();
+                    // Flatten (input, producer) pairs of the node in a single counter
+                    size_t remaining = next++;
+                    size_t child = num_nodes;
+                    for (const IndexedQuantity& in : model.nodes[node].ins)
+                    {
+                        const std::vector<size_t>& producers = model.items[in.index].producers;
+                        if (remaining < producers.size())
+                        {
+                            child = producers[remaining];
+                            break;
+                        }
+                        remaining -= producers.size();
+                    }
+                    if (child == num_nodes)
+                    {
+                        model.rank[node] = next_rank++;
+                        stack.pop_back();
+                    }
+                    else if (child != num_nodes && !visited[child])
+                    {
+                        visited[child] = true;
+                        stack.emplace_back(child, 0);
+                    }
+                }
+            }
+        }
+
+        /// @brief Flows required to get some factory outputs
+        struct Flows
+        {
+            /// @brief Output of each node relative to the start
+            std::vector<double> scale;
+            /// @brief Number of machines at 100% of each node
+            std::vector<double> machines;
+            /// @brief Items/min demand of each item
+            std::vector<double> demand;
+        };
+
+        /// @brief Current somersloops assignment and the resulting flows. Cheap to copy so each thread can evaluate candidates on its own copy
+        class State
+        {
+        public:
+            State(const Model& model, const int target, const std::vector<int>& num_somersloop) : model(&model), num_somersloop(num_somersloop)
+            {
+                const size_t num_nodes = model.nodes.size();
+                full.scale.assign(num_nodes, 1.0);
+                full.machines.resize(num_nodes);
+                for (size_t i = 0; i < num_nodes; ++i)
+                {
+                    full.machines[i] = model.nodes[i].runs / Multiplier(i);
+                    used += num_somersloop[i] * NumMachines(full.machines[i]);
+                }
+                full.demand.resize(model.items.size());
+                for (size_t i = 0; i < model.items.size(); ++i)
+                {
+                    full.demand[i] = model.items[i].total;
+                }
+                update_counts.assign(num_nodes, 0);
+                queued.assign(num_nodes, false);
+
+                has_target = target >= 0;
+                if (has_target)
+                {
+                    // Only the target item leaves the factory, propagate its demand from its producers
+                    target_flows.scale.assign(num_nodes, 0.0);
+                    target_flows.machines.assign(num_nodes, 0.0);
+                    target_flows.demand.assign(model.items.size(), 0.0);
+                    target_flows.demand[target] = model.items[target].exported;
+                    NodeQueue queue;
+                    UpdateProducers(target_flows, target, queue);
+                    Propagate(target_flows, false, queue);
+                }
+            }
+
+            /// @brief Change the number of somersloops of a node and propagate the new flows
+            void Set(const size_t node, const int n)
+            {
+                Log(num_somersloop[node]);
+                used += n * NumMachines(full.machines[node]) - num_somersloop[node] * NumMachines(full.machines[node]);
+                num_somersloop[node] = n;
+                NodeQueue queue;
+                Push(queue, node);
+                Propagate(full, true, queue);
+                if (has_target)
+                {
+                    Push(queue, node);
+                    Propagate(target_flows, false, queue);
+                }
+            }
+
+            /// @brief Get the score and somersloops changes of a move, without changing the state
+            std::pair<double, int> Evaluate(const Move& move)
+            {
+                const double score_before = score_delta;
+                const int used_before = used;
+                recording = true;
+                Apply(move);
+                const std::pair<double, int> delta = { score_delta - score_before, used - used_before };
+                recording = false;
+                Undo();
+                score_delta = score_before;
+                used = used_before;
+                return delta;
+            }
+
+            void Apply(const Move& move)
+            {
+                if (move.removed != no_node)
+                {
+                    Set(move.removed, num_somersloop[move.removed] - 1);
+                }
+                Set(move.added, num_somersloop[move.added] + move.levels);
+            }
+
+            /// @brief Weighted imports of the scored flows
+            double Score() const
+            {
+                const Flows& flows = has_target ? target_flows : full;
+                double score = 0.0;
+                for (size_t i = 0; i < model->items.size(); ++i)
+                {
+                    const ModelItem& item = model->items[i];
+                    if (item.imported > 0.0)
+                    {
+                        score += item.weight * item.imported * flows.demand[i] / item.total;
+                    }
+                }
+                return score;
+            }
+
+            double Multiplier(const size_t node) const
+            {
+                return 1.0 + num_somersloop[node] * model->nodes[node].somersloop_mult;
+            }
+
+            const Model* model;
+            std::vector<int> num_somersloop;
+            Flows full;
+            /// @brief Number of somersloops in use
+            int used = 0;
+            /// @brief Accumulated score change since the start
+            double score_delta = 0.0;
+
+        private:
+            /// @brief Recompute the scale of the producers of an item after its demand changed
+            void UpdateProducers(Flows& flows, const size_t item, NodeQueue& queue)
+            {
+                for (const size_t p : model->items[item].producers)
+                {
+                    // Enough output to satisfy the demand of all the produced items
+                    double scale = 0.0;
+                    for (const IndexedQuantity& out : model->nodes[p].outs)
+                    {
+                        scale = std::max(scale, flows.demand[out.index] / model->items[out.index].total);
+                    }
+                    if (std::abs(scale - flows.scale[p]) > propagation_tolerance)
+                    {
+                        Log(flows.scale[p]);
+                        flows.scale[p] = scale;
+                        Push(queue, p);
+                    }
+                }
+            }
+
+            /// @brief Update the machines of all nodes in queue and everything upstream
+            void Propagate(Flows& flows, const bool is_full, NodeQueue& queue)
+            {
+                const bool scored = is_full != has_target;
+                std::vector<size_t> touched;
+                while (!queue.empty())
+                {
+                    const size_t node = queue.top().second;
+                    queue.pop();
+                    queued[node] = false;
+                    if (update_counts[node] == 0)
+                    {
+                        touched.push_back(node);
+                    }
+                    if (++update_counts[node] > max_node_updates)
+                    {
+                        continue;
+                    }
+
+                    const double machines = model->nodes[node].runs * flows.scale[node] / Multiplier(node);
+                    const double delta = machines - flows.machines[node];
+                    if (delta == 0.0)
+                    {
+                        continue;
+                    }
+                    if (is_full)
+                    {
+                        used += num_somersloop[node] * (NumMachines(machines) - NumMachines(flows.machines[node]));
+                    }
+                    Log(flows.machines[node]);
+                    flows.machines[node] = machines;
+
+                    for (const IndexedQuantity& in : model->nodes[node].ins)
+                    {
+                        const ModelItem& item = model->items[in.index];
+                        Log(flows.demand[in.index]);
+                        flows.demand[in.index] += delta * in.quantity;
+                        if (scored && item.imported > 0.0)
+                        {
+                            score_delta += item.weight * item.imported * delta * in.quantity / item.total;
+                        }
+                        UpdateProducers(flows, in.index, queue);
+                    }
+                }
+                for (const size_t node : touched)
+                {
+                    update_counts[node] = 0;
+                }
+            }
+
+            void Push(NodeQueue& queue, const size_t node)
+            {
+                if (!queued[node])
+                {
+                    queued[node] = true;
+                    queue.emplace(model->rank[node], node);
+                }
+            }
+
+            void Log(double& value)
+            {
+                if (recording)
+                {
+                    double_log.emplace_back(&value, value);
+                }
+            }
+
+            void Log(int& value)
+            {
+                if (recording)
+                {
+                    int_log.emplace_back(&value, value);
+                }
+            }
+
+            void Undo()
+            {
+                for (auto it = double_log.rbegin(); it != double_log.rend(); ++it)
+                {
+                    *it->first = it->second;
+                }
+                for (auto it = int_log.rbegin(); it != int_log.rend(); ++it)
+                {
+                    *it->first = it->second;
+                }
+                double_log.clear();
+                int_log.clear();
+            }
+
+            bool has_target = false;
+            Flows target_flows;
+            std::vector<size_t> update_counts;
+            std::vector<bool> queued;
+            bool recording = false;
+            std::vector<std::pair<double*, double>> double_log;
+            std::vector<std::pair<int*, int>> int_log;
+        };
+
+        double NodePower(const ModelNode& node, const double machines, const int num_somersloop)
+        {
+            const int num_machines = NumMachines(machines);
+            if (num_machines == 0)
+            {
+                return 0.0;
+            }
+            return num_machines * node.power *
+                std::pow(1.0 + num_somersloop * node.somersloop_mult, node.building->somersloop_power_exponent) *
+                std::pow(machines / num_machines, node.building->power_exponent);
+        }
+    }
+
+    Result Optimize(const std::vector<Task>& tasks, const int budget, const Objective objective, const Item* target, const std::function<double(const Item*)>& import_weight)
+    {
+        Model model;
+        std::unordered_map<const Item*, size_t> item_indices;
+        std::vector<const Item*> items;
+        auto item_index = [&](const Item* item) {
+            const auto [it, inserted] = item_indices.emplace(item, items.size());
+            if (inserted)
+            {
+                items.push_back(item);
+                model.items.emplace_back();
+            }
+            return it->second;
+        };
+
+        std::vector<int> num_somersloop(tasks.size(), 0);
+        std::vector<double> produced;
+        std::vector<double> consumed;
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            const Task& task = tasks[i];
+            ModelNode node;
+            node.building = task.recipe->building;
+            node.power = task.recipe->power;
+            node.somersloop_mult = task.recipe->building->somersloop_mult.GetValue();
+            node.max_somersloop = node.somersloop_mult > 0.0 ? static_cast<int>(std::round(1.0 / node.somersloop_mult)) : 0;
+            num_somersloop[i] = std::min(task.num_somersloop, node.max_somersloop);
+            node.runs = task.rate * (1.0 + num_somersloop[i] * node.somersloop_mult);
+            for (const CountedItem& in : task.recipe->ins)
+            {
+                const size_t index = item_index(in.item);
+                node.ins.push_back(IndexedQuantity{ index, in.quantity.GetValue() });
+                consumed.resize(items.size(), 0.0);
+                consumed[index] += task.rate * in.quantity.GetValue();
+            }
+            for (const CountedItem& out : task.recipe->outs)
+            {
+                const size_t index = item_index(out.item);
+                node.outs.push_back(IndexedQuantity{ index, out.quantity.GetValue() });
+                model.items[index].producers.push_back(i);
+                produced.resize(items.size(), 0.0);
+                produced[index] += node.runs * out.quantity.GetValue();
+            }
+            model.nodes.push_back(std::move(node));
+        }
+        produced.resize(items.size(), 0.0);
+        consumed.resize(items.size(), 0.0);
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            ModelItem& item = model.items[i];
+            item.exported = std::max(0.0, produced[i] - consumed[i]);
+            item.imported = std::max(0.0, consumed[i] - produced[i]);
+            item.total = std::max(produced[i], consumed[i]);
+            item.weight = import_weight(items[i]);
+        }
+
+        ComputeRanks(model);
+
+        int target_index = -1;
+        if (objective == Objective::Item)
+        {
+            const auto it = item_indices.find(target);
+            if (it != item_indices.end() && model.items[it->second].exported > 0.0)
+            {
+                target_index = static_cast<int>(it->second);
+            }
+        }
+
+        Result result;
+        State state(model, target_index, num_somersloop);
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            result.power_before += NodePower(model.nodes[i], state.full.machines[i], num_somersloop[i]);
+        }
+        result.score_before = state.Score();
+
+        // Start from scratch, all somersloops are reassigned
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            if (num_somersloop[i] > 0)
+            {
+                state.Set(i, 0);
+            }
+        }
+
+        // Lazy greedy: gains mostly decrease when other nodes are boosted, so the
+        // stale gain of a candidate is used as a bound and only the best ones are re-evaluated
+        // Copies of state for the parallel evaluations, kept for the whole search. They are brought up to
+        // date by replaying the moves applied since their last use instead of copying state at each step
+        struct Replica
+        {
+            State state;
+            size_t num_applied;
+        };
+        std::vector<Move> applied;
+        std::vector<Replica> replicas;
+        std::mutex replicas_mutex;
+        auto apply = [&](const Move& move) {
+            state.Apply(move);
+            applied.push_back(move);
+        };
+        auto evaluate = [&](const std::vector<Move>& evaluated, std::vector<std::pair<double, int>>& output) {
+            output.resize(evaluated.size());
+            ParallelFor(evaluated.size(), [&](const size_t begin, const size_t end) {
+                std::unique_lock<std::mutex> lock(replicas_mutex);
+                if (replicas.empty())
+                {
+                    lock.unlock();
+                    // state is only read during the evaluations
+                    Replica created{ state, applied.size() };
+                    lock.lock();
+                    replicas.push_back(std::move(created));
+                }
+                Replica replica = std::move(replicas.back());
+                replicas.pop_back();
+                lock.unlock();
+
+                for (; replica.num_applied < applied.size(); ++replica.num_applied)
+                {
+                    replica.state.Apply(applied[replica.num_applied]);
+                }
+                for (size_t i = begin; i < end; ++i)
+                {
+                    output[i] = replica.state.Evaluate(evaluated[i]);
+                }
+
+                lock.lock();
+                replicas.push_back(std::move(replica));
+            });
+        };
+
+        std::priority_queue<std::pair<double, size_t>> candidates;
+        std::vector<size_t> batch;
+        std::vector<Move> batch_moves;
+        std::vector<std::pair<double, int>> deltas;
+        auto evaluate_batch = [&]() {
+            batch_moves.clear();
+            for (const size_t node : batch)
+            {
+                batch_moves.push_back(Move{ no_node, node, 1 });
+            }
+            evaluate(batch_moves, deltas);
+        };
+        // Score decrease per somersloop, free improvements first. Negative if not worth it
+        auto ratio = [&](const std::pair<double, int>& delta) {
+            if (delta.first >= -epsilon || state.used + delta.second > budget)
+            {
+                return -1.0;
+            }
+            return delta.second <= 0 ? std::numeric_limits<double>::infinity() : -delta.first / delta.second;
+        };
+        auto can_boost = [&](const size_t node) {
+            return state.num_somersloop[node] < model.nodes[node].max_somersloop && state.full.machines[node] > epsilon;
+        };
+
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            if (can_boost(i))
+            {
+                batch.push_back(i);
+            }
+        }
+        evaluate_batch();
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            if (const double r = ratio(deltas[i]); r > 0.0)
+            {
+                candidates.emplace(r, batch[i]);
+            }
+        }
+
+        const size_t batch_size = 2 * std::max(1u, std::thread::hardware_concurrency());
+        while (!candidates.empty())
+        {
+            batch.clear();
+            while (!candidates.empty() && batch.size() < batch_size)
+            {
+                if (can_boost(candidates.top().second))
+                {
+                    batch.push_back(candidates.top().second);
+                }
+                candidates.pop();
+            }
+            evaluate_batch();
+
+            size_t best = no_node;
+            double best_ratio = 0.0;
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+                if (const double r = ratio(deltas[i]); r > best_ratio)
+                {
+                    best = i;
+                    best_ratio = r;
+                }
+            }
+            // Up to date candidates go back in the queue, the ones not worth it anymore are dropped
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+                if (const double r = ratio(deltas[i]); r > 0.0 && i != best)
+                {
+                    candidates.emplace(r, batch[i]);
+                }
+            }
+            if (best == no_node)
+            {
+                continue;
+            }
+            // Better than the stale bound of all the others
+            if (candidates.empty() || best_ratio >= candidates.top().first)
+            {
+                const size_t node = batch[best];
+                apply(Move{ no_node, node, 1 });
+                if (can_boost(node))
+                {
+                    // Its next level gain is unknown, force its evaluation in the next batch
+                    candidates.emplace(std::numeric_limits<double>::infinity(), node);
+                }
+            }
+            else
+            {
+                candidates.emplace(best_ratio, batch[best]);
+            }
+        }
+
+        // Greedy can leave some budget unused when the remaining somersloops are not enough for a full
+        // level of any node. Improve with moves of one somersloop level from a node to one or more levels
+        // of another, which is only affordable for small to medium factories
+        std::vector<Move> moves;
+        std::vector<std::pair<double, int>> move_deltas;
+        for (size_t pass = 0; pass < max_local_search_passes; ++pass)
+        {
+            moves.clear();
+            for (size_t added = 0; added < tasks.size(); ++added)
+            {
+                if (!can_boost(added))
+                {
+                    continue;
+                }
+                for (int levels = 1; state.num_somersloop[added] + levels <= model.nodes[added].max_somersloop; ++levels)
+                {
+                    moves.push_back(Move{ no_node, added, levels });
+                    for (size_t removed = 0; removed < tasks.size(); ++removed)
+                    {
+                        if (removed != added && state.num_somersloop[removed] > 0)
+                        {
+                            moves.push_back(Move{ removed, added, levels });
+                        }
+                    }
+                }
+            }
+            if (moves.empty() || moves.size() > max_move_evaluations)
+            {
+                break;
+            }
+
+            evaluate(moves, move_deltas);
+
+            size_t best = no_node;
+            for (size_t i = 0; i < moves.size(); ++i)
+            {
+                if (state.used + move_deltas[i].second <= budget && move_deltas[i].first < -epsilon &&
+                    (best == no_node || move_deltas[i].first < move_deltas[best].first))
+                {
+                    best = i;
+                }
+            }
+            if (best == no_node)
+            {
+                break;
+            }
+            apply(moves[best]);
+        }
+
+        result.num_somersloop = state.num_somersloop;
+        result.rates = state.full.machines;
+        result.used = state.used;
+        result.score_after = state.Score();
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            result.power_after += NodePower(model.nodes[i], state.full.machines[i], state.num_somersloop[i]);
+        }
+        return result;
+    }
+}
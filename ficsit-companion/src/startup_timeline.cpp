@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#include "startup_timeline.hpp"
+
+namespace StartupTimeline
+{
+    namespace
+    {
+        struct Event
+        {
+            const char* name;
+            /// @brief Microseconds since launch
+            long long int start;
+            long long int duration;
+            /// @brief Small thread index, 0 for the first thread recording something (main thread)
+            int thread;
+            /// @brief Number of timers of the same thread containing this one
+            int depth;
+        };
+
+        constexpr std::array<const char*, static_cast<size_t>(Counter::Count)> counter_names = {
+            "Files read",
+            "Bytes read",
+            "Json bytes parsed",
+            "Icons decoded",
+            "Textures uploaded",
+            "Texture bytes"
+        };
+
+        /// @brief Static initialization time, as close to the launch as we can get
+        const std::chrono::steady_clock::time_point launch = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point end;
+        std::atomic<bool> finished = false;
+
+        std::mutex mutex;
+        std::vector<Event> events;
+        std::array<std::atomic<size_t>, static_cast<size_t>(Counter::Count)> counters = {};
+
+        std::atomic<int> num_threads = 0;
+        thread_local int thread_index = -1;
+        thread_local int thread_depth = 0;
+
+        long long int Microseconds(const std::chrono::steady_clock::time_point t)
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(t - launch).count();
+        }
+    }
+
+    ScopedTimer::ScopedTimer(const char* name) : name(name), start(std::chrono::steady_clock::now()), stopped(false)
+    {
+        thread_depth += 1;
+    }
+
+    ScopedTimer::~ScopedTimer()
+    {
+        Stop();
+    }
+
+    void ScopedTimer::Stop()
+    {
+        if (stopped)
+        {
+            return;
+        }
+        stopped = true;
+        thread_depth -= 1;
+        if (finished)
+        {
+            return;
+        }
+        if (thread_index == -1)
+        {
+            thread_index = num_threads++;
+        }
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(mutex);
+        events.push_back({ name, Microseconds(start), Microseconds(now) - Microseconds(start), thread_index, thread_depth });
+    }
+
+    void Add(const Counter counter, const size_t value)
+    {
+        if (!finished)
+        {
+            counters[static_cast<size_t>(counter)] += value;
+        }
+    }
+
+    void Set(const Counter counter, const size_t value)
+    {
+        if (!finished)
+        {
+            counters[static_cast<size_t>(counter)] = value;
+        }
+    }
+
+    void Finish()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!finished)
+        {
+            end = std::chrono::steady_clock::now();
+            finished = true;
+        }
+    }
+
+    bool IsFinished()
+    {
+        return finished;
+    }
+
+    double TotalMilliseconds()
+    {
+        return Microseconds(finished ? end : std::chrono::steady_clock::now()) / 1000.0;
+    }
+
+    std::string Report()
+    {
+        std::vector<Event> sorted;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            sorted = events;
+        }
+        // Parents end after their children but should be displayed first
+        std::stable_sort(sorted.begin(), sorted.end(), [](const Event& a, const Event& b) {
+            if (a.thread != b.thread)
+            {
+                return a.thread < b.thread;
+            }
+            return a.start != b.start ? a.start < b.start : a.depth < b.depth;
+        });
+
+        char line[256];
+        std::snprintf(line, sizeof(line), "Startup timeline (%.2f ms)\n", TotalMilliseconds());
+        std::string report = line;
+        for (const Event& e : sorted)
+        {
+            std::snprintf(line, sizeof(line), "%9.2f ms %9.2f ms  %*s%s%s\n",
+                e.start / 1000.0, e.duration / 1000.0,
+                2 * e.depth, "", e.name,
+                e.thread == 0 ? "" : (" (thread " + std::to_string(e.thread) + ")").c_str());
+            report += line;
+        }
+        for (size_t i = 0; i < counters.size(); ++i)
+        {
+            std::snprintf(line, sizeof(line), "%s: %zu\n", counter_names[i], counters[i].load());
+            report += line;
+        }
+        return report;
+    }
+
+    Json::Value ChromeTrace()
+    {
+        Json::Array trace_events;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            trace_events.reserve(events.size() + 1);
+            for (const Event& e : events)
+            {
+                trace_events.push_back({
+                    { "name", e.name },
+                    { "ph", "X" },
+                    { "ts", e.start },
+                    { "dur", e.duration },
+                    { "pid", 1 },
+                    { "tid", e.thread }
+                });
+            }
+        }
+
+        // All counters as one counter event at the end of the startup
+        Json::Value args = Json::Object();
+        for (size_t i = 0; i < counters.size(); ++i)
+        {
+            args[counter_names[i]] = static_cast<long long int>(counters[i].load());
+        }
+        trace_events.push_back({
+            { "name", "Startup counters" },
+            { "ph", "C" },
+            { "ts", Microseconds(finished ? end : std::chrono::steady_clock::now()) },
+            { "pid", 1 },
+            { "args", args }
+        });
+
+        Json::Value trace;
+        trace["traceEvents"] = std::move(trace_events);
+        trace["displayTimeUnit"] = "ms";
+        return trace;
+    }
+}
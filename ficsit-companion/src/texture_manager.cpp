@@ -0,0 +1,698 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#if !defined(__EMSCRIPTEN__)
+#include <condition_variable>
+#include <thread>
+#endif
+#include <unordered_map>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <imgui.h>
+
+#if defined(IMGUI_IMPL_OPENGL_ES2)
+#include <SDL_opengles2.h>
+#else
+#include <SDL_opengl.h>
+#endif
+
+#include "startup_timeline.hpp"
+#include "texture_manager.hpp"
+
+namespace
+{
+    /// @brief Size of the square atlas textures
+    constexpr int atlas_size = 1024;
+    /// @brief Size icons are resampled to in the atlas
+    constexpr int icon_size = 64;
+    /// @brief Each icon is surrounded by a copy of its border pixels so linear filtering doesn't bleed into neighbours
+    constexpr int cell_size = icon_size + 2;
+    constexpr int cells_per_row = atlas_size / cell_size;
+    constexpr int cells_per_atlas = cells_per_row * cells_per_row;
+
+    /// @brief Must match FORMAT_VERSION in scripts/generate_icon_pack.py
+    constexpr uint32_t icon_pack_format_version = 1;
+
+    /// @brief Fill a cell with the placeholder: a magenta/black checkerboard displayed while an icon is loading or if it can't be loaded
+    /// @param pixels RGBA data of an image
+    /// @param stride Width of the image in pixels
+    /// @param x Left of the cell in the image
+    /// @param y Top of the cell in the image
+    void FillDefaultIcon(std::vector<unsigned char>& pixels, const size_t stride, const size_t x, const size_t y)
+    {
+        for (size_t row = 0; row < cell_size; ++row)
+        {
+            for (size_t col = 0; col < cell_size; ++col)
+            {
+                const size_t pixel_index = ((y + row) * stride + x + col) * 4;
+                // If top left or bottom right corner, set RGB to magenta
+                const bool magenta = (row < cell_size / 2) == (col < cell_size / 2);
+                pixels[pixel_index + 0] = magenta ? 255 : 0;
+                pixels[pixel_index + 1] = 0;
+                pixels[pixel_index + 2] = magenta ? 255 : 0;
+                // Set alpha to 255
+                pixels[pixel_index + 3] = 255;
+            }
+        }
+    }
+
+    /// @brief Pixels of an atlas with all its cells set to the placeholder
+    std::vector<unsigned char> DefaultAtlasPixels()
+    {
+        std::vector<unsigned char> texture_data(4 * atlas_size * atlas_size, 0);
+        for (int cell = 0; cell < cells_per_atlas; ++cell)
+        {
+            FillDefaultIcon(texture_data, atlas_size, (cell % cells_per_row) * cell_size, (cell / cells_per_row) * cell_size);
+        }
+        return texture_data;
+    }
+
+    /// @brief Create an atlas texture
+    /// @param texture_data RGBA data of the whole atlas
+    /// @return OpenGL id of the texture
+    GLuint CreateAtlas(const std::vector<unsigned char>& texture_data)
+    {
+        // Create OpenGL texture
+        GLuint image_index;
+        glGenTextures(1, &image_index);
+        glBindTexture(GL_TEXTURE_2D, image_index);
+
+        // Setup filtering
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // This is required on WebGL for non power-of-two textures
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE); // Same
+
+        // Upload pixels to texture
+#if defined(GL_UNPACK_ROW_LENGTH) && !defined(__EMSCRIPTEN__)
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#endif
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, atlas_size, atlas_size, 0, GL_RGBA, GL_UNSIGNED_BYTE, texture_data.data());
+
+        return image_index;
+    }
+
+    /// @brief Resample an image to a padded icon_size x icon_size cell, averaging all the source pixels covered by each destination pixel
+    /// @param image RGBA data of the image
+    /// @param width Width of the image
+    /// @param height Height of the image
+    /// @return RGBA data of the cell_size x cell_size cell
+    std::vector<unsigned char> ResampleIcon(const unsigned char* image, const int width, const int height)
+    {
+        std::vector<unsigned char> cell(4 * cell_size * cell_size);
+        if (width == icon_size && height == icon_size)
+        {
+            for (int row = 0; row < icon_size; ++row)
+            {
+                std::copy_n(image + row * icon_size * 4, icon_size * 4, cell.begin() + ((row + 1) * cell_size + 1) * 4);
+            }
+        }
+        else
+        {
+            for (int row = 0; row < icon_size; ++row)
+            {
+                const int src_row_begin = row * height / icon_size;
+                const int src_row_end = std::max(src_row_begin + 1, (row + 1) * height / icon_size);
+                for (int col = 0; col < icon_size; ++col)
+                {
+                    const int src_col_begin = col * width / icon_size;
+                    const int src_col_end = std::max(src_col_begin + 1, (col + 1) * width / icon_size);
+                    std::array<unsigned int, 4> sum = { 0, 0, 0, 0 };
+                    for (int src_row = src_row_begin; src_row < src_row_end; ++src_row)
+                    {
+                        for (int src_col = src_col_begin; src_col < src_col_end; ++src_col)
+                        {
+                            for (int c = 0; c < 4; ++c)
+                            {
+                                sum[c] += image[(src_row * width + src_col) * 4 + c];
+                            }
+                        }
+                    }
+                    const unsigned int count = (src_row_end - src_row_begin) * (src_col_end - src_col_begin);
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        cell[((row + 1) * cell_size + col + 1) * 4 + c] = static_cast<unsigned char>(sum[c] / count);
+                    }
+                }
+            }
+        }
+
+        // Copy border pixels in the padding
+        for (int i = 0; i < cell_size; ++i)
+        {
+            const int inner = std::clamp(i, 1, icon_size);
+            std::copy_n(cell.begin() + (1 * cell_size + inner) * 4, 4, cell.begin() + (0 * cell_size + i) * 4);
+            std::copy_n(cell.begin() + (icon_size * cell_size + inner) * 4, 4, cell.begin() + ((cell_size - 1) * cell_size + i) * 4);
+            std::copy_n(cell.begin() + (inner * cell_size + 1) * 4, 4, cell.begin() + (i * cell_size + 0) * 4);
+            std::copy_n(cell.begin() + (inner * cell_size + icon_size) * 4, 4, cell.begin() + (i * cell_size + cell_size - 1) * 4);
+        }
+
+        return cell;
+    }
+
+    /// @brief GPU memory used by one atlas
+    constexpr size_t atlas_bytes = 4 * atlas_size * atlas_size;
+
+    /// @brief Own all the icons atlases. Images get a cell in an atlas when they're loaded, and lose it when
+    /// they're not referenced anymore or when the least recently drawn ones are evicted to stay under budget.
+    /// Evicted images are loaded again the next time they're drawn. Files are decoded on worker threads and
+    /// uploaded on the GL thread, icons from the pack generated at build time are uploaded directly
+    class TextureManager
+    {
+    public:
+        /// @param icon_pack Path of the icon pack generated at build time, its icons are available without decoding
+        TextureManager(const std::string& icon_pack)
+        {
+            FillDefaultIcon(placeholder, cell_size, 0, 0);
+            try
+            {
+                LoadIconPack(icon_pack);
+            }
+            catch (const std::exception&)
+            {
+                // Unvalid pack, use png files instead
+                pack.clear();
+            }
+        }
+
+        TextureHandle Acquire(const std::string& path)
+        {
+            auto it = handles.find(path);
+            const TextureHandle texture = it != handles.end() ? it->second : AddEntry(path, std::nullopt);
+            Entry& entry = entries[texture];
+            entry.references += 1;
+            // Start loading it if there is room, so it's (probably) ready when it's first displayed
+            if (!entry.cell.has_value())
+            {
+                if (std::optional<Cell> cell = AllocateCell(false))
+                {
+                    Fill(texture, cell.value());
+                }
+            }
+            return texture;
+        }
+
+        void Release(const TextureHandle texture)
+        {
+            Entry& entry = entries[texture];
+            entry.references -= 1;
+            if (entry.references == 0 && entry.cell.has_value())
+            {
+                FreeCell(entry);
+            }
+        }
+
+        TextureRegion Get(const TextureHandle texture)
+        {
+            Entry& entry = entries[texture];
+            entry.last_used = frame;
+            if (!entry.cell.has_value())
+            {
+                Fill(texture, AllocateCell(true).value());
+            }
+            return GetRegion(entry.cell.value());
+        }
+
+        bool NewFrame(const size_t max_uploads)
+        {
+            frame += 1;
+
+            std::vector<Decoded> ready;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+#if defined(__EMSCRIPTEN__)
+                // No worker threads on the web, decode a few images per frame instead
+                while (!to_decode.empty() && decoded.size() < max_uploads)
+                {
+                    decoded.push_back(Decode(to_decode.front()));
+                    to_decode.pop_front();
+                }
+#endif
+                while (!decoded.empty() && ready.size() < max_uploads)
+                {
+                    ready.push_back(std::move(decoded.front()));
+                    decoded.pop_front();
+                }
+                num_pending -= ready.size();
+            }
+
+            for (const Decoded& d : ready)
+            {
+                const Entry& entry = entries[d.texture];
+                // Images that couldn't be decoded keep the placeholder, and images evicted since the decoding started are dropped
+                if (!d.pixels.empty() && entry.generation == d.generation && entry.cell.has_value())
+                {
+                    Upload(entry.cell.value(), d.pixels);
+                }
+            }
+
+            TrimToBudget();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            return num_pending > 0;
+        }
+
+        void SetBudget(const size_t bytes)
+        {
+            budget = std::max(bytes, atlas_bytes);
+        }
+
+        size_t GetBudget() const
+        {
+            return budget;
+        }
+
+        size_t GetResidentBytes() const
+        {
+            return std::count_if(atlases.begin(), atlases.end(), [](const Atlas& a) { return a.texture != 0; }) * atlas_bytes;
+        }
+
+    private:
+        /// @brief Position of a padded cell in the atlases
+        struct Cell
+        {
+            size_t atlas;
+            int index;
+        };
+
+        struct Atlas
+        {
+            /// @brief 0 if the atlas has been deleted
+            GLuint texture;
+            /// @brief Indices of the cells not used by any image
+            std::vector<int> free_cells;
+        };
+
+        struct Entry
+        {
+            std::string path;
+            size_t references = 0;
+            /// @brief Where the image is, if it's currently on the GPU
+            std::optional<Cell> cell;
+            /// @brief Incremented each time the image gets a cell, to drop decoded pixels meant for a previous one
+            uint64_t generation = 0;
+            /// @brief Last frame the image was drawn
+            uint64_t last_used = 0;
+            /// @brief Position of the pixels in the icon pack, if it's in it
+            std::optional<size_t> pack_offset;
+        };
+
+        /// @brief An image to decode
+        struct Job
+        {
+            TextureHandle texture;
+            uint64_t generation;
+            std::string path;
+        };
+
+        /// @brief Padded cell ready to be uploaded, empty pixels if the image couldn't be decoded
+        struct Decoded
+        {
+            TextureHandle texture;
+            uint64_t generation;
+            std::vector<unsigned char> pixels;
+        };
+
+        TextureHandle AddEntry(const std::string& path, const std::optional<size_t> pack_offset)
+        {
+            const TextureHandle texture = entries.size();
+            entries.emplace_back();
+            entries.back().path = path;
+            entries.back().pack_offset = pack_offset;
+            handles[path] = texture;
+            return texture;
+        }
+
+        /// @brief Read the icon pack and fill the first atlases with all its icons, with one upload per atlas
+        void LoadIconPack(const std::string& path)
+        {
+            StartupTimeline::ScopedTimer timer("Load icon pack");
+            std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+            if (!file.is_open())
+            {
+                return;
+            }
+            pack.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(reinterpret_cast<char*>(pack.data()), pack.size());
+            StartupTimeline::Add(StartupTimeline::Counter::FilesRead, 1);
+            StartupTimeline::Add(StartupTimeline::Counter::BytesRead, pack.size());
+
+            size_t offset = 0;
+            const auto read_u32 = [&]() {
+                if (offset + sizeof(uint32_t) > pack.size())
+                {
+                    throw std::runtime_error("Truncated icon pack");
+                }
+                uint32_t value;
+                std::memcpy(&value, pack.data() + offset, sizeof(uint32_t));
+                offset += sizeof(uint32_t);
+                return value;
+            };
+
+            if (pack.size() < 4 || std::memcmp(pack.data(), "FCIP", 4) != 0)
+            {
+                throw std::runtime_error("Not an icon pack");
+            }
+            offset = 4;
+            if (read_u32() != icon_pack_format_version || read_u32() != icon_size)
+            {
+                throw std::runtime_error("Outdated icon pack");
+            }
+
+            std::vector<std::string> paths(read_u32());
+            for (auto& p : paths)
+            {
+                const uint32_t size = read_u32();
+                if (offset + size > pack.size())
+                {
+                    throw std::runtime_error("Truncated icon pack");
+                }
+                p = std::string(reinterpret_cast<const char*>(pack.data()) + offset, size);
+                offset += size;
+            }
+
+            constexpr size_t icon_bytes = 4 * icon_size * icon_size;
+            if (offset + paths.size() * icon_bytes != pack.size())
+            {
+                throw std::runtime_error("Unvalid icon pack size");
+            }
+
+            std::vector<unsigned char> texture_data;
+            std::vector<TextureHandle> atlas_textures;
+            for (size_t i = 0; i < paths.size(); ++i)
+            {
+                const TextureHandle texture = AddEntry(paths[i], offset + i * icon_bytes);
+                const int index = static_cast<int>(i % cells_per_atlas);
+                if (index == 0)
+                {
+                    texture_data = DefaultAtlasPixels();
+                    atlas_textures.clear();
+                }
+                // Icons are stored with their final size, this only adds the padding
+                const std::vector<unsigned char> pixels = ResampleIcon(pack.data() + entries[texture].pack_offset.value(), icon_size, icon_size);
+                const int x = (index % cells_per_row) * cell_size;
+                const int y = (index / cells_per_row) * cell_size;
+                for (int row = 0; row < cell_size; ++row)
+                {
+                    std::copy_n(pixels.begin() + row * cell_size * 4, cell_size * 4, texture_data.begin() + ((y + row) * atlas_size + x) * 4);
+                }
+                atlas_textures.push_back(texture);
+
+                if (index == cells_per_atlas - 1 || i == paths.size() - 1)
+                {
+                    atlases.push_back(Atlas{ CreateAtlas(texture_data), {} });
+                    StartupTimeline::Add(StartupTimeline::Counter::TexturesUploaded, atlas_textures.size());
+                    for (int c = cells_per_atlas - 1; c >= static_cast<int>(atlas_textures.size()); --c)
+                    {
+                        atlases.back().free_cells.push_back(c);
+                    }
+                    for (size_t c = 0; c < atlas_textures.size(); ++c)
+                    {
+                        entries[atlas_textures[c]].cell = Cell{ atlases.size() - 1, static_cast<int>(c) };
+                        entries[atlas_textures[c]].generation = 1;
+                    }
+                }
+            }
+        }
+
+        /// @brief Find room for an image
+        /// @param allow_eviction If true, the least recently drawn image not drawn this frame can be evicted
+        /// when the budget is reached. If it's false or no image can be evicted, a new atlas is created
+        /// @return The cell, std::nullopt if it needs an eviction and allow_eviction is false
+        std::optional<Cell> AllocateCell(const bool allow_eviction)
+        {
+            for (size_t i = 0; i < atlases.size(); ++i)
+            {
+                if (!atlases[i].free_cells.empty())
+                {
+                    const int index = atlases[i].free_cells.back();
+                    atlases[i].free_cells.pop_back();
+                    return Cell{ i, index };
+                }
+            }
+
+            if (GetResidentBytes() + atlas_bytes > budget && GetResidentBytes() > 0)
+            {
+                if (!allow_eviction)
+                {
+                    return std::nullopt;
+                }
+
+                // Images without reference first, then least recently drawn
+                Entry* evicted = nullptr;
+                for (Entry& e : entries)
+                {
+                    if (e.cell.has_value() && e.last_used < frame &&
+                        (evicted == nullptr || std::make_pair(e.references > 0, e.last_used) < std::make_pair(evicted->references > 0, evicted->last_used)))
+                    {
+                        evicted = &e;
+                    }
+                }
+                if (evicted != nullptr)
+                {
+                    const Cell cell = evicted->cell.value();
+                    evicted->cell.reset();
+                    return cell;
+                }
+            }
+
+            // Everything is used during this frame, go over budget
+            auto it = std::find_if(atlases.begin(), atlases.end(), [](const Atlas& a) { return a.texture == 0; });
+            if (it == atlases.end())
+            {
+                it = atlases.insert(it, Atlas{ 0, {} });
+            }
+            it->texture = CreateAtlas(DefaultAtlasPixels());
+            for (int c = cells_per_atlas - 1; c > 0; --c)
+            {
+                it->free_cells.push_back(c);
+            }
+            return Cell{ static_cast<size_t>(std::distance(atlases.begin(), it)), 0 };
+        }
+
+        /// @brief Give back the cell of an image, deleting its atlas if it's now empty
+        void FreeCell(Entry& entry)
+        {
+            Atlas& atlas = atlases[entry.cell.value().atlas];
+            atlas.free_cells.push_back(entry.cell.value().index);
+            entry.cell.reset();
+            if (atlas.free_cells.size() == cells_per_atlas)
+            {
+                glDeleteTextures(1, &atlas.texture);
+                atlas.texture = 0;
+                atlas.free_cells.clear();
+            }
+        }
+
+        /// @brief Evict images from the most recently created atlases until the budget is respected,
+        /// stopping at the first atlas with an image drawn during the last frame
+        void TrimToBudget()
+        {
+            for (size_t i = atlases.size(); i > 0 && GetResidentBytes() > budget; --i)
+            {
+                if (atlases[i - 1].texture == 0)
+                {
+                    continue;
+                }
+                if (std::any_of(entries.begin(), entries.end(), [&](const Entry& e) { return e.cell.has_value() && e.cell.value().atlas == i - 1 && e.last_used + 1 >= frame; }))
+                {
+                    return;
+                }
+                for (Entry& e : entries)
+                {
+                    if (e.cell.has_value() && e.cell.value().atlas == i - 1)
+                    {
+                        FreeCell(e);
+                    }
+                }
+            }
+        }
+
+        /// @brief Set the cell of an image and start loading it there
+        void Fill(const TextureHandle texture, const Cell& cell)
+        {
+            Entry& entry = entries[texture];
+            entry.cell = cell;
+            entry.generation += 1;
+
+            if (entry.pack_offset.has_value())
+            {
+                Upload(cell, ResampleIcon(pack.data() + entry.pack_offset.value(), icon_size, icon_size));
+                return;
+            }
+
+            // The cell may contain a previous image
+            Upload(cell, placeholder);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                to_decode.push_back(Job{ texture, entry.generation, entry.path });
+                num_pending += 1;
+            }
+#if !defined(__EMSCRIPTEN__)
+            if (workers.empty())
+            {
+                // Keep one hardware thread for the GL thread
+                const size_t num_workers = std::max(2u, std::thread::hardware_concurrency()) - 1;
+                for (size_t i = 0; i < num_workers; ++i)
+                {
+                    workers.emplace_back(&TextureManager::Work, this);
+                }
+            }
+            condition.notify_one();
+#endif
+        }
+
+        void Upload(const Cell& cell, const std::vector<unsigned char>& pixels) const
+        {
+            glBindTexture(GL_TEXTURE_2D, atlases[cell.atlas].texture);
+#if defined(GL_UNPACK_ROW_LENGTH) && !defined(__EMSCRIPTEN__)
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#endif
+            glTexSubImage2D(GL_TEXTURE_2D, 0, (cell.index % cells_per_row) * cell_size, (cell.index / cells_per_row) * cell_size, cell_size, cell_size, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            StartupTimeline::Add(StartupTimeline::Counter::TexturesUploaded, 1);
+        }
+
+        TextureRegion GetRegion(const Cell& cell) const
+        {
+            // Skip the padding
+            const int x = (cell.index % cells_per_row) * cell_size + 1;
+            const int y = (cell.index / cells_per_row) * cell_size + 1;
+            return TextureRegion{
+                atlases[cell.atlas].texture,
+                static_cast<float>(x) / atlas_size,
+                static_cast<float>(y) / atlas_size,
+                static_cast<float>(x + icon_size) / atlas_size,
+                static_cast<float>(y + icon_size) / atlas_size
+            };
+        }
+
+        static Decoded Decode(const Job& job)
+        {
+            Decoded output{ job.texture, job.generation, {} };
+            int width = 0;
+            int height = 0;
+            unsigned char* image = stbi_load(job.path.c_str(), &width, &height, NULL, 4);
+            StartupTimeline::Add(StartupTimeline::Counter::FilesRead, 1);
+            if (image != NULL)
+            {
+                output.pixels = ResampleIcon(image, width, height);
+                stbi_image_free(image);
+                StartupTimeline::Add(StartupTimeline::Counter::IconsDecoded, 1);
+            }
+            return output;
+        }
+
+#if !defined(__EMSCRIPTEN__)
+        void Work()
+        {
+            while (true)
+            {
+                Job job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    condition.wait(lock, [this]() { return !to_decode.empty(); });
+                    job = std::move(to_decode.front());
+                    to_decode.pop_front();
+                }
+
+                Decoded d = Decode(job);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                decoded.push_back(std::move(d));
+            }
+        }
+#endif
+
+    private:
+        // Only accessed from the GL thread
+        std::vector<Atlas> atlases;
+        std::vector<Entry> entries;
+        std::unordered_map<std::string, TextureHandle> handles;
+        /// @brief Content of the icon pack, kept to reload evicted icons
+        std::vector<unsigned char> pack;
+        std::vector<unsigned char> placeholder = std::vector<unsigned char>(4 * cell_size * cell_size);
+        uint64_t frame = 1;
+        size_t budget = 64 * 1024 * 1024;
+
+        // Shared with the worker threads
+        std::mutex mutex;
+        /// @brief Images waiting to be decoded
+        std::deque<Job> to_decode;
+        /// @brief Decoded images waiting to be uploaded on the GL thread
+        std::deque<Decoded> decoded;
+        /// @brief Number of images pushed and not uploaded yet
+        size_t num_pending = 0;
+#if !defined(__EMSCRIPTEN__)
+        std::condition_variable condition;
+        std::vector<std::thread> workers;
+#endif
+    };
+
+    TextureManager& GetTextureManager()
+    {
+        // Never destroyed, App and Data::Unload release all the textures before the GL context is deleted
+        static TextureManager* manager = new TextureManager("icons.fcip");
+        return *manager;
+    }
+}
+
+TextureHandle LoadTextureFromFile(const std::string& path)
+{
+    return GetTextureManager().Acquire(path);
+}
+
+void ReleaseTexture(const TextureHandle texture)
+{
+    if (texture != invalid_texture)
+    {
+        GetTextureManager().Release(texture);
+    }
+}
+
+TextureRegion GetTextureRegion(const TextureHandle texture)
+{
+    if (texture == invalid_texture)
+    {
+        return TextureRegion();
+    }
+    return GetTextureManager().Get(texture);
+}
+
+bool UploadLoadedTextures(const size_t max_uploads)
+{
+    return GetTextureManager().NewFrame(max_uploads);
+}
+
+void SetTextureBudget(const size_t bytes)
+{
+    GetTextureManager().SetBudget(bytes);
+}
+
+size_t GetTextureBudget()
+{
+    return GetTextureManager().GetBudget();
+}
+
+size_t GetTextureResidentBytes()
+{
+    return GetTextureManager().GetResidentBytes();
+}
+
+void RenderIcon(const TextureHandle icon)
+{
+    const TextureRegion region = GetTextureRegion(icon);
+    ImGui::Image((void*)(intptr_t)region.texture_id,
+        ImVec2(ImGui::GetTextLineHeightWithSpacing(), ImGui::GetTextLineHeightWithSpacing()),
+        ImVec2(region.u0, region.v0), ImVec2(region.u1, region.v1)
+    );
+}
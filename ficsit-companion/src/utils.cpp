@@ -1,111 +1,17 @@
 #include <algorithm>
-#include <filesystem>
-#include <map>
-#include <vector>
-
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-
-#if defined(IMGUI_IMPL_OPENGL_ES2)
-#include <SDL_opengles2.h>
-#else
-#include <SDL_opengl.h>
+#if !defined(__EMSCRIPTEN__)
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
 #endif
+#include <vector>
 
+#include "building.hpp"
 #include "recipe.hpp"
 #include "utils.hpp"
 
-unsigned int DefaultTexture()
-{
-    const size_t height = 64;
-    const size_t width = 64;
-    std::vector<unsigned char> texture_data(4 * width * height, 0);
-    for (size_t row = 0; row < height; ++row)
-    {
-        for (size_t col = 0; col < width; ++col)
-        {
-            const size_t pixel_index = (row * width + col) * 4;
-            // Set alpha to 255
-            texture_data[pixel_index + 3] = 255;
-            // If top left or bottom right corner, set RGB to magenta
-            if ((row < height / 2 && col < width / 2) || (row > height / 2 - 1 && col > width / 2 - 1))
-            {
-                texture_data[pixel_index + 0] = 255;
-                texture_data[pixel_index + 2] = 255;
-            }
-        }
-    }
-
-    // Create OpenGL texture
-    GLuint image_index;
-    glGenTextures(1, &image_index);
-    glBindTexture(GL_TEXTURE_2D, image_index);
-
-    // Setup filtering
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // This is required on WebGL for non power-of-two textures
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE); // Same
-
-    // Upload pixels to texture
-#if defined(GL_UNPACK_ROW_LENGTH) && !defined(__EMSCRIPTEN__)
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-#endif
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, texture_data.data());
-
-    return image_index;
-}
-
-unsigned int LoadTextureFromFile(const std::string& path)
-{
-    static unsigned int default_texture = DefaultTexture();
-    static std::map<std::string, unsigned int> cached_textures;
-
-    auto it = cached_textures.find(path);
-    if (it != cached_textures.end())
-    {
-        return it->second;
-    }
-
-    if (!std::filesystem::exists(path))
-    {
-        cached_textures[path] = default_texture;
-        return default_texture;
-    }
-
-    int width = 0;
-    int height = 0;
-    unsigned char* image = stbi_load(path.c_str(), &width, &height, NULL, 4);
-
-    if (image == NULL)
-    {
-        cached_textures[path] = default_texture;
-        return default_texture;
-    }
-
-    // Create OpenGL texture
-    GLuint image_index;
-    glGenTextures(1, &image_index);
-    glBindTexture(GL_TEXTURE_2D, image_index);
-
-    // Setup filtering
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // This is required on WebGL for non power-of-two textures
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE); // Same
-
-    // Upload pixels to texture
-#if defined(GL_UNPACK_ROW_LENGTH) && !defined(__EMSCRIPTEN__)
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-#endif
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-
-    stbi_image_free(image);
-
-    cached_textures[path] = image_index;
-    return image_index;
-}
-
 bool UpdateSave(Json::Value& save, const int to)
 {
     if (save["save_version"].get<int>() == to)
@@ -155,6 +61,177 @@ bool UpdateSave(Json::Value& save, const int to)
     return false;
 }
 
+#if !defined(__EMSCRIPTEN__)
+namespace
+{
+    /// @brief Worker threads kept alive between ParallelFor calls, so loops run at each step of a search
+    /// don't create and join threads every time. The calling thread processes chunks too, so ParallelFor
+    /// can be called from several threads at once or from inside another ParallelFor without deadlock
+    class ThreadPool
+    {
+    public:
+        ThreadPool(const size_t num_workers) : stop(false)
+        {
+            workers.reserve(num_workers);
+            for (size_t i = 0; i < num_workers; ++i)
+            {
+                workers.emplace_back(&ThreadPool::Work, this);
+            }
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+            }
+            job_available.notify_all();
+            for (auto& t : workers)
+            {
+                t.join();
+            }
+        }
+
+        size_t NumThreads() const
+        {
+            return workers.size() + 1;
+        }
+
+        /// @brief Split [0, count[ in num_chunks chunks and wait until they are all processed
+        void Run(const size_t count, const size_t num_chunks, const std::function<void(const size_t begin, const size_t end)>& f)
+        {
+            const size_t chunk_size = (count + num_chunks - 1) / num_chunks;
+            Job job{ &f, count, chunk_size, (count + chunk_size - 1) / chunk_size };
+
+            std::unique_lock<std::mutex> lock(mutex);
+            jobs.push_back(&job);
+            job_available.notify_all();
+
+            size_t chunk;
+            while (Claim(job, chunk))
+            {
+                lock.unlock();
+                std::exception_ptr error = Process(job, chunk);
+                lock.lock();
+                Done(job, error);
+            }
+            // job is on this stack, workers must be done with it before returning, even if a chunk failed
+            job_done.wait(lock, [&job]() { return job.done == job.num_chunks; });
+            if (job.error)
+            {
+                std::rethrow_exception(job.error);
+            }
+        }
+
+    private:
+        struct Job
+        {
+            const std::function<void(const size_t begin, const size_t end)>* f;
+            size_t count;
+            size_t chunk_size;
+            size_t num_chunks;
+            /// @brief Number of chunks given to a thread
+            size_t claimed = 0;
+            /// @brief Number of chunks processed
+            size_t done = 0;
+            /// @brief First exception thrown by f, rethrown by Run on the calling thread
+            std::exception_ptr error;
+        };
+
+        /// @brief Get the next chunk of a job, must be called with the mutex locked
+        /// @return False if all the chunks were already given
+        bool Claim(Job& job, size_t& chunk)
+        {
+            if (job.claimed == job.num_chunks)
+            {
+                return false;
+            }
+            chunk = job.claimed++;
+            // Only jobs with chunks left stay in the queue
+            if (job.claimed == job.num_chunks)
+            {
+                jobs.erase(std::find(jobs.begin(), jobs.end(), &job));
+            }
+            return true;
+        }
+
+        /// @brief Run f on one chunk, must be called with the mutex unlocked
+        /// @return The exception thrown by f if any
+        static std::exception_ptr Process(const Job& job, const size_t chunk)
+        {
+            try
+            {
+                const size_t begin = chunk * job.chunk_size;
+                (*job.f)(begin, std::min(job.count, begin + job.chunk_size));
+            }
+            catch (...)
+            {
+                return std::current_exception();
+            }
+            return nullptr;
+        }
+
+        /// @brief Mark a chunk as processed, must be called with the mutex locked
+        void Done(Job& job, const std::exception_ptr& error)
+        {
+            if (error && !job.error)
+            {
+                job.error = error;
+            }
+            if (++job.done == job.num_chunks)
+            {
+                job_done.notify_all();
+            }
+        }
+
+        void Work()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true)
+            {
+                job_available.wait(lock, [this]() { return stop || !jobs.empty(); });
+                if (stop)
+                {
+                    return;
+                }
+                Job& job = *jobs.front();
+                size_t chunk;
+                Claim(job, chunk);
+                lock.unlock();
+                std::exception_ptr error = Process(job, chunk);
+                lock.lock();
+                Done(job, error);
+            }
+        }
+
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable job_available;
+        std::condition_variable job_done;
+        /// @brief Jobs with chunks not given to a thread yet
+        std::deque<Job*> jobs;
+        bool stop;
+    };
+}
+#endif
+
+void ParallelFor(const size_t count, const std::function<void(const size_t begin, const size_t end)>& f)
+{
+#if defined(__EMSCRIPTEN__)
+    f(0, count);
+#else
+    // Created on first use, one worker per hardware thread besides the calling one
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    const size_t num_chunks = std::min(count, pool.NumThreads());
+    if (num_chunks <= 1)
+    {
+        f(0, count);
+        return;
+    }
+    pool.Run(count, num_chunks, f);
+#endif
+}
+
 bool ItemPtrCompare::operator()(const Item* a, const Item* b) const
 {
     return a != nullptr && (b != nullptr && a->name < b->name);
@@ -164,3 +241,8 @@ bool RecipePtrCompare::operator()(const Recipe* a, const Recipe* b) const
 {
     return a != nullptr && (b != nullptr && a->name < b->name);
 }
+
+bool BuildingPtrCompare::operator()(const Building* a, const Building* b) const
+{
+    return a != nullptr && (b != nullptr && a->name < b->name);
+}
@@ -0,0 +1,92 @@
+// Check that updating the left panel ledger of an unchanged graph doesn't allocate anything
+
+#include "building.hpp"
+#include "ledger.hpp"
+#include "link.hpp"
+#include "node.hpp"
+#include "recipe.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+static size_t num_allocations = 0;
+
+void* operator new(std::size_t size)
+{
+    num_allocations += 1;
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+static bool Check(const bool condition, const char* message)
+{
+    if (!condition)
+    {
+        std::printf("FAILED: %s\n", message);
+    }
+    return condition;
+}
+
+int main()
+{
+    unsigned long long int next_id = 1;
+    const auto id_generator = [&next_id]() { return next_id++; };
+
+    const Item ore("Iron Ore", "", true);
+    const Item ingot("Iron Ingot", "");
+    const Item plate("Iron Plate", "");
+    const Building smelter("Smelter", FractionalNumber(1, 2), 4.0, 1.321928, 2.0, false);
+    const Building constructor("Constructor", FractionalNumber(1, 1), 4.0, 1.321928, 2.0, false);
+    const Recipe ingot_recipe({ CountedItem(&ore, 30) }, { CountedItem(&ingot, 30) }, &smelter, false, 4.0, "Iron Ingot");
+    const Recipe plate_recipe({ CountedItem(&ingot, 30) }, { CountedItem(&plate, 20) }, &constructor, false, 4.0, "Iron Plate");
+
+    std::vector<std::unique_ptr<Node>> nodes;
+    nodes.push_back(std::make_unique<CraftNode>(id_generator(), &ingot_recipe, id_generator));
+    nodes.push_back(std::make_unique<CraftNode>(id_generator(), &plate_recipe, id_generator));
+    static_cast<CraftNode*>(nodes[0].get())->UpdateRate(FractionalNumber(5, 2));
+    static_cast<CraftNode*>(nodes[1].get())->UpdateRate(FractionalNumber(5, 2));
+    // A group with one more plate machine to also go through the group stats
+    {
+        std::vector<std::unique_ptr<Node>> group_nodes;
+        group_nodes.push_back(std::make_unique<CraftNode>(id_generator(), &plate_recipe, id_generator));
+        static_cast<CraftNode*>(group_nodes[0].get())->UpdateRate(FractionalNumber(1, 2));
+        nodes.push_back(std::make_unique<GroupNode>(id_generator(), id_generator, std::move(group_nodes), std::vector<std::unique_ptr<Link>>()));
+    }
+
+    Ledger ledger;
+    // First pass creates all the entries
+    ledger.Update(nodes, false);
+
+    num_allocations = 0;
+    ledger.Update(nodes, false);
+    const size_t second_pass_allocations = num_allocations;
+
+    bool success = true;
+    success &= Check(second_pass_allocations == 0, "ledger update of an unchanged graph allocated memory");
+    success &= Check(ledger.items.at(&ore).input == FractionalNumber(75), "wrong iron ore input");
+    success &= Check(ledger.items.at(&ingot).input == FractionalNumber(15), "wrong iron ingot input");
+    success &= Check(ledger.items.at(&ingot).intermediate == FractionalNumber(75), "wrong iron ingot intermediate");
+    success &= Check(ledger.items.at(&plate).output == FractionalNumber(60), "wrong iron plate output");
+    success &= Check(ledger.machines.at(&constructor).total.value == FractionalNumber(3), "wrong constructor count");
+    success &= Check(ledger.sorted_detailed_power.size() == 2, "wrong number of detailed power entries");
+
+    if (success)
+    {
+        std::printf("OK\n");
+    }
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -77,7 +77,8 @@ items = {
     c["ClassName"]: {
         "name": c["mDisplayName"],
         "icon": c["mSmallIcon"],
-        "state": c["mForm"]
+        "state": c["mForm"],
+        "resource": "FGResourceDescriptor" in c["NativeClass"],
     } for c in get_classes(data, ITEMS)
 }
 
@@ -155,7 +156,7 @@ with open("satisfactory.json", "w") as out_file:
     json.dump({
         "version": "",
         "buildings": list(buildings.values()),
-        "items": [ { "name": v["name"], "icon": v["icon"] } for v in items.values() if not v in removed],
+        "items": [ { "name": v["name"], "icon": v["icon"], **({ "resource": True } if v["resource"] else {}) } for v in items.values() if not v in removed],
         "recipes": list(recipes.values())
     }, out_file, indent=4, ensure_ascii=False)
 
@@ -0,0 +1,74 @@
+import json, struct, sys
+
+from decimal import Decimal
+from fractions import Fraction
+
+# Must match Data::DATABASE_FORMAT_VERSION in game_data.cpp
+FORMAT_VERSION = 1
+
+# Layout (little endian):
+# "FCDB" | u32 format version | u64 size of the source json | u64 FNV-1a hash of the source json | string version
+# u32 num buildings | (string name, i64 somersloop mult numerator, i64 denominator, f64 power, f64 power exponent, f64 somersloop power exponent, u8 variable power)*
+# u32 num items | (string name, string icon, u8 resource)*
+# u32 num recipes | (string name, u32 building index, u8 alternate, u8 spoiler, f64 power, u32 num inputs, (u32 item index, i64 numerator, i64 denominator)*, u32 num outputs, (...)*)*
+# Strings are a u32 size followed by the utf-8 bytes. Recipes amounts are exact items/min
+
+def fnv1a(data: bytes) -> int:
+    h = 0xcbf29ce484222325
+    for b in data:
+        h = ((h ^ b) * 0x100000001b3) & 0xffffffffffffffff
+    return h
+
+def write_string(out: bytearray, s: str):
+    encoded = s.encode("utf-8")
+    out += struct.pack("<I", len(encoded))
+    out += encoded
+
+def write_fraction(out: bytearray, f: Fraction):
+    out += struct.pack("<qq", f.numerator, f.denominator)
+
+if len(sys.argv) != 3:
+    print(f"Usage: {sys.argv[0]} game.json game.fcdb")
+    sys.exit(1)
+
+with open(sys.argv[1], "rb") as f:
+    raw = f.read()
+
+# Keep decimal literals as is to get exact fractions
+data = json.loads(raw.decode("utf-8"), parse_float=Decimal)
+
+out = bytearray(b"FCDB")
+out += struct.pack("<IQQ", FORMAT_VERSION, len(raw), fnv1a(raw))
+write_string(out, data["version"])
+
+building_indices = {}
+out += struct.pack("<I", len(data["buildings"]))
+for i, b in enumerate(data["buildings"]):
+    building_indices[b["name"]] = i
+    write_string(out, b["name"])
+    write_fraction(out, Fraction(b["somersloop_mult"]))
+    out += struct.pack("<ddd?", float(b["power"]), float(b["power_exponent"]), float(b["somersloop_power_exponent"]), b["variable_power"])
+
+item_indices = {}
+out += struct.pack("<I", len(data["items"]))
+for i, item in enumerate(data["items"]):
+    item_indices[item["name"]] = i
+    write_string(out, item["name"])
+    write_string(out, item["icon"])
+    out += struct.pack("<?", item.get("resource", False))
+
+out += struct.pack("<I", len(data["recipes"]))
+for r in data["recipes"]:
+    write_string(out, r["name"])
+    # Same value as the double computation done when loading the json
+    power = float(r["power_constant"]) + 0.5 * float(r["power_range"]) if "power_constant" in r and "power_range" in r else float(data["buildings"][building_indices[r["building"]]]["power"])
+    out += struct.pack("<I??d", building_indices[r["building"]], r["alternate"], r.get("spoiler", False), power)
+    time = Fraction(r["time"])
+    for key in ["inputs", "outputs"]:
+        out += struct.pack("<I", len(r[key]))
+        for i in r[key]:
+            out += struct.pack("<I", item_indices[i["name"]])
+            write_fraction(out, Fraction(i["amount"]) * 60 / time)
+
+with open(sys.argv[2], "wb") as f:
+    f.write(out)
@@ -0,0 +1,122 @@
+import glob, os, struct, sys, zlib
+
+# Must match the values in texture_manager.cpp
+FORMAT_VERSION = 1
+ICON_SIZE = 64
+
+# Layout (little endian):
+# "FCIP" | u32 format version | u32 icon size | u32 num icons | (string path)* | (icon size * icon size RGBA pixels)*
+# Strings are a u32 size followed by the utf-8 bytes. Paths are relative to the assets folder, as written in the json data file
+# Icons are resampled with the same box filter as the one used when loading png files in the app
+
+def paeth(a: int, b: int, c: int) -> int:
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+def decode_png(path: str):
+    """Decode a non interlaced 8 bits png file to RGBA, return None for other formats"""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        return None
+
+    index = 8
+    idat = bytearray()
+    while index < len(data):
+        length, chunk_type = struct.unpack(">I4s", data[index:index + 8])
+        content = data[index + 8:index + 8 + length]
+        if chunk_type == b"IHDR":
+            width, height, bit_depth, color_type, _, _, interlace = struct.unpack(">IIBBBBB", content)
+        elif chunk_type == b"IDAT":
+            idat += content
+        elif chunk_type == b"IEND":
+            break
+        index += 12 + length
+
+    channels = {0: 1, 2: 3, 4: 2, 6: 4}.get(color_type)
+    if bit_depth != 8 or interlace != 0 or channels is None:
+        return None
+
+    raw = zlib.decompress(bytes(idat))
+    stride = width * channels
+    pixels = bytearray(stride * height)
+    previous = bytearray(stride)
+    for row in range(height):
+        filter_type = raw[row * (stride + 1)]
+        line = bytearray(raw[row * (stride + 1) + 1:(row + 1) * (stride + 1)])
+        if filter_type == 1:
+            for i in range(channels, stride):
+                line[i] = (line[i] + line[i - channels]) & 0xff
+        elif filter_type == 2:
+            line = bytearray((x + y) & 0xff for x, y in zip(line, previous))
+        elif filter_type == 3:
+            for i in range(stride):
+                left = line[i - channels] if i >= channels else 0
+                line[i] = (line[i] + ((left + previous[i]) >> 1)) & 0xff
+        elif filter_type == 4:
+            for i in range(stride):
+                left = line[i - channels] if i >= channels else 0
+                up_left = previous[i - channels] if i >= channels else 0
+                line[i] = (line[i] + paeth(left, previous[i], up_left)) & 0xff
+        pixels[row * stride:(row + 1) * stride] = line
+        previous = line
+
+    if channels == 4:
+        return width, height, pixels
+    rgba = bytearray(width * height * 4)
+    for i in range(width * height):
+        p = pixels[i * channels:(i + 1) * channels]
+        if channels == 1:
+            rgba[i * 4:(i + 1) * 4] = bytes((p[0], p[0], p[0], 255))
+        elif channels == 2:
+            rgba[i * 4:(i + 1) * 4] = bytes((p[0], p[0], p[0], p[1]))
+        else:
+            rgba[i * 4:(i + 1) * 4] = bytes((p[0], p[1], p[2], 255))
+    return width, height, rgba
+
+def resample(width: int, height: int, pixels: bytearray) -> bytes:
+    """Average all the source pixels covered by each destination pixel, same as ResampleIcon in texture_manager.cpp"""
+    if width == ICON_SIZE and height == ICON_SIZE:
+        return bytes(pixels)
+    output = bytearray(ICON_SIZE * ICON_SIZE * 4)
+    for row in range(ICON_SIZE):
+        row_begin = row * height // ICON_SIZE
+        row_end = max(row_begin + 1, (row + 1) * height // ICON_SIZE)
+        for col in range(ICON_SIZE):
+            col_begin = col * width // ICON_SIZE
+            col_end = max(col_begin + 1, (col + 1) * width // ICON_SIZE)
+            count = (row_end - row_begin) * (col_end - col_begin)
+            for c in range(4):
+                total = sum(pixels[(r * width + x) * 4 + c] for r in range(row_begin, row_end) for x in range(col_begin, col_end))
+                output[(row * ICON_SIZE + col) * 4 + c] = total // count
+    return bytes(output)
+
+if len(sys.argv) != 3:
+    print(f"Usage: {sys.argv[0]} assets_folder icons.fcip")
+    sys.exit(1)
+
+paths = []
+icons = []
+for path in sorted(glob.glob(os.path.join(sys.argv[1], "icons", "*.png"))):
+    decoded = decode_png(path)
+    # Unsupported files are not packed, the app loads them from the png file instead
+    if decoded is None:
+        print(f"Skipping {path}, unsupported png format")
+        continue
+    paths.append("icons/" + os.path.basename(path))
+    icons.append(resample(*decoded))
+
+out = bytearray(b"FCIP")
+out += struct.pack("<III", FORMAT_VERSION, ICON_SIZE, len(paths))
+for path in paths:
+    encoded = path.encode("utf-8")
+    out += struct.pack("<I", len(encoded))
+    out += encoded
+for icon in icons:
+    out += icon
+
+with open(sys.argv[2], "wb") as f:
+    f.write(out)